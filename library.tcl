@@ -79,7 +79,7 @@ proc draw_nodes { { top_bot -top } } {
 	foreach cell [ get_cells $top_bot ] {
 		foreach pin [ get_pins -of $cell ] {
 			set n [ get_nets -of $pin ]
-			set allnearpins [ lrange [ get_pins -of $n -ref $pin -not $pin -notof $cell -filter { [ distance $r $_ ] < 200 } -sort { [ distance $a $r ] < [ distance $b $r ] }] 0 0 ]
+			set allnearpins [ get_pins -of $n -ref $pin -not $pin -notof $cell -filter { [ distance $r $_ ] < 200 } -sort { [ distance $a $r ] < [ distance $b $r ] } -first 1 ]
 			if { $n == "+VCCIOP_LX" } {
 				#puts "$allnearpins $pin $cell"
 			}
@@ -95,7 +95,7 @@ proc draw_nodes { { top_bot -top } } {
 				}
 			}
 			continue
-			set alldistpins [ lrange [ get_pins -of $n -ref $pin -filter { [ distance $r $_] >= 200 } ] 0 10 ]
+			set alldistpins [ get_pins -of $n -ref $pin -filter { [ distance $r $_] >= 200 } -first 11 ]
 			foreach pp $alldistpins {
 				if { [ llength [ get_cells $top_bot -of $pp -not $cell ] ] > 0 } {
 					add_node -stub $pin $pp $n
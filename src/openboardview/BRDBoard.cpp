@@ -259,10 +259,6 @@ BRDBoard::~BRDBoard() {
 	}
 }
 
-SharedVector<Node> &BRDBoard::Nodes() {
-	return nodes_;
-}
-
 SharedVector<Component> &BRDBoard::Components() {
 	return components_;
 }
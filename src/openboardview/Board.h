@@ -137,6 +137,7 @@ struct BoardElement {
 	virtual ~BoardElement() { }
 	
 	void * tcl_priv = nullptr;
+	int style_index_ = -1; // into the BoardView style buffers
 };
 
 // A point/position on the board relative to top left corner of the board.
@@ -313,7 +314,6 @@ class Board {
 
 	virtual ~Board() {}
 
-	virtual SharedVector<Node> &Nodes()           = 0;
 	virtual SharedVector<Net> &Nets()             = 0;
 	virtual SharedVector<Component> &Components() = 0;
 	virtual SharedVector<Pin> &Pins()             = 0;
@@ -0,0 +1,93 @@
+#include "BoardLayers.h"
+
+#include <cstring>
+
+void RetainedLayer::Begin(ImDrawList *scratch, int channels) {
+	scratch->_ResetForNewFrame();
+	scratch->PushClipRectFullScreen();
+	scratch->PushTextureID(ImGui::GetIO().Fonts->TexID);
+	scratch->ChannelsSplit(channels);
+}
+
+void RetainedLayer::End(ImDrawList *scratch) {
+	int channels = scratch->_Splitter._Count;
+
+	m_vtx.resize(scratch->VtxBuffer.Size);
+	if (m_vtx.Size) memcpy(m_vtx.Data, scratch->VtxBuffer.Data, m_vtx.Size * sizeof(ImDrawVert));
+
+	/*
+	 * All channels share the vertex buffer, only the index buffers are
+	 * split.  Making a channel current swaps its indices into IdxBuffer,
+	 * which is the one way of getting at them through the public API.
+	 */
+	m_idx.resize(0);
+	m_channel_start.resize(channels + 1);
+	for (int c = 0; c < channels; c++) {
+		scratch->ChannelsSetCurrent(c);
+		m_channel_start[c] = m_idx.Size;
+
+		int n = scratch->IdxBuffer.Size;
+		if (n) {
+			m_idx.resize(m_idx.Size + n);
+			memcpy(m_idx.Data + m_idx.Size - n, scratch->IdxBuffer.Data, n * sizeof(ImDrawIdx));
+		}
+	}
+	m_channel_start[channels] = m_idx.Size;
+
+	scratch->ChannelsMerge();
+}
+
+void ComposeLayers(ImDrawList *draw, RetainedLayer *const *layers, const LayerTransform *xf, int count) {
+	int vtx_total = 0, idx_total = 0, channels = 0;
+	ImDrawIdx base[NUM_BOARD_LAYERS];
+
+	IM_ASSERT(count <= NUM_BOARD_LAYERS);
+
+	for (int i = 0; i < count; i++) {
+		vtx_total += layers[i]->VtxCount();
+		idx_total += layers[i]->IdxCount();
+		if (layers[i]->m_channel_start.Size - 1 > channels) channels = layers[i]->m_channel_start.Size - 1;
+	}
+	if (!idx_total) return;
+
+	draw->PrimReserve(idx_total, vtx_total);
+
+	ImDrawIdx vtx_current = draw->_VtxCurrentIdx;
+	for (int i = 0; i < count; i++) {
+		int n = layers[i]->VtxCount();
+
+		base[i] = vtx_current;
+		if (xf[i].scale == 1.0f && xf[i].offset.x == 0.0f && xf[i].offset.y == 0.0f) {
+			if (n) memcpy(draw->_VtxWritePtr, layers[i]->m_vtx.Data, n * sizeof(ImDrawVert));
+		} else {
+			const ImDrawVert *src = layers[i]->m_vtx.Data;
+			ImDrawVert *dst       = draw->_VtxWritePtr;
+			float k               = xf[i].scale;
+			ImVec2 b              = xf[i].offset;
+
+			for (int v = 0; v < n; v++) {
+				dst[v]       = src[v];
+				dst[v].pos.x = src[v].pos.x * k + b.x;
+				dst[v].pos.y = src[v].pos.y * k + b.y;
+			}
+		}
+		draw->_VtxWritePtr += n;
+		vtx_current += n;
+	}
+
+	for (int c = 0; c < channels; c++) {
+		for (int i = 0; i < count; i++) {
+			auto &cs = layers[i]->m_channel_start;
+			if (c + 1 >= cs.Size) continue;
+
+			const ImDrawIdx *src = layers[i]->m_idx.Data + cs[c];
+			const ImDrawIdx *end = layers[i]->m_idx.Data + cs[c + 1];
+			ImDrawIdx *dst       = draw->_IdxWritePtr;
+			ImDrawIdx b          = base[i];
+
+			while (src < end) *dst++ = *src++ + b;
+			draw->_IdxWritePtr = dst;
+		}
+	}
+	draw->_VtxCurrentIdx = vtx_current;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <cstdint>
+
+/*
+ * Retained board geometry.
+ *
+ * Each layer keeps the vertices and indices its draw calls produced the
+ * last time it was recorded, with the indices split up per draw channel,
+ * so that putting the layers back together gives exactly the z-order the
+ * single channel-split ImDrawList used to give (fill under outlines under
+ * pins under text under annotations).  A layer only gets re-recorded when
+ * it has been invalidated; the rest of the time composing it into the
+ * window draw list is a memcpy() of its vertices plus an index rebase.
+ *
+ * Pans and zooms don't need a layer to be re-recorded: the view change is
+ * a uniform scale plus a translation of what was recorded, applied to the
+ * vertices while composing (see LayerTransform).
+ *
+ * Only untextured geometry and text can be retained (everything shares the
+ * font atlas texture), anything drawing images has to go straight into the
+ * window draw list.
+ */
+enum BoardLayer {
+	kLayerBoard = 0, // board fill and outline
+	kLayerParts,
+	kLayerPins,
+	kLayerOverlay, // Tcl nodes, hover outlines and halos
+	kLayerAnnotations,
+	NUM_BOARD_LAYERS
+};
+
+enum BoardLayerMask : uint32_t {
+	kLayerMaskBoard       = 1u << kLayerBoard,
+	kLayerMaskParts       = 1u << kLayerParts,
+	kLayerMaskPins        = 1u << kLayerPins,
+	kLayerMaskOverlay     = 1u << kLayerOverlay,
+	kLayerMaskAnnotations = 1u << kLayerAnnotations,
+
+	// layers coloured by the selection masks and highlight state
+	kLayerMaskSelection = kLayerMaskBoard | kLayerMaskParts | kLayerMaskPins,
+	// layers following the mouse or background scripts, recorded every frame
+	kLayerMaskVolatile  = kLayerMaskOverlay,
+	// layers only recording what's around the visible surface
+	kLayerMaskCulled    = kLayerMaskPins,
+	kLayerMaskAll       = (1u << NUM_BOARD_LAYERS) - 1,
+};
+
+// screen = recorded * scale + offset
+struct LayerTransform {
+	float scale = 1.0f;
+	ImVec2 offset;
+};
+
+class RetainedLayer {
+	ImVector<ImDrawVert> m_vtx;
+	ImVector<ImDrawIdx> m_idx;
+	ImVector<int> m_channel_start; // m_idx offset of each channel, plus the end
+
+  public:
+	// View the layer was recorded at: pan, scale, and the screen area it covers
+	ImVec2 view_pan;
+	float view_scale = 1.0f;
+	ImVec2 cull_min, cull_max;
+
+	// Clears scratch and splits it into channels, ready for the layer's draw calls
+	static void Begin(ImDrawList *scratch, int channels);
+
+	// Takes over whatever got drawn into scratch since Begin()
+	void End(ImDrawList *scratch);
+
+	int VtxCount() const {
+		return m_vtx.Size;
+	}
+	int IdxCount() const {
+		return m_idx.Size;
+	}
+
+	friend void ComposeLayers(ImDrawList *draw, RetainedLayer *const *layers, const LayerTransform *xf, int count);
+};
+
+// Appends the layers to draw, channel by channel, in layer order within each channel
+void ComposeLayers(ImDrawList *draw, RetainedLayer *const *layers, const LayerTransform *xf, int count);
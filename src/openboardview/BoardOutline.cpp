@@ -0,0 +1,326 @@
+#include "BoardOutline.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// doubles, board units squared overflow a float's precision on large boards
+static double Cross(ImVec2 o, ImVec2 a, ImVec2 b) {
+	return double(a.x - o.x) * double(b.y - o.y) - double(a.y - o.y) * double(b.x - o.x);
+}
+
+// inclusive of the edges, the triangle being counter clockwise
+static bool InTriangle(ImVec2 a, ImVec2 b, ImVec2 c, ImVec2 p) {
+	return Cross(a, b, p) >= 0.0 && Cross(b, c, p) >= 0.0 && Cross(c, a, p) >= 0.0;
+}
+
+void BoardOutline::Clear() {
+	m_points.clear();
+	m_loops.clear();
+	m_fill.clear();
+	m_band_edges.clear();
+	m_band_start.clear();
+	m_min   = ImVec2();
+	m_max   = ImVec2();
+	m_built = false;
+}
+
+void BoardOutline::Build(SharedVector<Point> &outline) {
+	Clear();
+	m_built = true;
+
+	if (outline.empty()) return;
+
+	m_points.reserve(outline.size());
+
+	size_t i = 0;
+	while (i < outline.size()) {
+		Loop loop;
+		ImVec2 first(outline[i]->x, outline[i]->y);
+
+		loop.start = m_points.size();
+		m_points.push_back(first);
+
+		for (i++; i < outline.size(); i++) {
+			ImVec2 p(outline[i]->x, outline[i]->y);
+
+			// jump double/dud points
+			if (p.x == m_points.back().x && p.y == m_points.back().y) continue;
+
+			// back on the first point, the next segment is the jump to the following loop
+			if (p.x == first.x && p.y == first.y && m_points.size() - loop.start >= 2) {
+				loop.closed = true;
+				i++;
+				break;
+			}
+			m_points.push_back(p);
+		}
+
+		loop.count = m_points.size() - loop.start;
+		if (loop.count < 2) {
+			m_points.resize(loop.start);
+			continue;
+		}
+		m_loops.push_back(loop);
+	}
+
+	m_min = ImVec2(FLT_MAX, FLT_MAX);
+	m_max = ImVec2(-FLT_MAX, -FLT_MAX);
+	for (auto &p : m_points) {
+		m_min.x = std::min(m_min.x, p.x);
+		m_min.y = std::min(m_min.y, p.y);
+		m_max.x = std::max(m_max.x, p.x);
+		m_max.y = std::max(m_max.y, p.y);
+	}
+
+	Triangulate();
+	BuildEdgeTable();
+}
+
+/*
+ * Band count follows the edge count, so a band holds a couple of edges
+ * on average whatever the outline; only edges spanning many bands (the
+ * long straight board edges) get listed more than once.
+ */
+void BoardOutline::BuildEdgeTable() {
+	std::vector<Edge> edges;
+
+	for (auto &loop : m_loops) {
+		if (loop.count < 3) continue;
+
+		for (int i = 0, j = loop.count - 1; i < loop.count; j = i++) {
+			ImVec2 a = m_points[loop.start + j];
+			ImVec2 b = m_points[loop.start + i];
+
+			if (a.y == b.y) continue; // never crosses a scanline
+			if (a.y > b.y) std::swap(a, b);
+			edges.push_back({a.y, b.y, a.x, (b.x - a.x) / (b.y - a.y)});
+		}
+	}
+	if (edges.empty()) return;
+
+	int bands     = std::min<int>(edges.size(), 1 << 16);
+	m_band_height = std::max((m_max.y - m_min.y) / bands, FLT_MIN);
+
+	auto band_of = [&](float y) {
+		return std::min(std::max(int((y - m_min.y) / m_band_height), 0), bands - 1);
+	};
+
+	// counting sort: sizes, offsets, then fill in
+	m_band_start.assign(bands + 1, 0);
+	for (auto &e : edges) {
+		for (int b = band_of(e.y0), b1 = band_of(e.y1); b <= b1; b++) m_band_start[b + 1]++;
+	}
+	for (int b = 0; b < bands; b++) m_band_start[b + 1] += m_band_start[b];
+
+	std::vector<int> fill(m_band_start.begin(), m_band_start.end() - 1);
+	m_band_edges.resize(m_band_start.back());
+	for (auto &e : edges) {
+		for (int b = band_of(e.y0), b1 = band_of(e.y1); b <= b1; b++) m_band_edges[fill[b]++] = e;
+	}
+}
+
+bool BoardOutline::LoopContains(const Loop &loop, ImVec2 p) const {
+	const ImVec2 *pts = m_points.data() + loop.start;
+	bool inside       = false;
+
+	for (int i = 0, j = loop.count - 1; i < loop.count; j = i++) {
+		const ImVec2 &a = pts[i];
+		const ImVec2 &b = pts[j];
+
+		if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) inside = !inside;
+	}
+	return inside;
+}
+
+bool BoardOutline::Contains(ImVec2 p) const {
+	bool inside = false;
+
+	if (m_band_start.empty()) return false;
+	if (p.x < m_min.x || p.x > m_max.x || p.y < m_min.y || p.y > m_max.y) return false;
+
+	int band = std::min(int((p.y - m_min.y) / m_band_height), (int)m_band_start.size() - 2);
+
+	// all loops toggle the same flag, which gives the even-odd rule across loops
+	for (int i = m_band_start[band]; i < m_band_start[band + 1]; i++) {
+		const Edge &e = m_band_edges[i];
+		if (p.y >= e.y0 && p.y < e.y1 && p.x < e.x0 + (p.y - e.y0) * e.dxdy) inside = !inside;
+	}
+	return inside;
+}
+
+/*
+ * Ear clipping, with holes.
+ *
+ * Loops nested an odd number of times are holes in the loop directly
+ * around them.  Each hole gets joined to its outer loop by a pair of
+ * coincident edges from its right-most point to a point of the outer loop
+ * it can see (Eberly, "Triangulation by Ear Clipping"), leaving a single
+ * simple polygon per outer loop which is then clipped ear by ear.
+ *
+ * Only done once per board, so the O(n^2) clipping is fine; board outlines
+ * run to a few thousand points at most.
+ */
+void BoardOutline::Triangulate() {
+	struct Ring {
+		const Loop *loop;
+		double area;
+		int depth;
+	};
+	std::vector<Ring> rings;
+
+	for (auto &loop : m_loops) {
+		if (loop.count < 3) continue;
+
+		double area = 0.0;
+		for (int i = 0, j = loop.count - 1; i < loop.count; j = i++) {
+			const ImVec2 &a = m_points[loop.start + j];
+			const ImVec2 &b = m_points[loop.start + i];
+			area += double(a.x) * b.y - double(b.x) * a.y;
+		}
+		if (area != 0.0) rings.push_back({&loop, area, 0});
+	}
+
+	for (auto &r : rings) {
+		for (auto &o : rings) {
+			if (&o != &r && LoopContains(*o.loop, m_points[r.loop->start])) r.depth++;
+		}
+	}
+
+	// a ring's points, outer rings counter clockwise and holes clockwise
+	auto ring_indices = [&](const Ring &r, bool ccw) {
+		std::vector<int> idx(r.loop->count);
+		for (int i = 0; i < r.loop->count; i++) idx[i] = r.loop->start + i;
+		if ((r.area > 0.0) != ccw) std::reverse(idx.begin(), idx.end());
+		return idx;
+	};
+
+	for (auto &outer : rings) {
+		if (outer.depth & 1) continue;
+
+		std::vector<int> poly = ring_indices(outer, true);
+
+		std::vector<std::vector<int>> holes;
+		for (auto &h : rings) {
+			if (h.depth == outer.depth + 1 && LoopContains(*outer.loop, m_points[h.loop->start]))
+				holes.push_back(ring_indices(h, false));
+		}
+
+		// right-most hole first, so later bridges can't cross earlier ones
+		auto max_x = [&](const std::vector<int> &h) {
+			float x = -FLT_MAX;
+			for (int i : h) x = std::max(x, m_points[i].x);
+			return x;
+		};
+		std::sort(holes.begin(), holes.end(), [&](const std::vector<int> &a, const std::vector<int> &b) {
+			return max_x(a) > max_x(b);
+		});
+
+		for (auto &hole : holes) {
+			int hm = 0;
+			for (int i = 1; i < (int)hole.size(); i++) {
+				if (m_points[hole[i]].x > m_points[hole[hm]].x) hm = i;
+			}
+			ImVec2 m = m_points[hole[hm]];
+
+			// nearest outer edge to the right of m, and its right-most end
+			double ix = DBL_MAX;
+			int bi    = -1;
+			for (int i = 0; i < (int)poly.size(); i++) {
+				int j          = (i + 1) % poly.size();
+				const ImVec2 a = m_points[poly[i]];
+				const ImVec2 b = m_points[poly[j]];
+
+				if (a.y == b.y || (a.y > m.y) == (b.y > m.y)) continue;
+
+				double x = a.x + double(m.y - a.y) * (b.x - a.x) / (b.y - a.y);
+				if (x >= m.x && x < ix) {
+					ix = x;
+					bi = a.x > b.x ? i : j;
+				}
+			}
+			if (bi < 0) continue;
+
+			/*
+			 * That end might be hidden from m by other parts of the outline
+			 * poking into the triangle m, edge hit, end; if so the point in
+			 * there closest in angle to the ray is visible.
+			 */
+			ImVec2 hit(ix, m.y);
+			ImVec2 p = m_points[poly[bi]];
+			if (p.x != hit.x || p.y != hit.y) {
+				ImVec2 a = m, b = hit, c = p;
+				if (Cross(a, b, c) < 0.0) std::swap(b, c);
+
+				double best = DBL_MAX;
+				for (int i = 0; i < (int)poly.size(); i++) {
+					const ImVec2 v = m_points[poly[i]];
+					if (v.x <= m.x || i == bi || !InTriangle(a, b, c, v)) continue;
+
+					double t = std::fabs(v.y - m.y) / (v.x - m.x);
+					if (t < best || (t == best && v.x < m_points[poly[bi]].x)) {
+						best = t;
+						bi   = i;
+					}
+				}
+			}
+
+			std::vector<int> bridge;
+			bridge.reserve(hole.size() + 2);
+			for (size_t i = 0; i <= hole.size(); i++) bridge.push_back(hole[(hm + i) % hole.size()]);
+			bridge.push_back(poly[bi]);
+			poly.insert(poly.begin() + bi + 1, bridge.begin(), bridge.end());
+		}
+
+		/*
+		 * Clip ears off a circular list.  If a whole lap goes by without
+		 * finding one the polygon is degenerate (self-touching outlines do
+		 * show up in board files), so the current vertex is clipped anyway
+		 * rather than looping forever.
+		 */
+		int n = poly.size();
+		std::vector<int> prev(n), next(n);
+		for (int i = 0; i < n; i++) {
+			prev[i] = (i + n - 1) % n;
+			next[i] = (i + 1) % n;
+		}
+
+		auto is_ear = [&](int i) {
+			ImVec2 a = m_points[poly[prev[i]]];
+			ImVec2 b = m_points[poly[i]];
+			ImVec2 c = m_points[poly[next[i]]];
+
+			if (Cross(a, b, c) <= 0.0) return false;
+
+			for (int j = next[next[i]]; j != prev[i]; j = next[j]) {
+				ImVec2 v = m_points[poly[j]];
+				if ((v.x == a.x && v.y == a.y) || (v.x == b.x && v.y == b.y) || (v.x == c.x && v.y == c.y)) continue;
+				if (InTriangle(a, b, c, v)) return false;
+			}
+			return true;
+		};
+
+		m_fill.reserve(m_fill.size() + (n - 2) * 3);
+
+		int i = 0, stalled = 0;
+		while (n > 3) {
+			if (is_ear(i) || stalled > n) {
+				m_fill.push_back(poly[prev[i]]);
+				m_fill.push_back(poly[i]);
+				m_fill.push_back(poly[next[i]]);
+
+				next[prev[i]] = next[i];
+				prev[next[i]] = prev[i];
+				i             = prev[i];
+				n--;
+				stalled = 0;
+			} else {
+				i = next[i];
+				stalled++;
+			}
+		}
+		m_fill.push_back(poly[prev[i]]);
+		m_fill.push_back(poly[i]);
+		m_fill.push_back(poly[next[i]]);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Board.h"
+#include <vector>
+
+/*
+ * Board outline, split up into loops.
+ *
+ * The file formats hand us the outline as one long list of points where
+ * each closed loop (board edge, cut-outs, slots) simply follows the
+ * previous one: a loop ends on the point it started from, and the segment
+ * from there to the next point is a jump to the start of the next loop,
+ * not part of the outline.  Build() works that out once and keeps every
+ * loop as a contiguous run of points, with consecutive duplicates dropped.
+ *
+ * The area enclosed by the loops (even-odd, so loops inside loops are
+ * holes) is triangulated at the same time, giving a fixed fill mesh over
+ * the very same points.
+ *
+ * For point in outline tests the edges are also sorted into horizontal
+ * bands, each listing the edges crossing it, so a test only looks at the
+ * handful of edges around its own y instead of the whole outline.
+ */
+class BoardOutline {
+  public:
+	struct Loop {
+		int start   = 0; // index of the first point in Points()
+		int count   = 0;
+		bool closed = false; // ended on its first point; an open tail is still filled as if closed
+	};
+
+	void Build(SharedVector<Point> &outline);
+	void Clear();
+
+	bool Built() const {
+		return m_built;
+	}
+
+	const std::vector<ImVec2> &Points() const {
+		return m_points;
+	}
+	const std::vector<Loop> &Loops() const {
+		return m_loops;
+	}
+
+	// Bounding box of all the points
+	ImVec2 Min() const {
+		return m_min;
+	}
+	ImVec2 Max() const {
+		return m_max;
+	}
+
+	// Triangle list over Points(), covering the inside of the board
+	const std::vector<int> &FillIndices() const {
+		return m_fill;
+	}
+
+	// Even-odd point in outline test
+	bool Contains(ImVec2 p) const;
+
+  private:
+	// edge ready for crossing tests: spans [y0, y1), x at y0 and slope
+	struct Edge {
+		float y0, y1;
+		float x0, dxdy;
+	};
+
+	bool LoopContains(const Loop &loop, ImVec2 p) const;
+	void Triangulate();
+	void BuildEdgeTable();
+
+	std::vector<ImVec2> m_points;
+	std::vector<Loop> m_loops;
+	std::vector<int> m_fill;
+	std::vector<Edge> m_band_edges;
+	std::vector<int> m_band_start; // m_band_edges offset of each band, plus the end
+	float m_band_height = 1.0f;
+	ImVec2 m_min, m_max;
+	bool m_built = false;
+};
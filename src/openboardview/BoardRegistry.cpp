@@ -0,0 +1,85 @@
+#include "BoardRegistry.h"
+
+#include <algorithm>
+
+static const std::vector<uint32_t> kNone;
+
+void BoardRegistry::Clear() {
+	m_nets_named.clear();
+	m_parts_named.clear();
+	m_net_ids.clear();
+	m_part_ids.clear();
+	m_pin_ids.clear();
+}
+
+void BoardRegistry::Build(Board &board) {
+	Clear();
+
+	auto &nets  = board.Nets();
+	auto &parts = board.Components();
+	auto &pins  = board.Pins();
+
+	m_net_ids.reserve(nets.size());
+	m_nets_named.reserve(nets.size());
+	for (uint32_t i = 0; i < nets.size(); i++) {
+		m_net_ids[nets[i].get()] = i;
+		m_nets_named[nets[i]->name].push_back(i);
+	}
+
+	m_part_ids.reserve(parts.size());
+	m_parts_named.reserve(parts.size());
+	for (uint32_t i = 0; i < parts.size(); i++) {
+		m_part_ids[parts[i].get()] = i;
+		m_parts_named[parts[i]->name].push_back(i);
+	}
+
+	m_pin_ids.reserve(pins.size());
+	for (uint32_t i = 0; i < pins.size(); i++) m_pin_ids[pins[i].get()] = i;
+}
+
+const std::vector<uint32_t> &BoardRegistry::NetsNamed(const std::string &name) const {
+	auto it = m_nets_named.find(name);
+	return it == m_nets_named.end() ? kNone : it->second;
+}
+
+const std::vector<uint32_t> &BoardRegistry::PartsNamed(const std::string &name) const {
+	auto it = m_parts_named.find(name);
+	return it == m_parts_named.end() ? kNone : it->second;
+}
+
+static void Move(std::unordered_map<std::string, std::vector<uint32_t>> &named, uint32_t id, const std::string &from, const std::string &to) {
+	auto it = named.find(from);
+	if (it != named.end()) {
+		auto &ids = it->second;
+		ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+		if (ids.empty()) named.erase(it);
+	}
+
+	auto &ids = named[to];
+	ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+}
+
+void BoardRegistry::RenamedNet(const Net *net, const std::string &old_name) {
+	int id = NetId(net);
+	if (id >= 0) Move(m_nets_named, id, old_name, net->name);
+}
+
+void BoardRegistry::RenamedPart(const Component *part, const std::string &old_name) {
+	int id = PartId(part);
+	if (id >= 0) Move(m_parts_named, id, old_name, part->name);
+}
+
+int BoardRegistry::NetId(const Net *net) const {
+	auto it = m_net_ids.find(net);
+	return it == m_net_ids.end() ? -1 : int(it->second);
+}
+
+int BoardRegistry::PartId(const Component *part) const {
+	auto it = m_part_ids.find(part);
+	return it == m_part_ids.end() ? -1 : int(it->second);
+}
+
+int BoardRegistry::PinId(const Pin *pin) const {
+	auto it = m_pin_ids.find(pin);
+	return it == m_pin_ids.end() ? -1 : int(it->second);
+}
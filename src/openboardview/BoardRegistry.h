@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Board.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Lookups into the loaded board by name and by element, built once when
+ * it's loaded (the element lists don't change after that).
+ *
+ * An element's id is its index in the board's Nets(), Components() or
+ * Pins(), which stays the same for as long as the board is up.  Names map
+ * to every element carrying them (a board can repeat a part name) in
+ * board order, matched exactly as stored.
+ */
+class BoardRegistry {
+	std::unordered_map<std::string, std::vector<uint32_t>> m_nets_named;
+	std::unordered_map<std::string, std::vector<uint32_t>> m_parts_named;
+	std::unordered_map<const Net *, uint32_t> m_net_ids;
+	std::unordered_map<const Component *, uint32_t> m_part_ids;
+	std::unordered_map<const Pin *, uint32_t> m_pin_ids;
+
+  public:
+	void Build(Board &board);
+	void Clear();
+
+	// Ids of the nets and parts named name, board order; empty for none
+	const std::vector<uint32_t> &NetsNamed(const std::string &name) const;
+	const std::vector<uint32_t> &PartsNamed(const std::string &name) const;
+
+	// A net or part got renamed from old_name to what it's called now
+	void RenamedNet(const Net *net, const std::string &old_name);
+	void RenamedPart(const Component *part, const std::string &old_name);
+
+	// Id of an element, -1 when it isn't on this board
+	int NetId(const Net *net) const;
+	int PartId(const Component *part) const;
+	int PinId(const Pin *pin) const;
+};
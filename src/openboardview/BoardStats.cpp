@@ -0,0 +1,88 @@
+#include "BoardStats.h"
+#include "ParallelDraw.h"
+
+#include <algorithm>
+
+static void Grow(BBox &box, ImVec2 p, bool first) {
+	if (first) {
+		box = {p, p};
+		return;
+	}
+	box.min.x = std::min(box.min.x, p.x);
+	box.min.y = std::min(box.min.y, p.y);
+	box.max.x = std::max(box.max.x, p.x);
+	box.max.y = std::max(box.max.y, p.y);
+}
+
+void BoardStats::Clear() {
+	m_nets.clear();
+	m_parts.clear();
+	m_net_nodes.reset();
+}
+
+void BoardStats::Build(Board &board) {
+	auto &nets  = board.Nets();
+	auto &parts = board.Components();
+
+	m_nets.assign(nets.size(), NetStats());
+	m_parts.assign(parts.size(), PartStats());
+	m_net_nodes.reset(new std::atomic<uint32_t>[nets.size()]);
+	for (size_t i = 0; i < nets.size(); i++) m_net_nodes[i] = 0;
+
+	// every net and part only looks at its own pins, chunks of them are independent
+	ParallelDraw::For(nets.size(), ParallelDraw::Workers(nets.size()), [&](size_t, size_t from, size_t to) {
+		std::vector<const Component *> seen;
+		for (size_t i = from; i < to; i++) {
+			auto &net = nets[i];
+			NetStats &s = m_nets[i];
+			s.ground    = net->is_ground;
+			seen.clear();
+			for (auto &pin : net->pins) {
+				Grow(s.box, pin->position, s.pins == 0);
+				s.pins++;
+				if (pin->component) {
+					seen.push_back(pin->component.get());
+					s.sides |= 1 << pin->component->board_side;
+				}
+			}
+			std::sort(seen.begin(), seen.end());
+			s.parts = std::unique(seen.begin(), seen.end()) - seen.begin();
+		}
+	});
+
+	ParallelDraw::For(parts.size(), ParallelDraw::Workers(parts.size()), [&](size_t, size_t from, size_t to) {
+		std::vector<const Net *> seen;
+		for (size_t i = from; i < to; i++) {
+			PartStats &s = m_parts[i];
+			seen.clear();
+			for (auto &pin : parts[i]->pins) {
+				Grow(s.box, pin->position, s.pins == 0);
+				s.pins++;
+				if (!pin->net) continue;
+				if (pin->net->is_ground) s.ground_pins++;
+				seen.push_back(pin->net);
+			}
+			std::sort(seen.begin(), seen.end());
+			s.nets = std::unique(seen.begin(), seen.end()) - seen.begin();
+		}
+	});
+}
+
+static void Mirror(BBox &box, float axis) {
+	float min_x = axis - box.max.x;
+	box.max.x   = axis - box.min.x;
+	box.min.x   = min_x;
+}
+
+void BoardStats::Mirror(float axis) {
+	for (auto &s : m_nets) ::Mirror(s.box, axis);
+	for (auto &s : m_parts) ::Mirror(s.box, axis);
+}
+
+uint32_t BoardStats::Nodes(int id) const {
+	return id >= 0 && size_t(id) < m_nets.size() ? m_net_nodes[id].load() : 0;
+}
+
+void BoardStats::NodeAdded(int id) {
+	if (id >= 0 && size_t(id) < m_nets.size()) m_net_nodes[id]++;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Board.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Per-net and per-part figures the UI and Tcl keep asking for, worked out
+ * once when the board is loaded (spread over the cores for big boards)
+ * instead of walking the pins every time.  Indexed by BoardRegistry ids.
+ *
+ * Pins don't move between nets or parts after loading, so these stay
+ * right (bar mirroring the board, see Mirror()); the one thing scripts add to later is nodes, counted per net as
+ * add_node goes (atomically, scripts may run on threads of their own).
+ */
+struct NetStats {
+	BBox box;         // of the pin centres, only meaningful with pins
+	uint32_t pins  = 0;
+	uint32_t parts = 0; // distinct parts with a pin on the net
+	uint8_t sides  = 0; // bit per EBoardSide the net's parts are on
+	bool ground    = false;
+};
+
+struct PartStats {
+	BBox box; // of the pin centres, only meaningful with pins
+	uint32_t pins        = 0;
+	uint32_t ground_pins = 0;
+	uint32_t nets        = 0; // distinct nets on its pins
+};
+
+class BoardStats {
+	std::vector<NetStats> m_nets;
+	std::vector<PartStats> m_parts;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_net_nodes;
+
+  public:
+	void Build(Board &board);
+	void Clear();
+	// The pins got mirrored to x' = axis - x (BoardView::Mirror()), the boxes follow
+	void Mirror(float axis);
+
+	const NetStats *OfNet(int id) const {
+		return id >= 0 && size_t(id) < m_nets.size() ? &m_nets[id] : nullptr;
+	}
+	const PartStats *OfPart(int id) const {
+		return id >= 0 && size_t(id) < m_parts.size() ? &m_parts[id] : nullptr;
+	}
+
+	uint32_t Nodes(int id) const;
+	void NodeAdded(int id);
+};
@@ -8,9 +8,12 @@
 
 #include <cmath>
 #include <iostream>
+#include <array>
+#include <chrono>
 #include <climits>
 #include <memory>
 #include <cstdio>
+#include <unordered_set>
 #ifdef ENABLE_SDL2
 #include <SDL.h>
 #endif
@@ -32,6 +35,8 @@
 
 #include "TCL.h"
 #include "NetList.h"
+#include "NetWeb.h"
+#include "ParallelDraw.h"
 #include "PartList.h"
 #include "vectorhulls.h"
 
@@ -47,6 +52,7 @@ using namespace std::placeholders;
 #endif
 
 BoardView::~BoardView() {
+	m_searchWorker.Reset();
 	if (m_validBoard) {
 		for (auto &p : m_board->Components()) {
 			if (p->hull) free(p->hull);
@@ -66,6 +72,7 @@ BoardView::~BoardView() {
 		m_annotations.Close();
 		m_validBoard = false;
 	}
+	if (m_layerScratch) IM_DELETE(m_layerScratch);
 }
 uint32_t BoardView::byte4swap(uint32_t x) {
 	/*
@@ -229,7 +236,13 @@ int BoardView::ConfigParse(void) {
 #define M(name) f(#name , name)
 	M(fontSize);
 	M(pinSizeThresholdLow);
+	M(pinLOD);
+	M(pinLODThreshold);
 	M(pinShapeSquare);
+	M(labelCulling);
+	M(adaptiveQuality);
+	M(qualityBudget);
+	m_governor.SetBudget(qualityBudget);
 	if (!pinShapeCircle && !pinShapeSquare) {
 		pinShapeSquare = true;
 	}
@@ -259,6 +272,7 @@ int BoardView::ConfigParse(void) {
 	M(showPins);
 	M(showPosition);
 	M(showNetWeb);
+	M(netWebRatsnest);
 	M(showAnnotations);
 	f("showBackgroundImage", backgroundImage.enabled);
 	M(fillParts);
@@ -426,11 +440,15 @@ int BoardView::LoadFile(const filesystem::path &filepath) {
 	if (!filepath.empty()) {
 		// clean up the previous file.
 		if (m_file && m_board) {
+			// the search worker may still be reading its names
+			m_searchWorker.Reset();
+			for (auto &r : m_searchResults) r = SearchWorker::Results();
 			for (auto &p : m_board->Components()) {
 				if (p->hull) free(p->hull);
 			}
 			m_pinHighlighted.clear();
 			m_partHighlighted.clear();
+			HighlightsChanged();
 			m_annotations.Close();
 			m_board->OutlinePoints().clear();
 			if constexpr (! std::is_same<obv_shared_ptr<Component>, std::shared_ptr<Component> >::value) {
@@ -475,13 +493,13 @@ int BoardView::LoadFile(const filesystem::path &filepath) {
 				SetFile(obv_shared_ptr<BRDFile>(file));
 				fhistory.Prepend_save(filepath.string());
 				history_file_has_changed = 1; // used by main to know when to update the window title
-				boardMinMaxDone          = false;
 				m_rotation               = 0;
 				m_current_side           = 0;
 				EPCCheck(); // check to see we don't have a flipped board outline
 
 				m_annotations.SetFilename(filepath.string());
 				m_annotations.Load();
+				m_picker.InvalidateAnnotations();
 
 				auto conffilepath = filepath;
 				conffilepath.replace_extension("conf");
@@ -613,14 +631,16 @@ void BoardView::ColorPreferences(void) {
 				obvconfig.WriteStr("colorTheme", "light");
 				ThemeSetStyle("light");
 				SaveAllColors();
-				m_needsRedraw = true;
+				InvalidateLayers();
+				InvalidateStyles();
 			}
 			ImGui::SameLine();
 			if (ImGui::RadioButton("Dark", &tc, 1)) {
 				obvconfig.WriteStr("colorTheme", "dark");
 				ThemeSetStyle("dark");
 				SaveAllColors();
-				m_needsRedraw = true;
+				InvalidateLayers();
+				InvalidateStyles();
 			}
 		}
 		ImGui::Dummy(ImVec2(1, DPI(5)));
@@ -851,6 +871,31 @@ void BoardView::Preferences(void) {
 			obvconfig.WriteInt("pinA1threshold", pinA1threshold);
 		}
 
+		if (ImGui::Checkbox("Pin level of detail", &pinLOD)) {
+			obvconfig.WriteBool("pinLOD", pinLOD);
+		}
+		RA("Pin LOD threshold", DPI(200));
+		ImGui::SameLine();
+		if (ImGui::InputFloat("##pinLODThreshold", &pinLODThreshold)) {
+			if (pinLODThreshold < 0) pinLODThreshold = 0;
+			obvconfig.WriteFloat("pinLODThreshold", pinLODThreshold);
+		}
+
+		if (ImGui::Checkbox("Hide overlapping labels", &labelCulling)) {
+			obvconfig.WriteBool("labelCulling", labelCulling);
+		}
+
+		if (ImGui::Checkbox("Adaptive quality", &adaptiveQuality)) {
+			obvconfig.WriteBool("adaptiveQuality", adaptiveQuality);
+		}
+		RA("Frame budget (ms)", DPI(200));
+		ImGui::SameLine();
+		if (ImGui::InputFloat("##qualityBudget", &qualityBudget)) {
+			if (qualityBudget < 1.0f) qualityBudget = 1.0f;
+			m_governor.SetBudget(qualityBudget);
+			obvconfig.WriteFloat("qualityBudget", qualityBudget);
+		}
+
 		if (ImGui::Checkbox("Pin select masks", &pinSelectMasks)) {
 			obvconfig.WriteBool("pinSelectMasks", pinSelectMasks);
 		}
@@ -889,6 +934,10 @@ void BoardView::Preferences(void) {
 			obvconfig.WriteBool("showNetWeb", showNetWeb);
 		}
 
+		if (ImGui::Checkbox("Net web as ratsnest", &netWebRatsnest)) {
+			obvconfig.WriteBool("netWebRatsnest", netWebRatsnest);
+		}
+
 		if (ImGui::Checkbox("slowCPU", &slowCPU)) {
 			obvconfig.WriteBool("slowCPU", slowCPU);
 			style.AntiAliasedLines = !slowCPU;
@@ -1162,7 +1211,6 @@ void BoardView::ShowInfoPane(void) {
 				m_board_surface.x = ds.x * 0.66;
 				m_info_surface.x  = ds.x - m_board_surface.x;
 			}
-			if (delta.x > 0) m_needsRedraw = true;
 		}
 	} else {
 		if (m_dragging_token == 2) {
@@ -1232,11 +1280,13 @@ void BoardView::ShowInfoPane(void) {
 				} else {
 					SetTarget(part->pins[0]->position);
 				}
-				m_needsRedraw = 1;
 			}
 
 			ImGui::SameLine();
-			ImGui::Text("%zu Pin(s)", part->pins.size());
+			if (auto stats = m_stats.OfPart(m_registry.PartId(part.get())))
+				ImGui::Text("%u Pin(s), %u Net(s)", stats->pins, stats->nets);
+			else
+				ImGui::Text("%zu Pin(s)", part->pins.size());
 			ImGui::SameLine();
 			{
 				char name_and_id[128];
@@ -1272,7 +1322,7 @@ void BoardView::ShowInfoPane(void) {
 						ClearAllHighlights();
 
 						if ((pin->type == Pin::kPinTypeNotConnected) || (pin->type == Pin::kPinTypeUnkown) || (pin->net->is_ground)) {
-							m_partHighlighted.push_back(pin->component);
+							HighlightPart(pin->component);
 							// do nothing for now
 							//
 						} else {
@@ -1281,10 +1331,9 @@ void BoardView::ShowInfoPane(void) {
 							//	pin->component->visualmode = pin->component->CVMNormal;
 							//};
 							pin->component->visualmode = pin->component->CVMNormal;
-							m_partHighlighted.push_back(pin->component);
+							HighlightPart(pin->component);
 							CenterZoomNet(pin->net->name);
 						}
-						m_needsRedraw = true;
 					}
 					ImGui::PushStyleColor(ImGuiCol_Border, 0xffeeeeee);
 					ImGui::Separator();
@@ -1451,7 +1500,8 @@ void BoardView::ContextMenu(void) {
 							m_annotationedit_retain = false;
 							m_annotations.Update(m_annotations.annotations[m_annotation_clicked_id].id, contextbuf);
 							m_annotations.GenerateList();
-							m_needsRedraw      = true;
+							m_picker.InvalidateAnnotations();
+							InvalidateLayers(kLayerMaskAnnotations);
 							m_tooltips_enabled = true;
 							// m_parent_occluded = false;
 							ImGui::CloseCurrentPopup();
@@ -1514,7 +1564,8 @@ void BoardView::ContextMenu(void) {
 
 						m_annotations.Add(m_current_side, tx, ty, net.c_str(), partn.c_str(), pin.c_str(), contextbufnew);
 						m_annotations.GenerateList();
-						m_needsRedraw = true;
+						m_picker.InvalidateAnnotations();
+						InvalidateLayers(kLayerMaskAnnotations);
 
 						ImGui::CloseCurrentPopup();
 					}
@@ -1533,7 +1584,8 @@ void BoardView::ContextMenu(void) {
 				if ((m_annotation_clicked_id >= 0) && (ImGui::Button("Remove"))) {
 					m_annotations.Remove(m_annotations.annotations[m_annotation_clicked_id].id);
 					m_annotations.GenerateList();
-					m_needsRedraw = true;
+					m_picker.InvalidateAnnotations();
+					InvalidateLayers(kLayerMaskAnnotations);
 					// m_parent_occluded = false;
 					ImGui::CloseCurrentPopup();
 				}
@@ -1564,14 +1616,6 @@ void BoardView::ContextMenu(void) {
 	}
 }
 
-std::pair<SharedVector<Component>, SharedVector<Net>> BoardView::SearchPartsAndNets(const char *search, int limit) {
-	SharedVector<Component> parts;
-	SharedVector<Net> nets;
-	if (m_searchComponents) parts = searcher.parts(search, limit);
-	if (m_searchNets) nets = searcher.nets(search, limit);
-	return {parts, nets};
-}
-
 const char *getcname(const std::string &name) {
 	return name.c_str();
 }
@@ -1582,7 +1626,7 @@ const char *getcname(const T &t) {
 }
 
 template <class T>
-void BoardView::ShowSearchResults(std::vector<T> results, char *search, int &limit, void (BoardView::*onSelect)(const char *)) {
+void BoardView::ShowSearchResults(const std::vector<T> &results, char *search, int &limit, void (BoardView::*onSelect)(const char *)) {
 	for (auto &r : results) {
 		const char *cname = getcname(r);
 		if (ImGui::Selectable(cname, false)) {
@@ -1595,31 +1639,29 @@ void BoardView::ShowSearchResults(std::vector<T> results, char *search, int &lim
 }
 
 void BoardView::SearchColumnGenerate(const std::string &title,
-                                     std::pair<SharedVector<Component>, SharedVector<Net>> results,
+                                     const SearchWorker::Results &results,
                                      char *search,
                                      int limit) {
 	if (ImGui::ListBoxHeader(title.c_str())) {
 
 		if (m_searchComponents) {
-			if (results.first.empty() && (!m_searchNets || results.second.empty())) { // show suggestions only if there is no result at all
-				auto s = scparts.suggest(search);
-				if (s.size() > 0) {
+			if (results.parts.empty() && (!m_searchNets || results.nets.empty())) { // show suggestions only if there is no result at all
+				if (results.part_suggestions.size() > 0) {
 					ImGui::Text("Did you mean...");
-					ShowSearchResults(s, search, limit, &BoardView::FindComponent);
+					ShowSearchResults(results.part_suggestions, search, limit, &BoardView::FindComponent);
 				}
 			} else
-				ShowSearchResults(results.first, search, limit, &BoardView::FindComponent);
+				ShowSearchResults(results.parts, search, limit, &BoardView::FindComponent);
 		}
 
 		if (m_searchNets) {
-			if (results.second.empty() && (!m_searchComponents || results.first.empty())) {
-				auto s = scnets.suggest(search);
-				if (s.size() > 0) {
+			if (results.nets.empty() && (!m_searchComponents || results.parts.empty())) {
+				if (results.net_suggestions.size() > 0) {
 					ImGui::Text("Did you mean...");
-					ShowSearchResults(s, search, limit, &BoardView::FindNet);
+					ShowSearchResults(results.net_suggestions, search, limit, &BoardView::FindNet);
 				}
 			} else
-				ShowSearchResults(results.second, search, limit, &BoardView::FindNet);
+				ShowSearchResults(results.nets, search, limit, &BoardView::FindNet);
 		}
 
 		ImGui::ListBoxFooter();
@@ -1713,18 +1755,28 @@ void BoardView::SearchComponent(void) {
 
 			ImGui::PushItemWidth(-1);
 
-			bool searching  = m_search[i - 1][0] != '\0';                        // Text typed in the search box
-			auto results    = SearchPartsAndNets(m_search[i - 1], 30);           // Perform the search for both nets and parts
-			bool hasResults = !results.first.empty() || !results.second.empty(); // We found some nets or some parts
-
-			if (searching && !hasResults) ImGui::PushStyleColor(ImGuiCol_FrameBg, 0xFF6666FF);
-			auto ret = ImGui::InputText(searchLabel.c_str(),
-			                            m_search[i - 1],
-			                            128,
-			                            ImGuiInputTextFlags_CharsNoBlank | (m_search[0] ? ImGuiInputTextFlags_AutoSelectAll : 0));
-			if (searching && !hasResults) ImGui::PopStyleColor();
-
-			if (ret) SearchCompound(m_search[i - 1]);
+			// the search runs on the worker, what's shown is its latest answer until a newer one comes in
+			auto &results = m_searchResults[i - 1];
+			if (m_searchWorker.Collect(i - 1, results) && m_search[i - 1][0]) PreviewSearchResults(results);
+
+			bool searching  = m_search[i - 1][0] != '\0';                    // Text typed in the search box
+			bool hasResults = !results.parts.empty() || !results.nets.empty(); // We found some nets or some parts
+			bool noMatch    = searching && !hasResults && !m_searchWorker.Pending(i - 1);
+
+			if (noMatch) ImGui::PushStyleColor(ImGuiCol_FrameBg, 0xFF6666FF);
+			ImGui::InputText(searchLabel.c_str(),
+			                 m_search[i - 1],
+			                 128,
+			                 ImGuiInputTextFlags_CharsNoBlank | (m_search[0] ? ImGuiInputTextFlags_AutoSelectAll : 0));
+			if (noMatch) ImGui::PopStyleColor();
+
+			SearchWorker::Query query;
+			query.text  = m_search[i - 1];
+			query.mode  = searcher.getMode();
+			query.parts = m_searchComponents;
+			query.nets  = m_searchNets;
+			query.limit = 30;
+			m_searchWorker.Post(i - 1, query);
 
 			ImGui::PopItemWidth();
 
@@ -1776,13 +1828,28 @@ void BoardView::ClearAllHighlights(void) {
 	m_search[0][0]     = '\0';
 	m_search[1][0]     = '\0';
 	m_search[2][0]     = '\0';
-	m_needsRedraw      = true;
 	m_tooltips_enabled = true;
 	if (m_board) {
 		for (auto part : m_board->Components()) part->visualmode = part->CVMNormal;
 	}
 	m_partHighlighted.clear();
 	m_pinHighlighted.clear();
+	HighlightsChanged();
+}
+
+void BoardView::HighlightPin(const obv_shared_ptr<Pin> &pin) {
+	m_pinHighlighted.push_back(pin);
+	m_highlightGeneration++;
+}
+
+void BoardView::HighlightPart(const obv_shared_ptr<Component> &part) {
+	m_partHighlighted.push_back(part);
+	m_highlightGeneration++;
+}
+
+void BoardView::HighlightsChanged(void) {
+	m_highlightsRewritten = true;
+	m_highlightGeneration++;
 }
 
 /** UPDATE Logic region
@@ -1813,6 +1880,9 @@ void BoardView::Update() {
 		m_wantsQuit = true;
 	}
 
+	// before the search boxes and lists use the index
+	UpdateNames();
+
 	if (ImGui::BeginMainMenuBar()) {
 		m_menu_height = ImGui::GetWindowHeight();
 
@@ -1909,49 +1979,40 @@ void BoardView::Update() {
 			
 			if (ImGui::MenuItem("Toggle Pin Display", keybindings.getKeyNames("TogglePins").c_str())) {
 				showPins ^= 1;
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::MenuItem("Show Info Panel", keybindings.getKeyNames("InfoPanel").c_str())) {
 				showInfoPanel ^= 1;
 				obvconfig.WriteBool("showInfoPanel", showInfoPanel ? true : false);
-				m_needsRedraw = true;
 			}
 
 			ImGui::Separator();
 			if (ImGui::Checkbox("Show FPS", &showFPS)) {
 				obvconfig.WriteBool("showFPS", showFPS);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Show Position", &showPosition)) {
 				obvconfig.WriteBool("showPosition", showPosition);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Net web", &showNetWeb)) {
 				obvconfig.WriteBool("showNetWeb", showNetWeb);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Annotations", &showAnnotations)) {
 				obvconfig.WriteBool("showAnnotations", showAnnotations);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Board fill", &boardFill)) {
 				obvconfig.WriteBool("boardFill", boardFill);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Part fill", &fillParts)) {
 				obvconfig.WriteBool("fillParts", fillParts);
-				m_needsRedraw = true;
 			}
 
 			if (ImGui::Checkbox("Background image", &backgroundImage.enabled)) {
 				obvconfig.WriteBool("showBackgroundImage", backgroundImage.enabled);
-				m_needsRedraw = true;
 			}
 
 			ImGui::Separator();
@@ -1984,27 +2045,23 @@ void BoardView::Update() {
 		ImGui::SameLine();
 		if (ImGui::Checkbox("Annotations", &showAnnotations)) {
 			obvconfig.WriteBool("showAnnotations", showAnnotations);
-			m_needsRedraw = true;
 		}
 
 		ImGui::SameLine();
 		if (ImGui::Checkbox("Netweb", &showNetWeb)) {
 			obvconfig.WriteBool("showNetWeb", showNetWeb);
-			m_needsRedraw = true;
 		}
 
 		ImGui::SameLine();
 		{
 			if (ImGui::Checkbox("Pins", &showPins)) {
 				obvconfig.WriteBool("showPins", showPins);
-				m_needsRedraw = true;
 			}
 		}
 
 		ImGui::SameLine();
 		if (ImGui::Checkbox("Image", &backgroundImage.enabled)) {
 			obvconfig.WriteBool("showBackgroundImage", backgroundImage.enabled);
-			m_needsRedraw = true;
 		}
 
 		ImGui::SameLine();
@@ -2193,6 +2250,18 @@ void BoardView::Update() {
 		if (showFPS == true) {
 			ImGui::Text("FPS: %0.0f ", ImGui::GetIO().Framerate);
 			ImGui::SameLine();
+			if (adaptiveQuality) {
+				ImGui::Text("Draw: %0.1fms  Quality: %s ", m_governor.AverageMs(), m_governor.Describe());
+				ImGui::SameLine();
+			}
+			if (m_inputLatency && m_inputLatency->Count()) {
+				ImGui::Text("Latency p50/p95: %0.1f/%0.1fms ", m_inputLatency->Percentile(0.5f), m_inputLatency->Percentile(0.95f));
+				ImGui::SameLine();
+			}
+			if (m_motionLatency && m_motionLatency->Count()) {
+				ImGui::Text("Motion: %0.1f/%0.1fms ", m_motionLatency->Percentile(0.5f), m_motionLatency->Percentile(0.95f));
+				ImGui::SameLine();
+			}
 		}
 
 		if (debug) {
@@ -2247,9 +2316,8 @@ void BoardView::Update() {
 	if (m_board_surface.x != m_lastWidth || m_board_surface.y != m_lastHeight) {
 		//		m_lastWidth   = io.DisplaySize.x;
 			//		m_lastHeight  = io.DisplaySize.y;
-		m_lastWidth   = m_board_surface.x;
-		m_lastHeight  = m_board_surface.y;
-		m_needsRedraw = true;
+		m_lastWidth  = m_board_surface.x;
+		m_lastHeight = m_board_surface.y;
 	}
 
 	float dy_off = 0;
@@ -2258,12 +2326,12 @@ void BoardView::Update() {
 	dual_draw_side2 = false;
 	bool split_x = m_split_view_x != 0.0f;
 	bool split_y = m_split_view_y != 0.0f && m_split_view_x == 0.0f;
+	m_boardViewIndex = 0;
 	
 	// e__l
 
 	for (int draw_side = 0; draw_side < (split_x || split_y ? 2 : 1); ++draw_side) {
 		//m_current_side ^= draw_side;
-		m_needsRedraw = true;
 
 		if (draw_side) {
 			dual_draw_side2 = true;
@@ -2304,7 +2372,6 @@ void BoardView::Update() {
 			if (m_draw_both_sides) {
 				dual_draw_side2 = true;
 				dual_draw_offset = ImVec2{ 0.0f, float(m_boardHeight) };
-				m_needsRedraw = true;
 				DrawBoard();
 			}
 		}
@@ -2325,6 +2392,19 @@ void BoardView::Update() {
 		}
 	}
 	dual_draw_offset = { 0, 0 };
+
+	/*
+	 * The governor only trades quality away while the view is being moved
+	 * about; once it's been still for half a second or so the next redraw
+	 * is at full quality again (the level is part of the view state).
+	 */
+	bool busy = m_validBoard && m_layersStill[0] < kQualityIdleFrames;
+	m_wantsFrame = m_governor.EndFrame(adaptiveQuality, busy) || m_governor.Level() != QualityGovernor::kFull;
+
+	// a zoom only gets re-recorded at the new scale a couple of still frames later
+	for (int view = 0; view < m_boardViewIndex && view < kMaxBoardViews; view++) {
+		if (m_layersStill[view] < 2) m_wantsFrame = true;
+	}
 } // main menu bar
 
 void BoardView::Zoom(float osd_x, float osd_y, float zoom) {
@@ -2358,7 +2438,7 @@ void BoardView::Zoom(float osd_x, float osd_y, float zoom) {
 
 	m_dx += td.x;
 	m_dy += td.y;
-	m_needsRedraw = true;
+	// nothing to invalidate, the board layers follow the view by themselves
 }
 
 void BoardView::Pan(int direction, int amount) {
@@ -2398,7 +2478,6 @@ void BoardView::Pan(int direction, int amount) {
 	}
 
 	m_draggingLastFrame = true;
-	m_needsRedraw       = true;
 }
 
 /*
@@ -2413,8 +2492,28 @@ void BoardView::HandleInput() {
 
 	if (ImGui::IsWindowHovered()) {
 		if (ImGui::IsMouseDragging(0)) {
-			if ((m_dragging_token == 0) && (io.MouseClickedPos[0].x < m_board_surface.x)) m_dragging_token = 1; // own it.
-			if (m_dragging_token == 1) {
+			if ((m_dragging_token == 0) && (io.MouseClickedPos[0].x < m_board_surface.x)) {
+				m_dragging_token = 1; // own it.
+
+				// Shift drags out a selection rectangle, Alt a lasso, instead of panning
+				if (io.KeyShift || io.KeyAlt) {
+					ImVec2 start     = io.MouseClickedPos[0];
+					m_bandLastScreen = start;
+					m_band.Begin(BoardPicker(), io.KeyAlt ? SelectionBand::kLasso : SelectionBand::kRect, PickSide(), ScreenToCoord(start.x, start.y));
+				}
+			}
+			if (m_dragging_token == 1 && m_band.Active()) {
+				ImVec2 spos = io.MousePos;
+				ImVec2 d    = spos - m_bandLastScreen;
+
+				// the lasso only takes a point every few pixels, the rectangle follows the mouse
+				if (m_band.GetMode() == SelectionBand::kRect || d.x * d.x + d.y * d.y >= DPIF(3.0f) * DPIF(3.0f)) {
+					m_band.Extend(BoardPicker(), ScreenToCoord(spos.x, spos.y));
+					m_bandLastScreen = spos;
+				}
+				ImGui::ResetMouseDragDelta();
+				m_draggingLastFrame = true;
+			} else if (m_dragging_token == 1) {
 				//		   if ((io.MouseClickedPos[0].x < m_info_surface.x)) {
 				ImVec2 delta = ImGui::GetMouseDragDelta();
 				if ((abs(delta.x) > 500) || (abs(delta.y) > 500)) {
@@ -2431,11 +2530,12 @@ void BoardView::HandleInput() {
 					m_dy += td.y;
 				}
 				m_draggingLastFrame = true;
-				m_needsRedraw       = true;
 			}
 		} else if (m_dragging_token >= 0) {
 			m_dragging_token = 0;
 			m_tcl_drag = false;
+
+			if (m_band.Active()) ApplyBand(io.KeyCtrl);
 			
 			if (m_lastFileOpenWasInvalid == false) {
 				// Conext menu
@@ -2451,7 +2551,6 @@ void BoardView::HandleInput() {
 						m_showContextMenu       = true;
 						m_showContextMenuPos    = spos;
 						m_tooltips_enabled      = false;
-						m_needsRedraw           = true;
 						if (debug) fprintf(stderr, "context click request at (%f %f)\n", spos.x, spos.y);
 					}
 
@@ -2464,24 +2563,11 @@ void BoardView::HandleInput() {
 					ImVec2 spos = ImGui::GetMousePos();
 					ImVec2 pos  = ScreenToCoord(spos.x, spos.y);
 
-					m_needsRedraw = true;
-
 					// threshold to within a pin's diameter of the pin center
 					// float min_dist = m_pinDiameter * 1.0f;
-					float min_dist = m_pinDiameter / 2.0f;
-					min_dist *= min_dist; // all distance squared
+					int hit_pin                   = BoardPicker().PinAt(PickSide(), pos, m_pinDiameter / 2.0f);
 					obv_shared_ptr<Pin> selection = nullptr;
-					for (auto &pin : m_board->Pins()) {
-						if (BoardElementIsVisible(pin->component)) {
-							float dx   = pin->position.x - pos.x;
-							float dy   = pin->position.y - pos.y;
-							float dist = dx * dx + dy * dy;
-							if ((dist < (pin->diameter * pin->diameter)) && (dist < min_dist)) {
-								selection = pin;
-								min_dist  = dist;
-							}
-						}
-					}
+					if (hit_pin >= 0) selection = m_board->Pins()[hit_pin];
 
 					m_pinSelected = selection;
 					if (m_pinSelected) {
@@ -2499,29 +2585,11 @@ void BoardView::HandleInput() {
 					if (m_pinSelected == nullptr) {
 						bool any_hits = false;
 
-						for (auto &part : m_board->Components()) {
-							int hit = 0;
-							//							auto p_part = part.get();
-
-							if (!BoardElementIsVisible(part)) continue;
-
-							// Work out if the point is inside the hull
+						// copied, the select event runs Tcl which may pick again
+						std::vector<uint32_t> hits = BoardPicker().PartsAt(PickSide(), pos);
+						for (uint32_t k : hits) {
+							auto &part = m_board->Components()[k];
 							{
-								int i, j, n;
-								outline_pt *poly;
-
-								n    = 4;
-								poly = part->outline;
-
-								for (i = 0, j = n - 1; i < n; j = i++) {
-									if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
-									    (pos.x <
-									     (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
-										hit ^= 1;
-								}
-							}
-
-							if (hit) {
 								any_hits = true;
 
 								bool partInList = contains(part, m_partHighlighted);
@@ -2588,16 +2656,11 @@ void BoardView::HandleInput() {
 
 					} // if a pin wasn't selected
 
+					HighlightsChanged();
+
 				} else {
-					if (!m_showContextMenu) {
-						if (AnnotationIsHovered()) {
-							m_needsRedraw        = true;
-							AnnotationWasHovered = true;
-						} else {
-							AnnotationWasHovered = false;
-							m_needsRedraw        = true;
-						}
-					}
+					// the hovered annotation's tooltip is drawn every frame, the layers stay as they are
+					if (!m_showContextMenu) AnnotationWasHovered = AnnotationIsHovered();
 				}
 
 				m_draggingLastFrame = false;
@@ -2608,10 +2671,9 @@ void BoardView::HandleInput() {
 			if (mwheel != 0.0f) {
 				mwheel *= zoomFactor;
 
+				// the wheel over the schematic zooms that instead, it's drawn every frame outside the layers
 				if (! m_tcl->handle_mouse_wheel(io.MousePos.x, io.MousePos.y, io.MouseWheel)) {
 					Zoom(io.MousePos.x, io.MousePos.y, mwheel);
-				} else {
-					m_needsRedraw = true;
 				}
 			}
 		}
@@ -2622,7 +2684,7 @@ void BoardView::HandleInput() {
 		if (keybindings.isPressed("Mirror")) {
 			Mirror();
 			CenterView();
-			m_needsRedraw = true;
+			InvalidateLayers();
 
 		} else if (keybindings.isPressed("DualDraw")) {
 			if (m_split_view_x) {
@@ -2685,12 +2747,10 @@ void BoardView::HandleInput() {
 
 		} else if (keybindings.isPressed("TogglePins")) {
 			showPins ^= 1;
-			m_needsRedraw = true;
 
 		} else if (keybindings.isPressed("Search")) {
 			if (m_validBoard) {
-				m_showSearch  = true;
-				m_needsRedraw = true;
+				m_showSearch = true;
 			}
 
 		} else if (keybindings.isPressed("Clear")) {
@@ -2732,12 +2792,12 @@ void BoardView::HandleInput() {
  */
 void BoardView::ShowNetList(bool *p_open) {
 	static NetList netList(bind(&BoardView::FindNet, this, _1));
-	netList.Draw("Net List", p_open, m_board.get());
+	netList.Draw("Net List", p_open, m_board.get(), searcher.netIndex());
 }
 
 void BoardView::ShowPartList(bool *p_open) {
 	static PartList partList(bind(&BoardView::FindComponent, this, _1));
-	partList.Draw("Part List", p_open, m_board.get());
+	partList.Draw("Part List", p_open, m_board.get(), searcher.partIndex());
 }
 
 void BoardView::RenderOverlay() {
@@ -2772,18 +2832,21 @@ void BoardView::CenterZoomNet(string netname) {
 	min.x = min.y = FLT_MAX;
 	max.x = max.y = FLT_MIN;
 
-	for (auto &pin : m_board->Pins()) {
-		if (pin->net->name == netname) {
-			auto p = pin->position;
-			if (p.x < min.x) min.x = p.x;
-			if (p.y < min.y) min.y = p.y;
-			if (p.x > max.x) max.x = p.x;
-			if (p.y > max.y) max.y = p.y;
+	for (uint32_t id : m_registry.NetsNamed(netname)) {
+		auto stats = m_stats.OfNet(id);
+		if (stats && stats->pins) {
+			if (stats->box.min.x < min.x) min.x = stats->box.min.x;
+			if (stats->box.min.y < min.y) min.y = stats->box.min.y;
+			if (stats->box.max.x > max.x) max.x = stats->box.max.x;
+			if (stats->box.max.y > max.y) max.y = stats->box.max.y;
+		}
 
-			if ((infoPanelSelectPartsOnNet) && (pin->type != Pin::kPinTypeTestPad)) {
+		if (!infoPanelSelectPartsOnNet) continue;
+		for (auto &pin : m_board->Nets()[id]->pins) {
+			if (pin->type != Pin::kPinTypeTestPad) {
 				if (!contains(pin->component, m_partHighlighted)) {
 					pin->component->visualmode = pin->component->CVMSelected;
-					m_partHighlighted.push_back(pin->component);
+					HighlightPart(pin->component);
 				}
 			}
 		}
@@ -2819,7 +2882,6 @@ void BoardView::CenterZoomNet(string netname) {
 	m_dx = (max.x - min.x) / 2 + min.x;
 	m_dy = (max.y - min.y) / 2 + min.y;
 	SetTarget(m_dx, m_dy);
-	m_needsRedraw = true;
 }
 
 void BoardView::CenterZoomSearchResults(void) {
@@ -2845,14 +2907,13 @@ void BoardView::CenterZoomSearchResults(void) {
 	}
 
 	for (auto &pp : m_partHighlighted) {
-		for (auto &pn : pp->pins) {
-			auto &p = pn->position;
-			if (p.x < min.x) min.x = p.x;
-			if (p.y < min.y) min.y = p.y;
-			if (p.x > max.x) max.x = p.x;
-			if (p.y > max.y) max.y = p.y;
-			i++;
-		}
+		auto stats = m_stats.OfPart(m_registry.PartId(pp.get()));
+		if (!stats || !stats->pins) continue;
+		if (stats->box.min.x < min.x) min.x = stats->box.min.x;
+		if (stats->box.min.y < min.y) min.y = stats->box.min.y;
+		if (stats->box.max.x > max.x) max.x = stats->box.max.x;
+		if (stats->box.max.y > max.y) max.y = stats->box.max.y;
+		i += stats->pins;
 	}
 
 	// Bounds check!
@@ -2874,7 +2935,6 @@ void BoardView::CenterZoomSearchResults(void) {
 	m_dx = (max.x - min.x) / 2 + min.x;
 	m_dy = (max.y - min.y) / 2 + min.y;
 	SetTarget(m_dx, m_dy);
-	m_needsRedraw = true;
 }
 
 /*
@@ -2884,216 +2944,87 @@ void BoardView::CenterZoomSearchResults(void) {
  */
 int BoardView::EPCCheck(void) {
 	int epc[2] = {0, 0};
-	int side;
 	auto &outline = m_board->OutlinePoints();
-	ImVec2 min, max;
-
-	// find the orthagonal bounding box
-	// probably can put this as a predefined
-	min.x = min.y = FLT_MAX;
-	max.x = max.y = FLT_MIN;
-	for (auto &p : outline) {
-		if (p->x < min.x) min.x = p->x;
-		if (p->y < min.y) min.y = p->y;
-		if (p->x > max.x) max.x = p->x;
-		if (p->y > max.y) max.y = p->y;
-	}
-
-	for (side = 0; side < 2; side++) {
-		for (auto &p : m_board->Pins()) {
-			// auto p = pin.get();
-			int l, r;
-			int jump = 1;
-			Point fp;
-
-			l = 0;
-			r = 0;
-
-			for (size_t i = 0; i < outline.size() - 1; i++) {
-				Point &pa = *outline[i];
-				Point &pb = *outline[i + 1];
-
-				// jump double/dud points
-				if (pa.x == pb.x && pa.y == pb.y) continue;
+	auto &pins    = m_board->Pins();
 
-				// if we encounter our hull/poly start point, then we've now created the
-				// closed
-				// hull, jump the next segment and reset the first-point
-				if ((!jump) && (fp.x == pb.x) && (fp.y == pb.y)) {
-					if (i < outline.size() - 2) {
-						fp   = *outline[i + 2];
-						jump = 1;
-						i++;
-					}
-				} else {
-					jump = 0;
-				}
-
-				// test to see if this segment makes the scan-cut.
-				if ((pa.y > pb.y && p->position.y < pa.y && p->position.y > pb.y) ||
-				    (pa.y < pb.y && p->position.y > pa.y && p->position.y < pb.y)) {
-					ImVec2 intersect;
-
-					intersect.y = p->position.y;
-					if (pa.x == pb.x)
-						intersect.x = pa.x;
-					else
-						intersect.x = (pb.x - pa.x) / (pb.y - pa.y) * (p->position.y - pa.y) + pa.x;
-
-					if (intersect.x > p->position.x)
-						r++;
-					else if (intersect.x < p->position.x)
-						l++;
-				}
-			} // if we did get an intersection
+	// the edge table makes each test a few edges, whatever the outline
+	m_boardOutline.Build(outline);
 
-			// If either side has no intersections, then it's out of bounds (likely)
-			if ((l % 2 == 0) && (r % 2 == 0)) epc[side]++;
-		} // pins
+	// testing a pin mirrored about the outline is the same as testing it against the flipped outline
+	float max_y = m_boardOutline.Max().y;
+	auto count  = [&](size_t from, size_t to, int *out) {
+		for (size_t i = from; i < to; i++) {
+			ImVec2 pos = pins[i]->position;
+			if (!m_boardOutline.Contains(pos)) out[0]++;
+			if (!m_boardOutline.Contains(ImVec2(pos.x, max_y - pos.y))) out[1]++;
+		}
+	};
 
-		if (debug) fprintf(stderr, "EPC[%d]: %d\n", side, epc[side]);
+	/*
+	 * Big boards get split up over the cores, the outline is read-only
+	 * here; small ones aren't worth handing to other threads.
+	 */
+	size_t workers = pins.size() < 65536 ? 1 : ParallelDraw::Workers(pins.size());
 
-		// flip the outline
-		for (auto &p : outline) p->y = max.y - p->y;
+	std::vector<std::array<int, 2>> partial(workers, {0, 0});
+	ParallelDraw::For(pins.size(), workers, [&](size_t w, size_t from, size_t to) { count(from, to, partial[w].data()); });
+	for (auto &c : partial) {
+		epc[0] += c[0];
+		epc[1] += c[1];
+	}
 
-	} // side
+	if (debug) fprintf(stderr, "EPC[0]: %d\nEPC[1]: %d\n", epc[0], epc[1]);
 
 	if ((epc[0] || epc[1]) && (epc[0] > epc[1])) {
-		for (auto &p : outline) p->y = max.y - p->y;
+		for (auto &p : outline) p->y = max_y - p->y;
+		m_boardOutline.Build(outline);
 	}
 
 	return 0;
 }
 
 /*
- * Experimenting to see how much CPU hit rescanning and
- * drawing the flood fill is (as pin-stripe) each time
- * as opposed to precalculated line list
- *
- * We also do this slightly differently, we ask for a
- * y-pixel delta and thickness of line
- *
+ * The board fill is the outline's triangulation, built once per board, so
+ * it costs the same whatever the zoom.  It used to be drawn as 1 pixel
+ * stripes boardFillSpacing pixels apart; the spacing now thins out the
+ * fill colour by as much, to keep the same overall shade.
  */
-void BoardView::OutlineGenFillDraw(ImDrawList *draw, int ydelta, double thickness = 1.0f) {
+void BoardView::DrawBoardFill(ImDrawList *draw) {
+	if (!boardFill || slowCPU || !m_governor.Fills()) return;
+	if (!m_file) return;
 
-	auto io = ImGui::GetIO();
-	vector<ImVec2> scanhits;
-	auto &outline = m_board->OutlinePoints();
-	static ImVec2 min, max; // board min/max points
-	                        //	double steps = 500;
-	double vdelta;
-	double y, ystart, yend;
+	if (!m_boardOutline.Built()) m_boardOutline.Build(m_board->OutlinePoints());
 
-	if (!boardFill || slowCPU) return;
-	if (!m_file) return;
+	auto &points = m_boardOutline.Points();
+	auto &fill   = m_boardOutline.FillIndices();
+	if (fill.empty()) return;
 
-	scanhits.reserve(20);
+	uint32_t color = m_colors.boardFillColor;
+	if (boardFillSpacing > 1) color = (color & 0x00ffffff) | (((color >> 24) / boardFillSpacing) << 24);
 
 	draw->ChannelsSetCurrent(kChannelFill);
 
-	// find the orthagonal bounding box
-	// probably can put this as a predefined
-	if (!boardMinMaxDone) {
-		min.x = min.y = 100000000000;
-		max.x = max.y = -100000000000;
-		for (auto &p : outline) {
-			if (p->x < min.x) min.x = p->x;
-			if (p->y < min.y) min.y = p->y;
-			if (p->x > max.x) max.x = p->x;
-			if (p->y > max.y) max.y = p->y;
-		}
-		boardMinMaxDone = true;
-	}
+	m_coordScratch.resize(points.size());
+	CoordToScreen(points.data(), m_coordScratch.data(), points.size());
 
-	// Get the viewport limits, so we don't waste time scanning what we don't need
-	ImVec2 vpa = ScreenToCoord(0, 0);
-	ImVec2 vpb = ScreenToCoord(io.DisplaySize);
+	ImVec2 uv      = ImGui::GetFontTexUvWhitePixel();
+	ImDrawIdx base = draw->_VtxCurrentIdx;
+	draw->PrimReserve(fill.size(), points.size());
 
-	if (vpa.y > vpb.y) {
-		ystart = vpb.y;
-		yend   = vpa.y;
-	} else {
-		ystart = vpa.y;
-		yend   = vpb.y;
+	ImDrawVert *vtx = draw->_VtxWritePtr;
+	for (auto &p : m_coordScratch) {
+		vtx->pos = p;
+		vtx->uv  = uv;
+		vtx->col = color;
+		vtx++;
 	}
+	draw->_VtxWritePtr = vtx;
 
-	if (ystart < min.y) ystart = min.y;
-	if (yend > max.y) yend = max.y;
-
-	//	vdelta = (ystart - yend) / steps;
-
-	vdelta = ydelta / m_scale;
-
-	/*
-	 * Go through each scan line
-	 */
-	y = ystart;
-	while (y < yend) {
-
-		scanhits.resize(0);
-		// scan outline segments to see if any intersect with our horizontal scan line
-
-		/*
-		 * While we haven't yet exhausted possible scan hits
-		 */
-
-		{
-
-			int jump = 1;
-			Point fp;
-
-			auto &outline = m_board->OutlinePoints();
-
-			// set our initial draw point, so we can detect when we encounter it again
-			fp = *outline[0];
-
-			for (size_t i = 0; i < outline.size() - 1; i++) {
-				Point &pa = *outline[i];
-				Point &pb = *outline[i + 1];
-
-				// jump double/dud points
-				if (pa.x == pb.x && pa.y == pb.y) continue;
-
-				// if we encounter our hull/poly start point, then we've now created the
-				// closed
-				// hull, jump the next segment and reset the first-point
-				if ((!jump) && (fp.x == pb.x) && (fp.y == pb.y)) {
-					if (i < outline.size() - 2) {
-						fp   = *outline[i + 2];
-						jump = 1;
-						i++;
-					}
-				} else {
-					jump = 0;
-				}
-
-				// test to see if this segment makes the scan-cut.
-				if ((pa.y > pb.y && y < pa.y && y > pb.y) || (pa.y < pb.y && y > pa.y && y < pb.y)) {
-					ImVec2 intersect;
-
-					intersect.y = y;
-					if (pa.x == pb.x)
-						intersect.x = pa.x;
-					else
-						intersect.x = (pb.x - pa.x) / (pb.y - pa.y) * (y - pa.y) + pa.x;
-					scanhits.push_back(intersect);
-				}
-			} // if we did get an intersection
-
-			sort(scanhits.begin(), scanhits.end(), [](ImVec2 const &a, ImVec2 const &b) { return a.x < b.x; });
+	ImDrawIdx *idx = draw->_IdxWritePtr;
+	for (int i : fill) *idx++ = base + i;
+	draw->_IdxWritePtr = idx;
 
-			// now finally generate the lines.
-			{
-				int i = 0;
-				int l = scanhits.size() - 1;
-				for (i = 0; i < l; i += 2) {
-					draw->AddLine(
-					    CoordToScreen(scanhits[i].x, y), CoordToScreen(scanhits[i + 1].x, y), m_colors.boardFillColor, thickness);
-				}
-			}
-		}
-		y += vdelta;
-	} // for each scan line
+	draw->_VtxCurrentIdx += points.size();
 }
 
 void BoardView::DrawDiamond(ImDrawList *draw, ImVec2 c, double r, uint32_t color) {
@@ -3125,53 +3056,30 @@ void BoardView::DrawHex(ImDrawList *draw, ImVec2 c, double r, uint32_t color) {
 }
 
 inline void BoardView::DrawOutline(ImDrawList *draw) {
-	int jump = 1;
-	Point fp;
+	if (!m_boardOutline.Built()) m_boardOutline.Build(m_board->OutlinePoints());
 
-	auto &outline = m_board->OutlinePoints();
-	if (outline.empty()) {
+	auto &points = m_boardOutline.Points();
+	if (points.empty()) {
 		return;
 	}
 
 	draw->ChannelsSetCurrent(kChannelPolylines);
 
-	// set our initial draw point, so we can detect when we encounter it again
-	fp = *outline[0];
-
-	draw->PathClear();
-	for (size_t i = 0; i < outline.size() - 1; i++) {
-		Point &pa = *outline[i];
-		Point &pb = *outline[i + 1];
-
-		// jump double/dud points
-		if (pa == pb) continue;
-
-		// if we encounter our hull/poly start point, then we've now created the
-		// closed
-		// hull, jump the next segment and reset the first-point
-		if (!jump && fp == pb) {
-			if (i < outline.size() - 2) {
-				fp   = *outline[i + 2];
-				jump = 1;
-				i++;
-			}
-		} else {
-			jump = 0;
-		}
+	/*
+	 * If we have a pin selected, we mask off the colour to shade out
+	 * things and make it easier to see associated pins/points
+	 */
+	uint32_t color = m_colors.boardOutlineColor;
+	if ((pinSelectMasks) && (m_pinSelected || m_pinHighlighted.size())) {
+		color = (m_colors.boardOutlineColor & m_colors.selectedMaskOutline) | m_colors.orMaskOutline;
+	}
 
-		ImVec2 spa = CoordToScreen(pa);
-		ImVec2 spb = CoordToScreen(pb);
+	m_coordScratch.resize(points.size());
+	CoordToScreen(points.data(), m_coordScratch.data(), points.size());
 
-		/*
-		 * If we have a pin selected, we mask off the colour to shade out
-		 * things and make it easier to see associated pins/points
-		 */
-		if ((pinSelectMasks) && (m_pinSelected || m_pinHighlighted.size())) {
-			draw->AddLine(spa, spb, (m_colors.boardOutlineColor & m_colors.selectedMaskOutline) | m_colors.orMaskOutline);
-		} else {
-			draw->AddLine(spa, spb, m_colors.boardOutlineColor);
-		}
-	} // for
+	for (auto &loop : m_boardOutline.Loops()) {
+		draw->AddPolyline(&m_coordScratch[loop.start], loop.count, color, loop.closed, 1.0f);
+	}
 }
 
 void BoardView::DrawNetWeb(ImDrawList *draw) {
@@ -3185,42 +3093,59 @@ void BoardView::DrawNetWeb(ImDrawList *draw) {
 	if (m_pinSelected->type == Pin::kPinTypeUnkown) return;
 	if (m_pinSelected->net->is_ground) return;
 
-	for (auto &p : m_board->Pins()) {
+	Net &net         = *m_pinSelected->net;
+	ViewTransform xf = CoordTransform();
 
-		if (p->net == m_pinSelected->net) {
-			uint32_t col = m_colors.pinNetWebColor;
-			if (!BoardElementIsVisible(p->component)) {
-				col = m_colors.pinNetWebOSColor;
-				draw->AddCircle(CoordToScreen(p->position), p->diameter * m_scale, col, 16);
-			}
+	m_webLines.clear();
+	m_webMarks.clear();
+
+	// pins whose part is on the side not shown get ringed, and the lines to them drawn in another colour
+	m_webVisible.resize(net.pins.size());
+	for (size_t i = 0; i < net.pins.size(); i++) {
+		auto &p         = net.pins[i];
+		m_webVisible[i] = BoardElementIsVisible(p->component);
+		if (!m_webVisible[i]) m_webMarks.push_back({xf.Apply(p->position), p->diameter * m_scale});
+	}
 
-			draw->AddLine(CoordToScreen(m_pinSelected->position),
-			              CoordToScreen(p->position),
-			              ImColor(col),
-			              netWebThickness);
+	if (netWebRatsnest) {
+		for (auto &e : m_netWeb.Tree(net)) {
+			uint32_t col = m_webVisible[e.a] && m_webVisible[e.b] ? m_colors.pinNetWebColor : m_colors.pinNetWebOSColor;
+			m_webLines.push_back({xf.Apply(net.pins[e.a]->position), xf.Apply(net.pins[e.b]->position), col});
+		}
+	} else {
+		ImVec2 from = xf.Apply(m_pinSelected->position);
+		for (size_t i = 0; i < net.pins.size(); i++) {
+			uint32_t col = m_webVisible[i] ? m_colors.pinNetWebColor : m_colors.pinNetWebOSColor;
+			m_webLines.push_back({from, xf.Apply(net.pins[i]->position), col});
 		}
 	}
 
+	/*
+	 * Thousands of lines on a big rail mostly land on top of each other,
+	 * only one of each bunch ending in the same couple of screen cells
+	 * gets drawn.
+	 */
+	float cell = std::max(netWebThickness * 2.0f, 2.0f);
+	MergeWebLines(m_webLines, cell, kMaxNetWebLines);
+	MergeWebMarks(m_webMarks, cell);
+
+	for (auto &m : m_webMarks) draw->AddCircle(m.pos, m.r, m_colors.pinNetWebOSColor, 16);
+	for (auto &l : m_webLines) draw->AddLine(l.a, l.b, l.color, netWebThickness);
+
 	return;
 }
 
 void BoardView::DrawNodes(ImDrawList * draw) {
-	std::lock_guard lck(m_DrawNodes_mutex);
-	float stub_len = m_pinDiameter;
-	for (auto n : m_board->Nodes()) {
-		if (bool(m_current_side) != n->top) {
-			if (n->stub) {
-				ImVec2 v = n->p1 - n->p2;
-				float deg;
-				if (v.y == 0) {
-					deg = 0;
-				} else {
-					deg = atanf(v.x / v.y);
-				}
-				draw->AddLine(CoordToScreen(n->p1), CoordToScreen({ n->p1.x + cosf(deg) * stub_len, n->p1.y + sin(deg) * stub_len }), m_colors.pinDefaultColor, 3);
-			} else {
-				draw->AddLine(CoordToScreen(n->p1), CoordToScreen(n->p2), m_colors.pinDefaultColor, 3);
-			}
+	// whatever the scripts have published so far, see NodeOverlay
+	auto nodes = m_nodes.Snapshot();
+	if (!nodes) return;
+
+	ViewTransform xf = CoordTransform();
+	float stub_len   = m_pinDiameter;
+	for (auto &chunk : nodes->sides[m_current_side ? 1 : 0]) {
+		for (auto &n : chunk->lines) {
+			ImVec2 p2 = n.stub ? ImVec2(n.p1.x + n.p2.x * stub_len, n.p1.y + n.p2.y * stub_len) : n.p2;
+			draw->AddLine(xf.Apply(n.p1), xf.Apply(p2), m_colors.pinDefaultColor, 3);
 		}
 	}
 }
@@ -3234,20 +3159,8 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 
 	if (!showPins) return;
 
-	auto apply_shade = [] (uint32_t c, uint32_t s, float i) {
-		uint32_t cc = c;
-		if (s) {
-			cc = s;
-		}
-		auto f = [i, cc] (int sh) {
-			uint32_t ret = (cc >> sh & 0xff) * i;
-			if (ret > 255) return uint32_t(255) << sh;
-			return ret << sh;
-		};
+	ViewTransform xf = CoordTransform();
 
-		return f(0) | f(8) | f(16) | f(24);
-	};
-	
 	/*
 	 * If we have a pin selected, then it makes it
 	 * easier to see where the associated pins are
@@ -3272,134 +3185,125 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 
 	// e__l
 	BBox coord_vis = ScreenToCoord(m_board_surface_active);
+	// the pins layer gets re-used while panning, so take in some margin
+	ImVec2 coord_margin = coord_vis.dim() * m_cullMargin;
+	coord_vis.min -= coord_margin;
+	coord_vis.max += coord_margin;
 	//coord_vis.min -= dual_draw_offset;
 	//coord_vis.max -= dual_draw_offset;
 	//std::cerr << dual_draw_side2 << " " << coord_vis.min << " " << coord_vis.max << "\n";
-	
-	for (auto &pin : m_board->Pins()) {
-		float psz           = pin->diameter * m_scale;
-		uint32_t fill_color = 0xFFFF8888; // fallback fill colour
-		uint32_t text_color = m_colors.pinDefaultTextColor;
-		uint32_t color      = (m_colors.pinDefaultColor & cmask) | omask;
-		bool fill_pin       = false;
-		bool show_text      = false;
-		bool draw_ring      = true;
-
-		// continue if pin is not visible anyway
-		if (!BoardElementIsVisible(pin)) continue;
-
-		if (!coord_vis.contains(pin->position, psz))
-			continue;
-		
-		ImVec2 pos = CoordToScreen(pin->position);
-		if (false)
-		{
-			if (!IsVisibleScreen(pos.x, pos.y, psz, io)) continue;
+
+	/*
+	 * Pin level-of-detail.  Once the typical pin drops below
+	 * pinLODThreshold pixels the plain pins are replaced by the
+	 * density tiles, from twice that size up they're drawn one by
+	 * one, and in between the two are cross-faded so zooming in or
+	 * out doesn't pop.  Pins that are emphasised (selection, search
+	 * results, ...) are always drawn individually.
+	 *
+	 * The tiles need the pin diameters which DrawParts() only works
+	 * out on the first pass, hence building them here.
+	 */
+	float lod_alpha     = 1.0f;
+	float lod_threshold = m_governor.LODThreshold(pinLOD ? pinLODThreshold : 0.0f);
+	if (lod_threshold > 0.0f) {
+		if (!m_pinDensity.Built()) m_pinDensity.Build(m_board->Pins());
+
+		if (m_pinDensity.TypicalDiameter() > 0.0f) {
+			float typical_psz = m_pinDensity.TypicalDiameter() * m_scale;
+
+			lod_alpha = (typical_psz - lod_threshold) / lod_threshold;
+			if (lod_alpha < 0.0f) lod_alpha = 0.0f;
+			if (lod_alpha > 1.0f) lod_alpha = 1.0f;
+			if (lod_alpha < 1.0f) DrawPinDensity(draw, coord_vis, (m_colors.pinDefaultColor & cmask) | omask, 1.0f - lod_alpha);
 		}
+	}
 
-		if ((!m_pinSelected) && (psz < threshold)) continue;
+	auto lod_fade = [lod_alpha] (uint32_t c) {
+		return (c & 0x00ffffff) | (uint32_t((c >> 24) * lod_alpha) << 24);
+	};
 
-		// color & text depending on app state & pin type
+	// pin shapes get collected here and written out in one go after the loop
+	m_pinGlyphs.Build(ImGui::GetStyle().AntiAliasedLines);
+	m_pinStamps.clear();
+	m_pinLabels.clear();
+	auto stamp = [this] (const PinGlyph &glyph, ImVec2 pos, float r, uint32_t color) {
+		m_pinStamps.push_back({pos, r, color, &glyph});
+	};
 
-		{
-			/*
-			 * Pins resulting from a net search
-			 */
-			if (contains(pin, m_pinHighlighted)) {
-				if (psz < fontSize / 2) psz = fontSize / 2;
-				text_color = m_colors.pinSelectedTextColor;
-				fill_color = m_colors.pinSelectedFillColor;
-				color      = m_colors.pinSelectedColor;
-				// text_color = color = m_colors.pinSameNetColor;
-				fill_pin  = true;
-				show_text = true;
-				draw_ring = true;
-				threshold = 0;
-				//				draw->AddCircle(ImVec2(pos.x, pos.y), psz * pinHaloDiameter, ImColor(0xff0000ff), 32);
-			}
+	/*
+	 * Only the pins seen from the side this view shows, in the grid cells
+	 * under the surface, get looked at (see PinGrid).  Culling those is
+	 * split over the cores on big boards.  The pins that are left get
+	 * gone through in board order below, the size threshold and the
+	 * labels depend on it.
+	 */
+	auto &pins = m_board->Pins();
+	if (!m_pinGrid.Built()) m_pinGrid.Build(pins);
 
-			/*
-			 * If the part is selected, as part of search or otherwise
-			 */
-			if (PartIsHighlighted(pin->component)) {
-				color      = m_colors.pinDefaultColor;
-				text_color = m_colors.pinDefaultTextColor;
-				fill_pin   = false;
-				draw_ring  = true;
-				show_text  = true;
-				threshold  = 0;
-			}
+	BBox query      = coord_vis;
+	float pin_reach = m_pinGrid.MaxDiameter() * m_scale;
+	query.min -= ImVec2(pin_reach, pin_reach);
+	query.max += ImVec2(pin_reach, pin_reach);
 
-			if (pin->type == Pin::kPinTypeTestPad) {
-				color      = (m_colors.pinTestPadColor & cmask) | omask;
-				fill_color = (m_colors.pinTestPadFillColor & cmask) | omask;
-				show_text  = false;
-			}
+	int shown_side = m_current_side;
+	if (dual_draw_side2) shown_side = m_current_side == kBoardSideTop ? kBoardSideBottom : kBoardSideTop;
+	m_pinGrid.Query(shown_side, query, m_pinCandidates);
 
-			// If the part itself is highlighted ( CVMShowPins )
-			// if (p_pin->component->visualmode == p_pin->component->CVMSelected) {
-			if (pin->component->visualmode == pin->component->CVMSelected) {
-				color      = m_colors.pinDefaultColor;
-				text_color = m_colors.pinDefaultTextColor;
-				fill_pin   = false;
-				draw_ring  = true;
-				show_text  = true;
-				threshold  = 0;
-			}
+	size_t workers           = ParallelDraw::Workers(m_pinCandidates.size());
+	bool anything_emphasised = m_pinSelected || !m_pinHighlighted.empty() || !m_partHighlighted.empty();
 
-			if (!pin->net || pin->type == Pin::kPinTypeNotConnected) {
-				color = (m_colors.pinNotConnectedColor & cmask) | omask;
-			} else {
-				if (pin->net->is_ground) color = (m_colors.pinGroundColor & cmask) | omask;
-			}
+	m_visiblePins.resize(workers);
+	ParallelDraw::For(m_pinCandidates.size(), workers, [&](size_t w, size_t from, size_t to) {
+		auto &visible = m_visiblePins[w];
+		visible.clear();
 
-			// pin is on the same net as selected pin: highlight > rest
-			if (m_pinSelected && pin->net == m_pinSelected->net) {
-				if (psz < fontSize / 2) psz = fontSize / 2;
-				color      = m_colors.pinSameNetColor;
-				text_color = m_colors.pinSameNetTextColor;
-				fill_color = m_colors.pinSameNetFillColor;
-				draw_ring  = false;
-				fill_pin   = true;
-				show_text  = true; // is this something we want? Maybe an optional thing?
-				threshold  = 0;
-			}
+		for (size_t i = from; i < to; i++) {
+			auto &pin = pins[m_pinCandidates[i]];
+			float psz = pin->diameter * m_scale;
 
-			// pin selected overwrites everything
-			// if (p_pin == m_pinSelected) {
-			if (pin == m_pinSelected) {
-				if (psz < fontSize / 2) psz = fontSize / 2;
-				color      = m_colors.pinSelectedColor;
-				text_color = m_colors.pinSelectedTextColor;
-				fill_color = m_colors.pinSelectedFillColor;
-				draw_ring  = false;
-				show_text  = true;
-				fill_pin   = true;
-				threshold  = 0;
-			}
+			// fully covered by the density tiles, and nothing could bring it forward
+			if (lod_alpha <= 0.0f && !anything_emphasised && pin->component->visualmode != Component::CVMSelected) continue;
 
-			// Check for BGA pin '1'
-			//
-			if (pin->name == "A1") {
-				color = fill_color = m_colors.pinA1PadColor;
-				fill_pin           = m_colors.pinA1PadColor;
-				draw_ring          = false;
-			}
+			if (!coord_vis.contains(pin->position, psz)) continue;
 
-			if ((pin->number == "1")) {
-				if (pin->component->pins.size() >= static_cast<unsigned int>(pinA1threshold)) { // pinA1threshold is never negative
-					color = fill_color = m_colors.pinA1PadColor;
-					fill_pin           = m_colors.pinA1PadColor;
-					draw_ring          = false;
-				}
-			}
+			visible.push_back({pin.get(), xf.Apply(pin->position)});
+		}
+	});
+
+	auto &visible_pins = m_visiblePins[0];
+	for (size_t w = 1; w < workers; w++) visible_pins.insert(visible_pins.end(), m_visiblePins[w].begin(), m_visiblePins[w].end());
 
-			// don't show text if it doesn't make sense
-			if (pin->component->pins.size() <= 1) show_text = false;
-			if (pin->type == Pin::kPinTypeTestPad) show_text = false;
+	for (auto &visible : visible_pins) {
+		Pin *pin   = visible.pin;
+		ImVec2 pos = visible.pos;
+		float psz  = pin->diameter * m_scale;
+
+		if (false)
+		{
+			if (!IsVisibleScreen(pos.x, pos.y, psz, io)) continue;
 		}
 
-		color = apply_shade(color, 0, pin->intensity_delta_ * m_default_intensity);
+		if ((!m_pinSelected) && (psz < threshold)) continue;
+
+		// color & text depending on app state & pin type, see ComputePinStyle()
+		const PinStyle &style = m_pinStyles[pin->style_index_];
+		uint32_t color        = style.color;
+		uint32_t fill_color   = style.fill_color;
+		uint32_t text_color   = style.text_color;
+		bool fill_pin         = style.flags & kPinStyleFill;
+		bool show_text        = style.flags & kPinStyleText;
+		bool draw_ring        = style.flags & kPinStyleRing;
+		bool emphasised       = style.flags & kPinStyleEmphasised;
+
+		if (emphasised) threshold = 0;
+		if ((style.flags & kPinStyleEnlarge) && (psz < fontSize / 2)) psz = fontSize / 2;
+
+		if (!emphasised && lod_alpha < 1.0f) {
+			if (lod_alpha <= 0.0f) continue;
+			color      = lod_fade(color);
+			fill_color = lod_fade(fill_color);
+		}
 		
 		// Drawing
 		{
@@ -3411,6 +3315,7 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			segments = round(psz);
 			if (segments > 32) segments = 32;
 			if (segments < 8) segments = 8;
+			segments = m_governor.MaxSegments(segments);
 			float h = psz / 2 + 0.5f;
 
 			/*
@@ -3423,25 +3328,26 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			switch (pin->type) {
 				case Pin::kPinTypeTestPad:
 					if ((psz > 3) && (!slowCPU)) {
-						draw->AddCircleFilled(ImVec2(pos.x, pos.y), psz, fill_color, segments);
-						draw->AddCircle(ImVec2(pos.x, pos.y), psz, color, segments);
+						stamp(m_pinGlyphs.Disc(segments), pos, psz, fill_color);
+						stamp(m_pinGlyphs.Ring(segments), pos, psz, color);
 					} else if (psz > threshold) {
-						draw->AddRectFilled(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), fill_color);
+						stamp(m_pinGlyphs.Square(), pos, h, fill_color);
 					}
 					break;
 				default:
 					if ((psz > 3) && (psz > threshold)) {
-						if (pinShapeSquare || slowCPU) {
-							if (fill_pin)
-								draw->AddRectFilled(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), fill_color);
-							if (draw_ring) draw->AddRect(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), color);
+						// small enough that a circle can't be told apart from a square anyway
+						bool lod_square = psz < lod_threshold * 3;
+						if (pinShapeSquare || slowCPU || lod_square) {
+							if (fill_pin) stamp(m_pinGlyphs.Square(), pos, h, fill_color);
+							if (draw_ring) stamp(m_pinGlyphs.SquareRing(), pos, h, color);
 						} else {
-							if (fill_pin) draw->AddCircleFilled(ImVec2(pos.x, pos.y), psz, fill_color, segments);
-							if (draw_ring) draw->AddCircle(ImVec2(pos.x, pos.y), psz, color, segments);
+							if (fill_pin) stamp(m_pinGlyphs.Disc(segments), pos, psz, fill_color);
+							if (draw_ring) stamp(m_pinGlyphs.Ring(segments), pos, psz, color);
 						}
 					} else if (psz > threshold) {
-						if (fill_pin) draw->AddRectFilled(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), fill_color);
-						if (draw_ring) draw->AddRect(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), color);
+						if (fill_pin) stamp(m_pinGlyphs.Square(), pos, h, fill_color);
+						if (draw_ring) stamp(m_pinGlyphs.SquareRing(), pos, h, color);
 					}
 			}
 
@@ -3456,15 +3362,68 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			//		}
 
 			if (show_text) {
-				ImVec2 text_size = ImGui::CalcTextSize(pin->name.c_str());
-				ImVec2 pos_adj   = ImVec2(pos.x - text_size.x * 0.5f, pos.y - text_size.y * 0.5f);
+				const Label &label = m_labelCache.Get(pin->name);
+				ImVec2 pos_adj     = ImVec2(pos.x - label.size.x * 0.5f, pos.y - label.size.y * 0.5f);
 
-				draw->ChannelsSetCurrent(kChannelText);
-				draw->AddText(pos_adj, text_color, pin->name.c_str());
-				draw->ChannelsSetCurrent(kChannelPins);
+				// the selected pin's label first, then those of other emphasised pins
+				m_pinLabels.push_back({pos_adj, &label, text_color, pin == m_pinSelected.get() ? 2 : emphasised ? 1 : 0});
 			}
 		}
 	}
+
+	PinGlyphs::Stamp(draw, m_pinStamps);
+
+	/*
+	 * Labels go in by priority, each one only if it's clear of those
+	 * already placed, rather than piling up unreadably on dense parts.
+	 */
+	std::stable_sort(m_pinLabels.begin(), m_pinLabels.end(), [](const LabelRequest &a, const LabelRequest &b) {
+		return a.priority > b.priority;
+	});
+
+	draw->ChannelsSetCurrent(kChannelText);
+	m_labelPlacer.Reset(fontSize * 2);
+	size_t labels_left = m_governor.MaxLabels();
+	for (auto &l : m_pinLabels) {
+		if (!labels_left) break;
+		if (labelCulling && !m_labelPlacer.Place(l.pos, l.pos + l.label->size)) continue;
+		LabelCache::Emit(draw, *l.label, l.pos, l.color);
+		labels_left--;
+	}
+	draw->ChannelsSetCurrent(kChannelPins);
+}
+
+/*
+ * Paints the pin density tiles of the currently shown side, used in place
+ * of the individual pins when they're too small to make out on screen.
+ */
+void BoardView::DrawPinDensity(ImDrawList *draw, BBox const &coord_vis, uint32_t color, float alpha) {
+	const PinDensityLevel *level = m_pinDensity.LevelFor(m_scale, DPIF(4.0f));
+	if (!level) return;
+
+	int side      = dual_draw_side2 ? !m_current_side : m_current_side;
+	ImVec2 origin = m_pinDensity.Origin();
+	float tile    = level->tile;
+
+	int c0 = std::max(0, int((coord_vis.min.x - origin.x) / tile));
+	int r0 = std::max(0, int((coord_vis.min.y - origin.y) / tile));
+	int c1 = std::min(level->cols - 1, int((coord_vis.max.x - origin.x) / tile));
+	int r1 = std::min(level->rows - 1, int((coord_vis.max.y - origin.y) / tile));
+
+	float base_alpha = (color >> 24) * alpha;
+	color &= 0x00ffffff;
+
+	ViewTransform xf = CoordTransform();
+
+	for (int r = r0; r <= r1; r++) {
+		for (int c = c0; c <= c1; c++) {
+			uint32_t a = level->at(side, c, r) * base_alpha;
+			if (!a) continue;
+
+			ImVec2 p(origin.x + c * tile, origin.y + r * tile);
+			draw->AddRectFilled(xf.Apply(p), xf.Apply(ImVec2(p.x + tile, p.y + tile)), color | (a << 24));
+		}
+	}
 }
 
 bool BoardView::DrawPartSymbol(ImDrawList * draw, Component * c) {
@@ -3473,23 +3432,8 @@ bool BoardView::DrawPartSymbol(ImDrawList * draw, Component * c) {
 		return { ret.x * cosf(angle) - ret.y * sinf(angle), ret.x * sinf(angle) + ret.y * cosf(angle) };
 	};
 
-	auto apply_shade = [] (uint32_t c, uint32_t s, float i) {
-		uint32_t cc = c;
-		if (s) {
-			cc = s;
-		}
-		auto f = [i, cc] (int sh) {
-			uint32_t ret = (cc >> sh & 0xff) * i;
-			if (ret > 255) return uint32_t(255) << sh;
-			return ret << sh;
-		};
-
-		return f(0) | f(8) | f(16) | f(24);
-	};
-
-	
 	const float PI = M_PI;
-	uint32_t color = apply_shade(0xff666666, c->shade_color_, m_default_intensity * c->intensity_delta_);
+	uint32_t color = m_partStyles[c->style_index_].symbol;
 	float thick = 5;
 	
 	if (c->pins.size() == 2) {
@@ -3537,7 +3481,7 @@ bool BoardView::DrawPartSymbol(ImDrawList * draw, Component * c) {
 			}
 			return true;
 		} else if (c->component_type == Component::kComponentTypeResistor || c->name[0] == 'R' || c->name[1] == 'R') {
-			static int npeaks = 5;
+			int npeaks = 5;
 			
 			if (npeaks == 0) {
 				npeaks = 1;
@@ -3630,35 +3574,17 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 	double angle;
 	double distance = 0;
 	struct ImVec2 pva[2000], *ppp;
-	uint32_t color = m_colors.partOutlineColor;
 	//	int rendered   = 0;
 	char p0, p1; // first two characters of the part name, code-writing
 	             // convenience more than anything else
+	ViewTransform xf = CoordTransform();
 
-	auto apply_shade = [] (uint32_t c, uint32_t s, float i) {
-		uint32_t cc = c;
-		if (s) {
-			cc = s;
-		}
-		auto f = [i, cc] (int sh) {
-			uint32_t ret = (cc >> sh & 0xff) * i;
-			if (ret > 255) return uint32_t(255) << sh;
-			return ret << sh;
-		};
-
-		return f(0) | f(8) | f(16) | f(24);
-	};
-	
+	m_labelPlacer.Reset(fontSize * 4);
 
 	draw->ChannelsSetCurrent(kChannelPolylines);
-	/*
-	 * If a pin has been selected, we mask out the colour to
-	 * enhance (relatively) the appearance of the pin(s)
-	 */
-	if (pinSelectMasks && ((m_pinSelected) || m_pinHighlighted.size())) {
-		color = (m_colors.partOutlineColor & m_colors.selectedMaskParts) | m_colors.orMaskParts;
-	}
 
+	m_visibleParts.clear();
+	bool outlines_done = false;
 	for (auto &part : m_board->Components()) {
 		int pincount = 0;
 		double min_x, min_y, max_x, max_y, aspect;
@@ -3680,13 +3606,10 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 			ppp = &pva[0];
 			if (part->pins.size() == 0) {
 				if (debug) fprintf(stderr, "WARNING: Drawing empty part %s\n", part->name.c_str());
-				draw->AddRect(CoordToScreen(part->p1.x + DPIF(10), part->p1.y + DPIF(10)),
-				              CoordToScreen(part->p2.x - DPIF(10), part->p2.y - DPIF(10)),
-				              0xff0000ff);
-				draw->AddText(
-				    CoordToScreen(part->p1.x + DPIF(10), part->p1.y - DPIF(50)), m_colors.partTextColor, part->name.c_str());
+				m_visibleParts.push_back(part.get()); // drawn with the rest below
 				continue;
 			}
+			outlines_done = true;
 
 			for (auto &pin : part->pins) {
 				pincount++;
@@ -3997,26 +3920,48 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 
 		if (!BoardElementIsVisible(part)) continue;
 
-		if (part->outline_done) {
+		if (part->outline_done) m_visibleParts.push_back(part.get());
+	} // for each part
+	if (outlines_done) m_picker.Clear();
 
-			auto f = [this] (ImVec2 const & v) {
-				return CoordToScreen(v);
-			};
-			ImVec2 * p = part->outline;
-			ImVec2 a = f(p[0]), b = f(p[1]), c = f(p[2]), d = f(p[3]);
+	/*
+	 * The part geometry can be built on several threads, see ParallelDraw.
+	 * The labels are placed afterwards in board order, they're in their
+	 * own channel so that doesn't change what ends up where.
+	 */
+	m_partsDraw.Run(draw, m_visibleParts.size(), [&](ImDrawList *list, size_t from, size_t to) {
+		std::vector<ImVec2> hull;
+
+		for (size_t i = from; i < to; i++) {
+			Component *part = m_visibleParts[i];
+
+			if (!part->outline_done) {
+				list->AddRect(CoordToScreen(part->p1.x + DPIF(10), part->p1.y + DPIF(10)),
+				              CoordToScreen(part->p2.x - DPIF(10), part->p2.y - DPIF(10)),
+				              0xff0000ff);
+				list->AddText(
+				    CoordToScreen(part->p1.x + DPIF(10), part->p1.y - DPIF(50)), m_colors.partTextColor, part->name.c_str());
+				continue;
+			}
+
+			const PartStyle &style = m_partStyles[part->style_index_];
+
+			ImVec2 q[4];
+			xf.Apply(part->outline, q, 4);
+			ImVec2 a = q[0], b = q[1], c = q[2], d = q[3];
 
 			/*
 			 * Draw the bounding box for the part
 			 */
 
-			// if (fillParts) draw->AddQuadFilled(a, b, c, d, color & 0xffeeeeee);
-			if (! DrawPartSymbol(draw, part.get())) {
+			// if (fillParts) list->AddQuadFilled(a, b, c, d, color & 0xffeeeeee);
+			if (! DrawPartSymbol(list, part)) {
 				
-				if (fillParts && !slowCPU) draw->AddQuadFilled(a, b, c, d, apply_shade(m_colors.partFillColor, part->shade_color_, part->intensity_delta_ * m_default_intensity));
-				draw->AddQuad(a, b, c, d, apply_shade(color, 0, part->intensity_delta_ * m_default_intensity));
-				if (PartIsHighlighted(part)) {
-					if (fillParts && !slowCPU) draw->AddQuadFilled(a, b, c, d, m_colors.partHighlightedFillColor);
-					draw->AddQuad(a, b, c, d, apply_shade(m_colors.partHighlightedColor, part->shade_color_, part->intensity_delta_ * m_default_intensity));
+				if (fillParts && !slowCPU && m_governor.Fills()) list->AddQuadFilled(a, b, c, d, style.fill);
+				list->AddQuad(a, b, c, d, style.outline);
+				if (style.highlighted) {
+					if (fillParts && !slowCPU && m_governor.Fills()) list->AddQuadFilled(a, b, c, d, m_colors.partHighlightedFillColor);
+					list->AddQuad(a, b, c, d, style.highlighted_outline);
 				}
 			}
 
@@ -4024,13 +3969,9 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 			 * Draw the convex hull of the part if it has one
 			 */
 			if (part->hull) {
-				int i;
-				draw->PathClear();
-				for (i = 0; i < part->hull_count; i++) {
-					ImVec2 p = CoordToScreen(part->hull[i]);
-					draw->PathLineTo(p);
-				}
-				draw->PathStroke(m_colors.partHullColor, true, 1.0f);
+				hull.resize(part->hull_count);
+				xf.Apply(part->hull, hull.data(), part->hull_count);
+				list->AddPolyline(hull.data(), part->hull_count, m_colors.partHullColor, true, 1.0f);
 			}
 
 #if 0
@@ -4042,7 +3983,7 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 					int segments = trunc(part->expanse);
 					if (segments < 8) segments = 8;
 					if (segments > 36) segments = 36;
-					draw->AddCircle(CoordToScreen(part->centerpoint.x, part->centerpoint.y),
+					list->AddCircle(CoordToScreen(part->centerpoint.x, part->centerpoint.y),
 					                (part->expanse / 3) * m_scale,
 					                m_colors.partOutlineColor & 0x8fffffff,
 					                segments);
@@ -4050,48 +3991,69 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 			}
 #endif
 			
-			/*
-			 * Draw the text associated with the box or pins if required
-			 */
-			if (PartIsHighlighted(part) && !part->is_dummy() && !part->name.empty()) {
-				std::string text  = part->name;
-				std::string mcode = part->mfgcode;
+		}
+	});
 
-				ImVec2 text_size    = ImGui::CalcTextSize(text.c_str());
-				ImVec2 mfgcode_size = ImGui::CalcTextSize(mcode.c_str());
+	size_t labels_left = m_governor.MaxLabels();
+	for (Component *part : m_visibleParts) {
+		if (!part->outline_done) continue;
+		if (!labels_left) break;
 
-				if ((!showInfoPanel) && (mfgcode_size.x > text_size.x)) text_size.x = mfgcode_size.x;
+		const PartStyle &style = m_partStyles[part->style_index_];
 
-				float top_y = a.y;
+		ImVec2 q[4];
+		xf.Apply(part->outline, q, 4);
+		ImVec2 a = q[0], c = q[2];
 
-				if (c.y < top_y) top_y = c.y;
-				ImVec2 pos = ImVec2((a.x + c.x) * 0.5f, top_y);
+		/*
+		 * Draw the text associated with the box or pins if required
+		 */
+		if (style.highlighted && !part->is_dummy() && !part->name.empty()) {
+			const Label &text  = m_labelCache.Get(part->name);
+			const Label &mcode = m_labelCache.Get(part->mfgcode);
+			bool show_mcode    = !showInfoPanel && !part->mfgcode.empty();
 
-				pos.y -= text_size.y * 2;
-				if (mcode.size()) pos.y -= text_size.y;
+			ImVec2 text_size = text.size;
 
-				pos.x -= text_size.x * 0.5f;
-				draw->ChannelsSetCurrent(kChannelText);
+			if ((!showInfoPanel) && (mcode.size.x > text_size.x)) text_size.x = mcode.size.x;
 
-				// This is the background of the part text.
+			float top_y = a.y;
+
+			if (c.y < top_y) top_y = c.y;
+			ImVec2 pos = ImVec2((a.x + c.x) * 0.5f, top_y);
+
+			pos.y -= text_size.y * 2;
+			if (part->mfgcode.size()) pos.y -= text_size.y;
+
+			pos.x -= text_size.x * 0.5f;
+
+			// whole label block, backgrounds included
+			ImVec2 block_min = pos - ImVec2(DPIF(2.0f), DPIF(2.0f));
+			ImVec2 block_max = pos + text_size + ImVec2(DPIF(2.0f), DPIF(2.0f));
+			if (show_mcode) block_max.y += text_size.y + DPIF(2.0f);
+			if (labelCulling && !m_labelPlacer.Place(block_min, block_max)) continue;
+
+			draw->ChannelsSetCurrent(kChannelText);
+
+			// This is the background of the part text.
+			draw->AddRectFilled(ImVec2(pos.x - DPIF(2.0f), pos.y - DPIF(2.0f)),
+			                    ImVec2(pos.x + text_size.x + DPIF(2.0f), pos.y + text_size.y + DPIF(2.0f)),
+			                    m_colors.partTextBackgroundColor,
+			                    0.0f);
+			LabelCache::Emit(draw, text, pos, m_colors.partTextColor);
+			labels_left--;
+			if (show_mcode) {
+				//	pos.y += text_size.y;
+				pos.y += text_size.y + DPIF(2.0f);
 				draw->AddRectFilled(ImVec2(pos.x - DPIF(2.0f), pos.y - DPIF(2.0f)),
 				                    ImVec2(pos.x + text_size.x + DPIF(2.0f), pos.y + text_size.y + DPIF(2.0f)),
-				                    m_colors.partTextBackgroundColor,
+				                    m_colors.annotationPopupBackgroundColor,
 				                    0.0f);
-				draw->AddText(pos, m_colors.partTextColor, text.c_str());
-				if ((!showInfoPanel) && (mcode.size())) {
-					//	pos.y += text_size.y;
-					pos.y += text_size.y + DPIF(2.0f);
-					draw->AddRectFilled(ImVec2(pos.x - DPIF(2.0f), pos.y - DPIF(2.0f)),
-					                    ImVec2(pos.x + text_size.x + DPIF(2.0f), pos.y + text_size.y + DPIF(2.0f)),
-					                    m_colors.annotationPopupBackgroundColor,
-					                    0.0f);
-					draw->AddText(ImVec2(pos.x, pos.y), m_colors.annotationPopupTextColor, mcode.c_str());
-				}
-				draw->ChannelsSetCurrent(kChannelPolylines);
+				LabelCache::Emit(draw, mcode, pos, m_colors.annotationPopupTextColor);
 			}
+			draw->ChannelsSetCurrent(kChannelPolylines);
 		}
-	} // for each part
+	}
 }
 
 void BoardView::DrawPartTooltips(ImDrawList *draw) {
@@ -4111,29 +4073,19 @@ void BoardView::DrawPartTooltips(ImDrawList *draw) {
 	} else {
 		return;
 	}
-	/*
-	 * I am loathing that I have to add this, but basically check every pin on the board so we can
-	 * determine if we're hovering over a testpad
-	 */
-	for (auto &pin : m_board->Pins()) {
-
-		if (pin->type == Pin::kPinTypeTestPad) {
-			float dx   = pin->position.x - pos.x;
-			float dy   = pin->position.y - pos.y;
-			float dist = dx * dx + dy * dy;
-			if ((dist < (pin->diameter * pin->diameter))) {
-				float pd = pin->diameter * m_scale;
+	// hovering over a testpad, on either side
+	int testpad = BoardPicker().TestPadAt(pos);
+	if (testpad >= 0) {
+		auto &pin = m_board->Pins()[testpad];
+		float pd  = pin->diameter * m_scale;
 
-				draw->AddCircle(CoordToScreen(pin->position.x, pin->position.y), pd, m_colors.pinHaloColor, 32, pinHaloThickness);
-				ImGui::PushStyleColor(ImGuiCol_Text, m_colors.annotationPopupTextColor);
-				ImGui::PushStyleColor(ImGuiCol_PopupBg, m_colors.annotationPopupBackgroundColor);
-				ImGui::BeginTooltip();
-				ImGui::Text("TP[%s]%s", pin->name.c_str(), pin->net->name.c_str());
-				ImGui::EndTooltip();
-				ImGui::PopStyleColor(2);
-				break;
-			} // if in the required diameter
-		}
+		draw->AddCircle(CoordToScreen(pin->position.x, pin->position.y), pd, m_colors.pinHaloColor, 32, pinHaloThickness);
+		ImGui::PushStyleColor(ImGuiCol_Text, m_colors.annotationPopupTextColor);
+		ImGui::PushStyleColor(ImGuiCol_PopupBg, m_colors.annotationPopupBackgroundColor);
+		ImGui::BeginTooltip();
+		ImGui::Text("TP[%s]%s", pin->name.c_str(), pin->net->name.c_str());
+		ImGui::EndTooltip();
+		ImGui::PopStyleColor(2);
 	}
 
 	Component * previousHoveredPart = currentlyHoveredPart.get();
@@ -4160,29 +4112,11 @@ void BoardView::DrawPartTooltips(ImDrawList *draw) {
 		}
 	} else if (m_tcl->grab_mouse_hover()) {
 	} else {
-		for (auto &part : m_board->Components()) {
-			int hit = 0;
-			//		auto p_part = part.get();
-			
-			if (!BoardElementIsVisible(part)) continue;
-			
-			// Work out if the point is inside the hull
-			{
-				int i, j, n;
-				outline_pt *poly;
-				
-				n    = 4;
-				poly = part->outline;
-				
-				for (i = 0, j = n - 1; i < n; j = i++) {
-					if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
-						(pos.x < (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
-						hit ^= 1;
-				}
-			}
-			
+		for (uint32_t k : BoardPicker().PartsAt(PickSide(), pos)) {
+			auto &part = m_board->Components()[k];
+
 			// If we're inside a part
-			if (hit) {
+			{
 				currentlyHoveredPart = part;
 				if (part->outline_done) {
 					/*
@@ -4281,31 +4215,6 @@ inline void BoardView::DrawAnnotations(ImDrawList *draw) {
 			a.y -= annotationBoxOffset;
 			b = ImVec2(a.x + annotationBoxSize, a.y - annotationBoxSize);
 
-			if ((ann.hovered == true) && (m_tooltips_enabled)) {
-				char buf[60];
-
-				snprintf(buf, sizeof(buf), "%s", ann.note.c_str());
-				buf[50] = '\0';
-
-				ImGui::PushStyleColor(ImGuiCol_Text, m_colors.annotationPopupTextColor);
-				ImGui::PushStyleColor(ImGuiCol_PopupBg, m_colors.annotationPopupBackgroundColor);
-				ImGui::BeginTooltip();
-				ImGui::Text("%c(%0.0f,%0.0f) %s %s%c%s%c\n%s%s",
-				            m_current_side ? 'B' : 'T',
-				            ann.x,
-				            ann.y,
-				            ann.net.c_str(),
-				            ann.part.c_str(),
-				            ann.part.size() && ann.pin.size() ? '[' : ' ',
-				            ann.pin.c_str(),
-				            ann.part.size() && ann.pin.size() ? ']' : ' ',
-				            buf,
-				            ann.note.size() > 50 ? "..." : "");
-
-				ImGui::EndTooltip();
-				ImGui::PopStyleColor(2);
-			} else {
-			}
 			draw->AddCircleFilled(s, DPIF(2), m_colors.annotationStalkColor, 8);
 			draw->AddRectFilled(a, b, m_colors.annotationBoxColor);
 			draw->AddRect(a, b, m_colors.annotationStalkColor);
@@ -4314,6 +4223,42 @@ inline void BoardView::DrawAnnotations(ImDrawList *draw) {
 	}
 }
 
+/*
+ * The annotation boxes are retained geometry, the tooltip of the hovered
+ * one has to be shown every frame regardless.
+ */
+void BoardView::ShowAnnotationTooltip(void) {
+	if (!showAnnotations) return;
+	if (!m_tooltips_enabled) return;
+
+	for (auto &ann : m_annotations.annotations) {
+		if (ann.side == m_current_side && ann.hovered) {
+			char buf[60];
+
+			snprintf(buf, sizeof(buf), "%s", ann.note.c_str());
+			buf[50] = '\0';
+
+			ImGui::PushStyleColor(ImGuiCol_Text, m_colors.annotationPopupTextColor);
+			ImGui::PushStyleColor(ImGuiCol_PopupBg, m_colors.annotationPopupBackgroundColor);
+			ImGui::BeginTooltip();
+			ImGui::Text("%c(%0.0f,%0.0f) %s %s%c%s%c\n%s%s",
+			            m_current_side ? 'B' : 'T',
+			            ann.x,
+			            ann.y,
+			            ann.net.c_str(),
+			            ann.part.c_str(),
+			            ann.part.size() && ann.pin.size() ? '[' : ' ',
+			            ann.pin.c_str(),
+			            ann.part.size() && ann.pin.size() ? ']' : ' ',
+			            buf,
+			            ann.note.size() > 50 ? "..." : "");
+
+			ImGui::EndTooltip();
+			ImGui::PopStyleColor(2);
+		}
+	}
+}
+
 bool BoardView::HighlightedPinIsHovered(void) {
 	ImVec2 mp  = ImGui::GetMousePos();
 	ImVec2 mpc = ScreenToCoord(mp.x, mp.y); // it's faster to compute this once than convert all pins
@@ -4335,14 +4280,18 @@ bool BoardView::HighlightedPinIsHovered(void) {
 	/*
 	 * See if any of the pins in the same network as the SELECTED pin (single) are hovered
 	 */
-	for (auto &p : m_board->Pins()) {
-		//	auto p   = pin.get();
-		double r = p->diameter / 2.0f * m_scale;
-		if (m_pinSelected && p->net == m_pinSelected->net) {
-			ImVec2 a = ImVec2(p->position.x, p->position.y);
-			if ((mpc.x > a.x - r) && (mpc.x < a.x + r) && (mpc.y > a.y - r) && (mpc.y < a.y + r)) {
-				m_pinHighlightedHovered = p;
-				return true;
+	if (m_pinSelected) {
+		// the box below is half the diameter times the scale either way of the centre
+		BoardPicker().PinsNear(mpc, m_picker.MaxDiameter() / 2.0f * m_scale, m_pickCandidates);
+		for (uint32_t i : m_pickCandidates) {
+			auto &p  = m_board->Pins()[i];
+			double r = p->diameter / 2.0f * m_scale;
+			if (p->net == m_pinSelected->net) {
+				ImVec2 a = ImVec2(p->position.x, p->position.y);
+				if ((mpc.x > a.x - r) && (mpc.x < a.x + r) && (mpc.y > a.y - r) && (mpc.y < a.y + r)) {
+					m_pinHighlightedHovered = p;
+					return true;
+				}
 			}
 		}
 	}
@@ -4367,22 +4316,44 @@ bool BoardView::HighlightedPinIsHovered(void) {
 int BoardView::AnnotationIsHovered(void) {
 	ImVec2 mp       = ImGui::GetMousePos();
 	bool is_hovered = false;
-	int i           = 0;
 
 	if (!m_tooltips_enabled) return false;
 	m_annotation_last_hovered = 0;
 
-	for (auto &ann : m_annotations.annotations) {
-		ImVec2 a = CoordToScreen(ann.x, ann.y);
+	auto &annotations = m_annotations.annotations;
+	for (uint32_t h : m_annotationsHovered) {
+		if (h < annotations.size()) annotations[h].hovered = false;
+	}
+	m_annotationsHovered.clear();
+
+	/*
+	 * The boxes sit at a fixed pixel offset up and right of their anchor,
+	 * so the anchors of the boxes under the mouse are in the mirrored
+	 * rectangle down and left of it.
+	 */
+	ImVec2 corners[4] = {ScreenToCoord(mp.x - annotationBoxOffset - annotationBoxSize, mp.y + annotationBoxOffset),
+	                     ScreenToCoord(mp.x - annotationBoxOffset, mp.y + annotationBoxOffset),
+	                     ScreenToCoord(mp.x - annotationBoxOffset, mp.y + annotationBoxOffset + annotationBoxSize),
+	                     ScreenToCoord(mp.x - annotationBoxOffset - annotationBoxSize, mp.y + annotationBoxOffset + annotationBoxSize)};
+	BBox anchors = {corners[0], corners[0]};
+	for (auto &c : corners) {
+		anchors.min.x = std::min(anchors.min.x, c.x);
+		anchors.min.y = std::min(anchors.min.y, c.y);
+		anchors.max.x = std::max(anchors.max.x, c.x);
+		anchors.max.y = std::max(anchors.max.y, c.y);
+	}
+
+	m_picker.AnnotationsIn(m_annotations, anchors, m_pickCandidates);
+	for (uint32_t i : m_pickCandidates) {
+		auto &ann = annotations[i];
+		ImVec2 a  = CoordToScreen(ann.x, ann.y);
 		if ((mp.x > a.x + annotationBoxOffset) && (mp.x < a.x + (annotationBoxOffset + annotationBoxSize)) &&
 		    (mp.y < a.y - annotationBoxOffset) && (mp.y > a.y - (annotationBoxOffset + annotationBoxSize))) {
 			ann.hovered               = true;
 			is_hovered                = true;
 			m_annotation_last_hovered = i;
-		} else {
-			ann.hovered = false;
+			m_annotationsHovered.push_back(i);
 		}
-		i++;
 	}
 
 	if (is_hovered == false) m_annotation_clicked_id = -1;
@@ -4409,43 +4380,513 @@ void BoardView::DrawSelectedPins(ImDrawList *draw) {
 	}
 }
 
+void BoardView::InvalidateLayers(uint32_t mask) {
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+	m_invalidLayers |= mask;
+}
+
+BoardViewState BoardView::CurrentViewState(void) {
+	BoardViewState vs;
+
+	memset((void *)&vs, 0, sizeof(vs));
+	vs.rotation      = m_rotation;
+	vs.side          = m_current_side;
+	vs.side2         = dual_draw_side2;
+	vs.offset        = dual_draw_offset;
+	vs.surface_min   = m_board_surface_active.min;
+	vs.surface_max   = m_board_surface_active.max;
+	vs.intensity     = m_default_intensity;
+	vs.lod_threshold = pinLOD ? pinLODThreshold : 0.0f;
+	vs.fill_spacing  = boardFillSpacing;
+	vs.a1_threshold  = pinA1threshold;
+	vs.web_thickness = netWebThickness;
+	vs.quality       = m_governor.Level();
+	vs.toggles = showPins << 0 | showNetWeb << 1 | showAnnotations << 2 | fillParts << 3 | boardFill << 4 | slowCPU << 5 |
+	             pinShapeSquare << 6 | pinSelectMasks << 7 | m_tooltips_enabled << 8 | m_draw_both_sides << 9 |
+	             labelCulling << 10 | netWebRatsnest << 11;
+	vs.colors = m_colors;
+
+	return vs;
+}
+
+static uint32_t ShadeColor(uint32_t c, uint32_t s, float i) {
+	uint32_t cc = c;
+	if (s) {
+		cc = s;
+	}
+	auto f = [i, cc] (int sh) {
+		uint32_t ret = (cc >> sh & 0xff) * i;
+		if (ret > 255) return uint32_t(255) << sh;
+		return ret << sh;
+	};
+
+	return f(0) | f(8) | f(16) | f(24);
+}
+
+ElementStyleState BoardView::CurrentStyleState(void) {
+	ElementStyleState st;
+
+	memset((void *)&st, 0, sizeof(st));
+	st.colors               = m_colors;
+	st.intensity            = m_default_intensity;
+	st.a1_threshold         = pinA1threshold;
+	st.masked               = pinSelectMasks && (m_pinSelected || m_pinHighlighted.size());
+	st.pin_selected         = m_pinSelected.get();
+	st.pins_highlighted     = m_pinHighlighted.size();
+	st.parts_highlighted    = m_partHighlighted.size();
+	st.highlight_generation = m_highlightGeneration;
+
+	return st;
+}
+
+/*
+ * The colour rules of a pin, highest priority last.  Uses the membership
+ * bits already in style.flags, which UpdateStyles() keeps up to date.
+ */
+void BoardView::ComputePinStyle(const Pin &pin, PinStyle &style) {
+	uint32_t cmask = 0xFFFFFFFF;
+	uint32_t omask = 0x00000000;
+
+	/*
+	 * If we have a pin selected, then it makes it
+	 * easier to see where the associated pins are
+	 * by masking out (alpha or channel) the other
+	 * pins so they're fainter.
+	 */
+	if (m_stylesState.masked) {
+		cmask = m_colors.selectedMaskPins;
+		omask = m_colors.orMaskPins;
+	}
+
+	uint32_t fill_color = 0xFFFF8888; // fallback fill colour
+	uint32_t text_color = m_colors.pinDefaultTextColor;
+	uint32_t color      = (m_colors.pinDefaultColor & cmask) | omask;
+	uint8_t flags       = style.flags & (kPinStyleHighlighted | kPinStylePartHighlighted);
+	bool fill_pin       = false;
+	bool show_text      = false;
+	bool draw_ring      = true;
+
+	/*
+	 * Pins resulting from a net search
+	 */
+	if (flags & kPinStyleHighlighted) {
+		text_color = m_colors.pinSelectedTextColor;
+		fill_color = m_colors.pinSelectedFillColor;
+		color      = m_colors.pinSelectedColor;
+		fill_pin   = true;
+		show_text  = true;
+		draw_ring  = true;
+		flags |= kPinStyleEmphasised | kPinStyleEnlarge;
+	}
+
+	/*
+	 * If the part is selected, as part of search or otherwise
+	 */
+	if (flags & kPinStylePartHighlighted) {
+		color      = m_colors.pinDefaultColor;
+		text_color = m_colors.pinDefaultTextColor;
+		fill_pin   = false;
+		draw_ring  = true;
+		show_text  = true;
+		flags |= kPinStyleEmphasised;
+	}
+
+	if (pin.type == Pin::kPinTypeTestPad) {
+		color      = (m_colors.pinTestPadColor & cmask) | omask;
+		fill_color = (m_colors.pinTestPadFillColor & cmask) | omask;
+		show_text  = false;
+	}
+
+	// If the part itself is highlighted ( CVMShowPins )
+	if (pin.component->visualmode == pin.component->CVMSelected) {
+		color      = m_colors.pinDefaultColor;
+		text_color = m_colors.pinDefaultTextColor;
+		fill_pin   = false;
+		draw_ring  = true;
+		show_text  = true;
+		flags |= kPinStyleEmphasised;
+	}
+
+	if (!pin.net || pin.type == Pin::kPinTypeNotConnected) {
+		color = (m_colors.pinNotConnectedColor & cmask) | omask;
+	} else {
+		if (pin.net->is_ground) color = (m_colors.pinGroundColor & cmask) | omask;
+	}
+
+	// pin is on the same net as selected pin: highlight > rest
+	if (m_pinSelected && pin.net == m_pinSelected->net) {
+		color      = m_colors.pinSameNetColor;
+		text_color = m_colors.pinSameNetTextColor;
+		fill_color = m_colors.pinSameNetFillColor;
+		draw_ring  = false;
+		fill_pin   = true;
+		show_text  = true; // is this something we want? Maybe an optional thing?
+		flags |= kPinStyleEmphasised | kPinStyleEnlarge;
+	}
+
+	// pin selected overwrites everything
+	if (&pin == m_pinSelected.get()) {
+		color      = m_colors.pinSelectedColor;
+		text_color = m_colors.pinSelectedTextColor;
+		fill_color = m_colors.pinSelectedFillColor;
+		draw_ring  = false;
+		show_text  = true;
+		fill_pin   = true;
+		flags |= kPinStyleEmphasised | kPinStyleEnlarge;
+	}
+
+	// Check for BGA pin '1'
+	//
+	if (pin.name == "A1") {
+		color = fill_color = m_colors.pinA1PadColor;
+		fill_pin           = m_colors.pinA1PadColor;
+		draw_ring          = false;
+	}
+
+	if ((pin.number == "1")) {
+		if (pin.component->pins.size() >= static_cast<unsigned int>(pinA1threshold)) { // pinA1threshold is never negative
+			color = fill_color = m_colors.pinA1PadColor;
+			fill_pin           = m_colors.pinA1PadColor;
+			draw_ring          = false;
+		}
+	}
+
+	// don't show text if it doesn't make sense
+	if (pin.component->pins.size() <= 1) show_text = false;
+	if (pin.type == Pin::kPinTypeTestPad) show_text = false;
+
+	if (fill_pin) flags |= kPinStyleFill;
+	if (draw_ring) flags |= kPinStyleRing;
+	if (show_text) flags |= kPinStyleText;
+
+	style.color      = ShadeColor(color, 0, pin.intensity_delta_ * m_default_intensity);
+	style.fill_color = fill_color;
+	style.text_color = text_color;
+	style.flags      = flags;
+}
+
+void BoardView::ComputePartStyle(const Component &part, PartStyle &style) {
+	float intensity = part.intensity_delta_ * m_default_intensity;
+	uint32_t color  = m_colors.partOutlineColor;
+
+	/*
+	 * If a pin has been selected, we mask out the colour to
+	 * enhance (relatively) the appearance of the pin(s)
+	 */
+	if (m_stylesState.masked) {
+		color = (m_colors.partOutlineColor & m_colors.selectedMaskParts) | m_colors.orMaskParts;
+	}
+
+	style.outline             = ShadeColor(color, 0, intensity);
+	style.fill                = ShadeColor(m_colors.partFillColor, part.shade_color_, intensity);
+	style.highlighted_outline = ShadeColor(m_colors.partHighlightedColor, part.shade_color_, intensity);
+	style.symbol              = ShadeColor(0xff666666, part.shade_color_, intensity);
+}
+
+void BoardView::InvalidateStyles(void) {
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+	m_invalidStyles = true;
+}
+
+void BoardView::InvalidateNames(void) {
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+	m_invalidNames = true;
+}
+
+void BoardView::InvalidateStyle(Pin *pin) {
+	if (!pin) return;
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+	m_invalidPins.push_back(pin);
+}
+
+void BoardView::InvalidateStyle(Component *part) {
+	if (!part) return;
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+	m_invalidParts.push_back(part);
+}
+
+/*
+ * Single elements are only worth queueing while the styles are valid,
+ * otherwise the full rebuild already pending covers them (and they may
+ * belong to a board that's gone by now).
+ */
+void BoardView::TakeInvalidations(void) {
+	std::lock_guard<std::mutex> lock(m_invalidMutex);
+
+	for (auto &dirty : m_layersDirty) dirty |= m_invalidLayers;
+	if (m_invalidStyles) m_stylesValid = false;
+
+	if (m_stylesValid) {
+		for (Pin *pin : m_invalidPins) {
+			if (pin->style_index_ >= 0) m_pinStylesDirty.push_back(pin);
+		}
+		for (Component *part : m_invalidParts) {
+			if (part->style_index_ >= 0) m_partStylesDirty.push_back(part);
+		}
+	}
+
+	m_invalidLayers = 0;
+	m_invalidStyles = false;
+	m_invalidPins.clear();
+	m_invalidParts.clear();
+}
+
+// Search index and "did you mean" dictionaries, for the current board's names
+void BoardView::IndexNames(void) {
+	searcher.setParts(m_board->Components());
+	searcher.setNets(m_board->Nets());
+
+	std::vector<std::string> netnames;
+	for (auto &n : m_board->Nets()) netnames.push_back(n->name);
+	std::vector<std::string> partnames;
+	for (auto &p : m_board->Components()) partnames.push_back(p->name);
+
+	scnets.setDictionary(netnames);
+	scparts.setDictionary(partnames);
+}
+
+/*
+ * After parts or nets got renamed: the search worker reads the index, so
+ * it's stopped first, and the queries it drops get posted again by the
+ * search boxes this frame.  The list windows see the index change and
+ * refilter themselves.
+ */
+void BoardView::UpdateNames(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_invalidMutex);
+		if (!m_invalidNames) return;
+		m_invalidNames = false;
+	}
+	if (!m_board) return;
+
+	m_searchWorker.Reset();
+	IndexNames();
+}
+
+/*
+ * Brings the style buffers up to date before the board gets recorded.
+ * Nothing to do most frames; a full rebuild is a pass over the pins and
+ * parts plus one over the highlight lists, everything else only touches
+ * the elements concerned.
+ */
+void BoardView::UpdateStyles(void) {
+	auto &pins  = m_board->Pins();
+	auto &parts = m_board->Components();
+
+	bool rewritten         = m_highlightsRewritten.exchange(false);
+	ElementStyleState st   = CurrentStyleState();
+	ElementStyleState prev = m_stylesState;
+	m_stylesState          = st;
+
+	bool full = rewritten || !m_stylesValid || m_pinStyles.size() != pins.size() || m_partStyles.size() != parts.size();
+
+	if (!full && st != prev) {
+		// highlights only appended to (HighlightPin(), HighlightPart()), with nothing else changed, can be added one by one
+		ElementStyleState grown    = prev;
+		grown.pins_highlighted     = st.pins_highlighted;
+		grown.parts_highlighted    = st.parts_highlighted;
+		grown.highlight_generation = st.highlight_generation;
+
+		if (grown != st || st.pins_highlighted < prev.pins_highlighted || st.parts_highlighted < prev.parts_highlighted) {
+			full = true;
+		} else {
+			for (size_t i = prev.pins_highlighted; i < st.pins_highlighted; i++) {
+				Pin *pin = m_pinHighlighted[i].get();
+				if (pin->style_index_ < 0 || pins[pin->style_index_].get() != pin) continue;
+				m_pinStyles[pin->style_index_].flags |= kPinStyleHighlighted;
+				m_pinStylesDirty.push_back(pin);
+			}
+			for (size_t i = prev.parts_highlighted; i < st.parts_highlighted; i++) {
+				Component *part = m_partHighlighted[i].get();
+				if (part->style_index_ < 0 || parts[part->style_index_].get() != part) continue;
+				m_partStyles[part->style_index_].highlighted = true;
+				for (auto &pin : part->pins) {
+					if (pin->style_index_ < 0) continue;
+					m_pinStyles[pin->style_index_].flags |= kPinStylePartHighlighted;
+					m_pinStylesDirty.push_back(pin.get());
+				}
+			}
+		}
+	}
+
+	if (full) {
+		m_pinStyles.resize(pins.size());
+		m_partStyles.resize(parts.size());
+
+		for (size_t i = 0; i < parts.size(); i++) {
+			parts[i]->style_index_      = i;
+			m_partStyles[i].highlighted = false;
+		}
+		for (size_t i = 0; i < pins.size(); i++) {
+			pins[i]->style_index_ = i;
+			m_pinStyles[i].flags  = 0;
+		}
+
+		// membership of the highlight lists, see PartIsHighlighted()
+		for (auto &part : m_partHighlighted) {
+			if (part->style_index_ >= 0) m_partStyles[part->style_index_].highlighted = true;
+		}
+		if (m_pinSelected) m_partStyles[m_pinSelected->component->style_index_].highlighted = true;
+		for (auto &pin : m_pinHighlighted) {
+			if (pin->style_index_ >= 0) m_pinStyles[pin->style_index_].flags |= kPinStyleHighlighted;
+		}
+
+		for (size_t i = 0; i < parts.size(); i++) ComputePartStyle(*parts[i], m_partStyles[i]);
+		for (size_t i = 0; i < pins.size(); i++) {
+			if (m_partStyles[pins[i]->component->style_index_].highlighted) m_pinStyles[i].flags |= kPinStylePartHighlighted;
+			ComputePinStyle(*pins[i], m_pinStyles[i]);
+		}
+
+		m_pinStylesDirty.clear();
+		m_partStylesDirty.clear();
+		m_stylesValid = true;
+		return;
+	}
+
+	for (Pin *pin : m_pinStylesDirty) ComputePinStyle(*pin, m_pinStyles[pin->style_index_]);
+	for (Component *part : m_partStylesDirty) ComputePartStyle(*part, m_partStyles[part->style_index_]);
+	m_pinStylesDirty.clear();
+	m_partStylesDirty.clear();
+}
+
 void BoardView::DrawBoard() {
 	if (!m_file || !m_board) return;
 
+	QualityGovernor::Scope timing(m_governor);
+
 	ImDrawList *draw = ImGui::GetWindowDrawList();
-	if (!m_needsRedraw) {
-		memcpy((void *) draw, (void *) m_cachedDrawList, sizeof(ImDrawList));
-		memcpy((void *) draw->CmdBuffer.Data, (void *) m_cachedDrawCommands.Data, m_cachedDrawCommands.Size);
-		return;
+	int view         = m_boardViewIndex < kMaxBoardViews ? m_boardViewIndex++ : kMaxBoardViews - 1;
+	auto &layers     = m_layers[view];
+	uint32_t &dirty  = m_layersDirty[view];
+
+	if (!m_layerScratch) m_layerScratch = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+
+	TakeInvalidations();
+
+	BoardViewState vs = CurrentViewState();
+	if (vs != m_layersView[view]) {
+		m_layersView[view] = vs;
+		dirty |= kLayerMaskAll;
+	}
+
+	BoardSelectionState ss = {m_pinSelected.get(), m_highlightGeneration};
+	if (ss != m_layersSelection[view]) {
+		m_layersSelection[view] = ss;
+		dirty |= kLayerMaskSelection;
 	}
 
-	// Splitting channels, drawing onto those and merging back.
-	draw->ChannelsSplit(NUM_DRAW_CHANNELS);
+	dirty |= kLayerMaskVolatile;
+
+	UpdateStyles();
+
+	/*
+	 * Pans and zooms keep the recorded layers: with the rotation and side
+	 * unchanged, going from the view a layer was recorded at to the
+	 * current one is a uniform scale plus a translation of its vertices.
+	 *
+	 * Line widths and text don't scale with the board though, so after a
+	 * zoom the layers are re-recorded once the view has been still for a
+	 * couple of frames (or right away if the zoom is too far off).  Layers
+	 * only holding what's around the visible surface are re-recorded when
+	 * a pan gets past the margin they were recorded with.
+	 */
+	ImVec2 pan(m_dx, m_dy);
+	if (pan != m_layersPan[view] || m_scale != m_layersScale[view]) {
+		m_layersPan[view]   = pan;
+		m_layersScale[view] = m_scale;
+		m_layersStill[view] = 0;
+	} else if (m_layersStill[view] < INT_MAX) {
+		m_layersStill[view]++;
+	}
+
+	LayerTransform xf[NUM_BOARD_LAYERS];
+	for (int l = 0; l < NUM_BOARD_LAYERS; l++) {
+		RetainedLayer &layer = layers[l];
+		uint32_t bit         = 1u << l;
+
+		if (dirty & bit) continue;
+
+		float k = m_scale / layer.view_scale;
+		if (k != 1.0f && (m_layersStill[view] >= 2 || k < 0.5f || k > 2.0f)) {
+			dirty |= bit;
+			continue;
+		}
+
+		ImVec2 b = CoordToScreen(m_dx - layer.view_pan.x, m_dy - layer.view_pan.y, 0.0f);
+		if (bit & kLayerMaskCulled) {
+			ImVec2 cmin = layer.cull_min * k + b;
+			ImVec2 cmax = layer.cull_max * k + b;
+			if (!(m_board_surface_active.min >= cmin && m_board_surface_active.max <= cmax)) {
+				dirty |= bit;
+				continue;
+			}
+		}
+		xf[l].scale  = k;
+		xf[l].offset = b;
+	}
+
+	/*
+	 * Board fill and outline don't depend on which side a view shows,
+	 * only the views' offsets tell them apart.  So just the first view of
+	 * the frame records them, the others re-use its layer moved over by
+	 * the difference in offset.
+	 */
+	ViewTransform view_xf = CoordTransform();
+	RetainedLayer *compose[NUM_BOARD_LAYERS];
+	for (int l = 0; l < NUM_BOARD_LAYERS; l++) compose[l] = &layers[l];
+
+	if (view > 0) {
+		dirty &= ~kLayerMaskBoard;
+		compose[kLayerBoard]     = &m_layers[0][kLayerBoard];
+		xf[kLayerBoard].scale    = m_boardLayerXf.scale;
+		xf[kLayerBoard].offset.x = m_boardLayerXf.offset.x + view_xf.tx - m_boardLayerOrigin.x;
+		xf[kLayerBoard].offset.y = m_boardLayerXf.offset.y + view_xf.ty - m_boardLayerOrigin.y;
+	}
+
+	auto record = [&](BoardLayer layer, auto fn) {
+		if (!(dirty & (1u << layer))) return;
+		RetainedLayer::Begin(m_layerScratch, NUM_DRAW_CHANNELS);
+		fn(m_layerScratch);
+		layers[layer].End(m_layerScratch);
+
+		ImVec2 margin            = m_board_surface_active.dim() * m_cullMargin;
+		layers[layer].view_pan   = pan;
+		layers[layer].view_scale = m_scale;
+		layers[layer].cull_min   = m_board_surface_active.min - margin;
+		layers[layer].cull_max   = m_board_surface_active.max + margin;
+	};
 
 	// We draw the Parts before the Pins so that we can ascertain the needed pin
 	// size for the parts based on the part/pad geometry and spacing. -Inflex
 	// OutlineGenerateFill();
 	//	DrawFill(draw);
-	OutlineGenFillDraw(draw, boardFillSpacing, 1);
-	DrawOutline(draw);
-	DrawParts(draw);
+	record(kLayerBoard, [&](ImDrawList *d) {
+		DrawBoardFill(d);
+		DrawOutline(d);
+	});
+	record(kLayerParts, [&](ImDrawList *d) { DrawParts(d); });
 	//	DrawSelectedPins(draw);
-	DrawPins(draw);
-	DrawNodes(draw);
-	// DrawPinTooltips(draw);
-	DrawPartTooltips(draw);
-	DrawAnnotations(draw);
-
-	m_tcl->imgui_draw(draw);
+	record(kLayerPins, [&](ImDrawList *d) { DrawPins(d); });
+	record(kLayerOverlay, [&](ImDrawList *d) {
+		d->ChannelsSetCurrent(kChannelPins);
+		DrawNodes(d);
+		// DrawPinTooltips(draw);
+		DrawPartTooltips(d);
+		DrawSelectionBand(d);
+	});
+	record(kLayerAnnotations, [&](ImDrawList *d) { DrawAnnotations(d); });
+	dirty = 0;
+
+	if (view == 0) {
+		m_boardLayerXf     = xf[kLayerBoard];
+		m_boardLayerOrigin = ImVec2(view_xf.tx, view_xf.ty);
+	}
 
-	draw->ChannelsMerge();
+	ComposeLayers(draw, compose, xf, NUM_BOARD_LAYERS);
+	ShowAnnotationTooltip();
 
-	// Copy the new draw list and cmd buffer:
-	memcpy(m_cachedDrawList, draw, sizeof(ImDrawList));
-	int cmds_size = draw->CmdBuffer.size() * sizeof(ImDrawCmd);
-	m_cachedDrawCommands.resize(cmds_size);
-	memcpy(m_cachedDrawCommands.Data, draw->CmdBuffer.Data, cmds_size);
-	m_needsRedraw = false;
+	// The Tcl overlay may render the schematic as an image, so it can't be retained
+	m_tcl->imgui_draw(draw);
 }
 /** end of drawing region **/
 
@@ -4476,7 +4917,6 @@ void BoardView::CenterView(void) {
 	//  m_rotation = 0;
 	m_scale_floor = m_scale = sx < sy ? sx : sy;
 	SetTarget(m_mx, m_my);
-	m_needsRedraw = true;
 }
 
 void BoardView::SetFile(obv_shared_ptr<BRDFile> file, obv_shared_ptr<BRDBoard> board) {
@@ -4519,16 +4959,20 @@ void BoardView::SetFile(obv_shared_ptr<BRDFile> file, obv_shared_ptr<BRDBoard> b
 	} else {
 		m_board = obv_make_shared<BRDBoard>(file.get());
 	}
-	searcher.setParts(m_board->Components());
-	searcher.setNets(m_board->Nets());
-
-	std::vector<std::string> netnames;
-	for (auto &n : m_board->Nets()) netnames.push_back(n->name);
-	std::vector<std::string> partnames;
-	for (auto &p : m_board->Components()) netnames.push_back(p->name);
-
-	scnets.setDictionary(netnames);
-	scparts.setDictionary(partnames);
+	// the search worker reads the old indices until it's idle
+	m_searchWorker.Reset();
+	for (auto &r : m_searchResults) r = SearchWorker::Results();
+	IndexNames();
+	m_registry.Build(*m_board);
+	m_stats.Build(*m_board);
+	m_pinDensity.Clear();
+	m_pinGrid.Clear();
+	m_band.End();
+	m_picker.Clear();
+	m_netWeb.Clear();
+	m_nodes.Clear();
+	m_labelCache.Clear();
+	m_boardOutline.Clear();
 
 	m_nets = m_board->Nets();
 
@@ -4560,8 +5004,9 @@ void BoardView::SetFile(obv_shared_ptr<BRDFile> file, obv_shared_ptr<BRDBoard> b
 	m_partHighlighted.reserve(m_board->Components().size());
 	m_pinSelected = nullptr;
 
-	m_firstFrame  = true;
-	m_needsRedraw = true;
+	m_firstFrame = true;
+	InvalidateLayers();
+	InvalidateStyles();
 }
 
 // e__l
@@ -4623,6 +5068,52 @@ ImVec2 BoardView::ScreenToCoord(float x, float y, float w) {
 	}
 }
 
+ViewTransform BoardView::CoordTransform() {
+	float side = m_current_side ? -1.0f : 1.0f;
+	float sx   = side * m_scale;
+	float sy   = -m_scale;
+
+	// CoordToScreen() before rotating: (sx * x + lx, sy * y + ly)
+	float lx = sx * (m_dx - (dual_draw_side2 ? dual_draw_offset.x : 0.0f) - m_mx);
+	float ly = sy * (m_dy - (dual_draw_side2 ? dual_draw_offset.y : 0.0f) - m_my);
+
+	ViewTransform xf;
+	switch (m_rotation) {
+		case 0: xf = {sx, 0.0f, 0.0f, sy, lx, ly}; break;
+		case 1: xf = {0.0f, -sy, sx, 0.0f, -ly, lx}; break;
+		case 2: xf = {-sx, 0.0f, 0.0f, -sy, -lx, -ly}; break;
+		default: xf = {0.0f, sy, -sx, 0.0f, ly, -lx}; break;
+	}
+	return xf;
+}
+
+void BoardView::CoordToScreen(const ImVec2 *in, ImVec2 *out, size_t n) {
+	CoordTransform().Apply(in, out, n);
+}
+
+void BoardView::ScreenToCoord(const ImVec2 *in, ImVec2 *out, size_t n) {
+	CoordTransform().Inverse().Apply(in, out, n);
+}
+
+void BoardView::BenchCoordToScreen(size_t n, double &batched, double &single) {
+	std::vector<ImVec2> in(n), out(n);
+	volatile float sink;
+
+	for (size_t i = 0; i < n; i++) in[i] = ImVec2(float(i % 4096), float(i / 4096));
+
+	auto t0 = std::chrono::steady_clock::now();
+	CoordToScreen(in.data(), out.data(), n);
+	auto t1 = std::chrono::steady_clock::now();
+	sink = out[n / 2].x;
+	for (size_t i = 0; i < n; i++) out[i] = CoordToScreen(in[i]);
+	auto t2 = std::chrono::steady_clock::now();
+	sink = out[n / 2].x;
+	(void)sink;
+
+	batched = n / std::max(std::chrono::duration<double>(t1 - t0).count(), 1e-9);
+	single  = n / std::max(std::chrono::duration<double>(t2 - t1).count(), 1e-9);
+}
+
 void BoardView::Rotate(int count) {
 	// too lazy to do math
 	while (count > 0) {
@@ -4637,7 +5128,6 @@ void BoardView::Rotate(int count) {
 			m_dy = -dx;
 		}
 		--count;
-		m_needsRedraw = true;
 	}
 	while (count < 0) {
 		m_rotation = (m_rotation - 1) & 3;
@@ -4651,7 +5141,6 @@ void BoardView::Rotate(int count) {
 			m_dy = -dx;
 		}
 		++count;
-		m_needsRedraw = true;
 	}
 }
 
@@ -4697,6 +5186,14 @@ void BoardView::Mirror(void) {
 	for (auto &ann : m_annotations.annotations) {
 		ann.x = max.x - ann.x;
 	}
+
+	m_pinDensity.Clear();
+	m_pinGrid.Clear();
+	m_band.End();
+	m_picker.Clear();
+	m_netWeb.Clear();
+	m_boardOutline.Clear();
+	m_stats.Mirror(max.x);
 }
 
 void BoardView::SetTarget(float x, float y) {
@@ -4707,6 +5204,90 @@ void BoardView::SetTarget(float x, float y) {
 	m_dy += coord.y - y;
 }
 
+/*
+ * Makes what's inside the selection band the selection (or adds it, with
+ * Ctrl held), all in one go: one style and layer refresh and one Tcl
+ * select event whatever the number of elements.
+ */
+void BoardView::ApplyBand(bool add) {
+	m_band.Pins(m_bandPins);
+	m_band.Parts(m_bandParts);
+	m_band.End();
+
+	std::unordered_set<const void *> have;
+	if (add) {
+		for (auto &p : m_pinHighlighted) have.insert(p.get());
+		for (auto &c : m_partHighlighted) have.insert(c.get());
+	} else {
+		for (auto &p : m_board->Components()) {
+			p->visualmode = p->CVMNormal;
+		}
+		m_partHighlighted.clear();
+		m_pinHighlighted.clear();
+		m_pinSelected = nullptr;
+		HighlightsChanged();
+	}
+
+	auto &parts = m_board->Components();
+	for (uint32_t k : m_bandParts) {
+		auto &part = parts[k];
+		if (part->is_dummy() || !have.insert(part.get()).second) continue;
+		part->visualmode = part->CVMSelected;
+		HighlightPart(part);
+	}
+
+	auto &pins = m_board->Pins();
+	for (uint32_t i : m_bandPins) {
+		if (have.insert(pins[i].get()).second) HighlightPin(pins[i]);
+	}
+
+	m_tcl->component_select_event();
+}
+
+// The band being dragged out and what it currently holds
+void BoardView::DrawSelectionBand(ImDrawList *draw) {
+	if (!m_band.Active() || m_band.Side() != PickSide()) return;
+
+	auto &outline = m_band.Outline();
+	if (outline.size() < 2) return;
+
+	draw->ChannelsSetCurrent(kChannelAnnotations);
+
+	m_band.Parts(m_bandParts);
+	for (uint32_t k : m_bandParts) {
+		auto &part = m_board->Components()[k];
+		if (part->is_dummy()) continue;
+		ImVec2 *p = part->outline;
+		draw->AddQuad(CoordToScreen(p[0]), CoordToScreen(p[1]), CoordToScreen(p[2]), CoordToScreen(p[3]), m_colors.partHighlightedColor, 2);
+	}
+
+	m_band.Pins(m_bandPins);
+	ImVec2 mark(DPIF(2.0f), DPIF(2.0f));
+	for (uint32_t i : m_bandPins) {
+		auto &pin = m_board->Pins()[i];
+		ImVec2 s  = CoordToScreen(pin->position.x, pin->position.y);
+		draw->AddRectFilled(s - mark, s + mark, m_colors.pinSelectedColor);
+	}
+
+	m_bandOutline.resize(outline.size());
+	for (size_t i = 0; i < outline.size(); i++) m_bandOutline[i] = CoordToScreen(outline[i]);
+	draw->AddPolyline(m_bandOutline.data(), m_bandOutline.size(), m_colors.partHighlightedColor, true, DPIF(1.0f));
+}
+
+/*
+ * The picker needs the part outlines and pin diameters, which DrawParts()
+ * only works out on the first pass; it drops the picker when it does.
+ */
+Picker &BoardView::BoardPicker() {
+	if (!m_picker.Built()) m_picker.Build(*m_board);
+	return m_picker;
+}
+
+// The side BoardElementIsVisible() lets through in the view being handled
+int BoardView::PickSide() const {
+	return dual_draw_side2 ? !m_current_side : m_current_side;
+}
+
 inline bool BoardView::BoardElementIsVisible(const obv_shared_ptr<BoardElement> be) {
 	if (!be) return true; // no element? => no board side info
 
@@ -4766,12 +5347,13 @@ void BoardView::FindNetNoClear(const char *name) {
 	auto results = searcher.nets(name);
 
 	for (auto &net : results) {
-		for (auto &pin : net->pins) m_pinHighlighted.push_back(pin);
+		for (auto &pin : net->pins) HighlightPin(pin);
 	}
 }
 
 void BoardView::FindNet(const char *name) {
 	m_pinHighlighted.clear();
+	HighlightsChanged();
 	FindNetNoClear(name);
 }
 
@@ -4781,13 +5363,12 @@ void BoardView::FindComponentNoClear(const char *name) {
 	auto results = searcher.parts(name);
 
 	for (auto &p : results) {
-		m_partHighlighted.push_back(p);
+		HighlightPart(p);
 
 		for (auto &pin : p->pins) {
-			m_pinHighlighted.push_back(pin);
+			HighlightPin(pin);
 		}
 	}
-	m_needsRedraw = true;
 }
 
 void BoardView::FindComponent(const char *name) {
@@ -4795,6 +5376,7 @@ void BoardView::FindComponent(const char *name) {
 
 	m_pinHighlighted.clear();
 	m_partHighlighted.clear();
+	HighlightsChanged();
 
 	FindComponentNoClear(name);
 }
@@ -4812,11 +5394,31 @@ void BoardView::SearchCompound(const char *item) {
 	if (*item == '\0') return;
 	m_pinHighlighted.clear();
 	m_partHighlighted.clear();
+	HighlightsChanged();
 	//	ClearAllHighlights();
 
 	SearchCompoundNoClear(item);
 }
 
+/*
+ * Highlights what the worker found for a search box while typing; only
+ * the first results are there, the full search is run once the search is
+ * accepted.
+ */
+void BoardView::PreviewSearchResults(const SearchWorker::Results &results) {
+	m_pinHighlighted.clear();
+	m_partHighlighted.clear();
+	HighlightsChanged();
+
+	for (auto &part : results.parts) {
+		HighlightPart(part);
+		for (auto &pin : part->pins) HighlightPin(pin);
+	}
+	for (auto &net : results.nets) {
+		for (auto &pin : net->pins) HighlightPin(pin);
+	}
+}
+
 void BoardView::SetLastFileOpenName(const std::string &name) {
 	m_lastFileOpenName = name;
 }
@@ -4843,7 +5445,6 @@ void BoardView::FlipBoard(int mode) {
 			Pan(DIR_DOWN, view.y / 2 - mpos.y);
 		}
 	}
-	m_needsRedraw = true;
 }
 
 BitVec::~BitVec() {
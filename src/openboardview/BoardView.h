@@ -1,7 +1,24 @@
 #pragma once
 
 #include "Board.h"
+#include "BoardLayers.h"
+#include "BoardOutline.h"
+#include "BoardRegistry.h"
+#include "BoardStats.h"
+#include "FrameScheduler.h"
+#include "LabelCache.h"
+#include "NetWeb.h"
+#include "NodeOverlay.h"
+#include "ParallelDraw.h"
+#include "PinDensity.h"
+#include "PinGrid.h"
+#include "PinGlyphs.h"
+#include "Picker.h"
+#include "QualityGovernor.h"
+#include "ViewTransform.h"
+#include "SearchWorker.h"
 #include "Searcher.h"
+#include "SelectionBand.h"
 #include "SpellCorrector.h"
 #include "annotations.h"
 #include "confparse.h"
@@ -11,7 +28,9 @@
 #include "GUI/Preferences/Keyboard.h"
 #include "GUI/BackgroundImage.h"
 #include "GUI/Preferences/BackgroundImage.h"
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <mutex>
 
@@ -120,6 +139,97 @@ enum DrawChannel {
 
 enum FlipModes { flipModeVP = 0, flipModeMP = 1, NUM_FLIP_MODES };
 
+/*
+ * What the retained board layers of one view were recorded with, apart
+ * from the board data, the selection, and the pan and zoom (which the
+ * layers follow by themselves).  Filled in by memset()ing first
+ * so that memcmp() can be used to compare two of them.
+ */
+struct BoardViewState {
+	int rotation;
+	int side;
+	int side2;
+	ImVec2 offset;
+	ImVec2 surface_min, surface_max;
+	float intensity;
+	float lod_threshold;
+	int fill_spacing;
+	int a1_threshold;
+	int web_thickness;
+	uint32_t toggles; // show*, fill* and friends, one bit each
+	int quality;      // QualityGovernor level
+	ColorScheme colors;
+
+	bool operator==(BoardViewState const &o) const {
+		return memcmp(this, &o, sizeof(*this)) == 0;
+	}
+	bool operator!=(BoardViewState const &o) const {
+		return !(*this == o);
+	}
+};
+
+struct BoardSelectionState {
+	const void *pin_selected;
+	uint32_t highlight_generation; // BoardView::m_highlightGeneration
+
+	bool operator!=(BoardSelectionState const &o) const {
+		return pin_selected != o.pin_selected || highlight_generation != o.highlight_generation;
+	}
+};
+
+/*
+ * Colours and flags a pin or part gets drawn with, worked out from the
+ * colour scheme, the selection and highlights, and the Tcl shading.  Kept
+ * in one packed entry per element (see UpdateStyles()) so the draw passes
+ * only have to look them up.
+ */
+enum PinStyleFlags : uint8_t {
+	kPinStyleFill            = 1 << 0,
+	kPinStyleRing            = 1 << 1,
+	kPinStyleText            = 1 << 2,
+	kPinStyleEmphasised      = 1 << 3,
+	kPinStyleEnlarge         = 1 << 4, // at least half a character wide
+	kPinStyleHighlighted     = 1 << 5, // in m_pinHighlighted
+	kPinStylePartHighlighted = 1 << 6, // its part is, see PartIsHighlighted()
+};
+
+struct PinStyle {
+	uint32_t color; // ring, shaded
+	uint32_t fill_color;
+	uint32_t text_color;
+	uint8_t flags;
+};
+
+struct PartStyle {
+	uint32_t outline;
+	uint32_t fill;
+	uint32_t highlighted_outline;
+	uint32_t symbol;
+	bool highlighted;
+};
+
+/*
+ * Everything, besides the elements' own shading, the styles were worked
+ * out from.  Compared with memcmp() like BoardViewState.
+ */
+struct ElementStyleState {
+	ColorScheme colors;
+	float intensity;
+	int a1_threshold;
+	int masked; // pinSelectMasks with something selected
+	const void *pin_selected;
+	size_t pins_highlighted;
+	size_t parts_highlighted;
+	uint32_t highlight_generation;
+
+	bool operator==(ElementStyleState const &o) const {
+		return memcmp(this, &o, sizeof(*this)) == 0;
+	}
+	bool operator!=(ElementStyleState const &o) const {
+		return !(*this == o);
+	}
+};
+
 struct BoardView {
 	obv_shared_ptr<BRDFile> m_file;
 	obv_shared_ptr<Board> m_board;
@@ -130,6 +240,8 @@ struct BoardView {
 	Searcher searcher;
 	SpellCorrector scnets;
 	SpellCorrector scparts;
+	SearchWorker m_searchWorker{searcher, scparts, scnets};
+	SearchWorker::Results m_searchResults[SearchWorker::kSlots];
 	KeyBindings keybindings;
 	KeyBindings * tcl_keybindings = nullptr;
 
@@ -160,12 +272,18 @@ struct BoardView {
 	int netWebThickness = 2;
 
 	float pinSizeThresholdLow = 0.0f;
+	bool pinLOD               = true;
+	float pinLODThreshold     = 2.0f; // typical pin size (px) below which pins become density tiles
 	bool pinShapeSquare       = false;
+	bool labelCulling         = true; // skip pin/part labels overlapping ones already drawn
+	bool adaptiveQuality      = true; // trade drawing detail for speed while the view moves
+	float qualityBudget       = 8.0f; // ms of DrawBoard() per frame the above aims for
 	bool pinShapeCircle       = true;
 	bool pinSelectMasks       = true;
 	bool slowCPU              = false;
 	bool showFPS              = false;
 	bool showNetWeb           = true;
+	bool netWebRatsnest       = false; // spanning tree through the net's pins instead of a star from the selected one
 	bool showInfoPanel        = true;
 	bool showPins             = true;
 	bool showAnnotations      = true;
@@ -175,7 +293,6 @@ struct BoardView {
 	bool fillParts            = true;
 	bool boardFill            = true;
 	int boardFillSpacing      = 3;
-	bool boardMinMaxDone      = false;
 
 	bool showPosition  = true;
 	bool reloadConfig  = false;
@@ -195,9 +312,9 @@ struct BoardView {
 	void HelpAbout(void);
 	void HelpControls(void);
 	template <class T>
-	void ShowSearchResults(std::vector<T> results, char *search, int &limit, void (BoardView::*onSelect)(const char *));
+	void ShowSearchResults(const std::vector<T> &results, char *search, int &limit, void (BoardView::*onSelect)(const char *));
 	void SearchColumnGenerate(const std::string &title,
-	                          std::pair<SharedVector<Component>, SharedVector<Net>> results,
+	                          const SearchWorker::Results &results,
 	                          char *search,
 	                          int limit);
 	void Preferences(void);
@@ -215,7 +332,7 @@ struct BoardView {
 	bool m_centerZoomSearchResults = true;
 	void CenterZoomSearchResults(void);
 	int EPCCheck(void);
-	void OutlineGenFillDraw(ImDrawList *draw, int ydelta, double thickness);
+	void DrawBoardFill(ImDrawList *draw);
 
 	/* Context menu, sql stuff */
 	Annotations m_annotations;
@@ -245,8 +362,15 @@ struct BoardView {
 	//	vector<Net *> m_netHiglighted;
 	SharedVector<Pin> m_pinHighlighted;
 	SharedVector<Component> m_partHighlighted;
-	char m_cachedDrawList[sizeof(ImDrawList)];
-	ImVector<char> m_cachedDrawCommands;
+	/*
+	 * Bumped by every change to the two lists above: HighlightPin() and
+	 * HighlightPart() append, anything else has to be followed by
+	 * HighlightsChanged().  The styles and the selection layers are kept
+	 * up to date by this rather than by the sizes of the lists.  Tcl
+	 * threads change the lists as well, hence atomics.
+	 */
+	std::atomic<uint32_t> m_highlightGeneration{0};
+	std::atomic<bool> m_highlightsRewritten{true}; // since UpdateStyles() last looked, not just appended to
 	SharedVector<Net> m_nets;
 	char m_search[3][128];
 	char m_netFilter[128];
@@ -281,6 +405,12 @@ struct BoardView {
 	int m_tcl_drag = 0;
 
 	static void wakeup();
+	// Whether the last frame left something to finish on the next one
+	bool WantsFrame() const {
+		return m_wantsFrame;
+	}
+	const LatencyHistogram *m_inputLatency  = nullptr;
+	const LatencyHistogram *m_motionLatency = nullptr;
 	static int m_wakeup_pipe[2];
 	
 	ColorScheme m_colors;
@@ -291,15 +421,111 @@ struct BoardView {
 	// pinDiameter: diameter for all pins.  Unit scale: 1 = 0.025mm, boards are
 	// done in "thou" (1/1000" = 0.0254mm)
 	int m_pinDiameter     = 20;
+	PinDensity m_pinDensity;
+	PinGrid m_pinGrid;
+	NetWeb m_netWeb;
+	QualityGovernor m_governor;
+	static const int kQualityIdleFrames = 30; // still frames before full quality is back
+	bool m_wantsFrame = false;
+	std::vector<WebLine> m_webLines;
+	std::vector<WebMark> m_webMarks;
+	std::vector<char> m_webVisible;
+	static const size_t kMaxNetWebLines = 4096;
+	PinGlyphs m_pinGlyphs;
+	std::vector<PinStamp> m_pinStamps;
+	struct VisiblePin {
+		Pin *pin;
+		ImVec2 pos; // screen
+	};
+	std::vector<std::vector<VisiblePin>> m_visiblePins; // one list per culling worker
+	std::vector<uint32_t> m_pinCandidates;
+	Picker m_picker;
+	std::vector<uint32_t> m_pickCandidates;
+	std::vector<uint32_t> m_annotationsHovered;
+	Picker &BoardPicker();
+	int PickSide() const;
+	SelectionBand m_band;
+	ImVec2 m_bandLastScreen;
+	std::vector<uint32_t> m_bandPins, m_bandParts;
+	std::vector<ImVec2> m_bandOutline;
+	void ApplyBand(bool add);
+	void DrawSelectionBand(ImDrawList *draw);
+	std::vector<Component *> m_visibleParts;
+	ParallelDraw m_partsDraw;
+	LabelCache m_labelCache;
+	LabelPlacer m_labelPlacer;
+	std::vector<LabelRequest> m_pinLabels;
+	BoardOutline m_boardOutline;
+	BoardRegistry m_registry;
+	BoardStats m_stats;
 	bool m_flipVertically = true;
 
 	// Annotation layer specific
 	bool m_annotationsVisible = true;
 
-	// Do a hacky thing (memcpy the window draw list) to save us from rerendering
-	// the board
-	// The app will crash or break if this flag is not set when it should be.
-	bool m_needsRedraw = true;
+	/*
+	 * Retained board geometry, one set of layers for each time the board
+	 * gets drawn in a frame (split view halves, second side of a dual
+	 * view).  Layers are re-recorded when invalidated, when the view they
+	 * were recorded for changes, or for the selection dependent ones when
+	 * the selection does.  Pans and zooms are applied to the recorded
+	 * vertices instead, see DrawBoard().
+	 */
+	static const int kMaxBoardViews = 4;
+	RetainedLayer m_layers[kMaxBoardViews][NUM_BOARD_LAYERS];
+	uint32_t m_layersDirty[kMaxBoardViews] = {kLayerMaskAll, kLayerMaskAll, kLayerMaskAll, kLayerMaskAll};
+	BoardViewState m_layersView[kMaxBoardViews];
+	BoardSelectionState m_layersSelection[kMaxBoardViews];
+	ImVec2 m_layersPan[kMaxBoardViews];
+	float m_layersScale[kMaxBoardViews] = {};
+	int m_layersStill[kMaxBoardViews] = {};    // frames since the last pan or zoom
+	float m_cullMargin = 0.5f;                 // recorded around the surface, fraction of its size
+	LayerTransform m_boardLayerXf;             // first view's board layer this frame, shared by the others
+	ImVec2 m_boardLayerOrigin;                 // and where that view put the board origin
+	ImDrawList *m_layerScratch = nullptr;
+	int m_boardViewIndex       = 0;
+
+	void InvalidateLayers(uint32_t mask = kLayerMaskAll);
+	BoardViewState CurrentViewState(void);
+
+	/*
+	 * Per element styles, indexed by BoardElement::style_index_.  Tcl
+	 * shading changes queue just the elements concerned, highlights
+	 * appended through HighlightPin() / HighlightPart() only touch the
+	 * new entries, anything else redoes the lot.
+	 */
+	std::vector<PinStyle> m_pinStyles;
+	std::vector<PartStyle> m_partStyles;
+	std::vector<Pin *> m_pinStylesDirty;
+	std::vector<Component *> m_partStylesDirty;
+	ElementStyleState m_stylesState;
+	bool m_stylesValid = false;
+
+	void UpdateStyles(void);
+	void InvalidateStyles(void);
+	void InvalidateStyle(Pin *pin);
+	void InvalidateStyle(Component *part);
+
+	/*
+	 * Tcl commands run on background interpreter threads as well, so
+	 * InvalidateLayers() and the InvalidateStyle*() only queue what they
+	 * drop here; the UI thread takes it in with TakeInvalidations() before
+	 * it looks at m_layersDirty and the styles.  Renames likewise only
+	 * flag the names, UpdateNames() reindexes them.
+	 */
+	std::mutex m_invalidMutex;
+	uint32_t m_invalidLayers = 0;
+	bool m_invalidStyles     = false;
+	bool m_invalidNames      = false;
+	std::vector<Pin *> m_invalidPins;
+	std::vector<Component *> m_invalidParts;
+	void TakeInvalidations(void);
+	void InvalidateNames(void);
+	void UpdateNames(void);
+	void IndexNames(void);
+	ElementStyleState CurrentStyleState(void);
+	void ComputePinStyle(const Pin &pin, PinStyle &style);
+	void ComputePartStyle(const Component &part, PartStyle &style);
 	bool m_draggingLastFrame;
 	bool m_showContextMenu;
 	//	bool m_showNetfilterSearch;
@@ -340,7 +566,7 @@ struct BoardView {
 		}
 	}
 
-	std::mutex m_DrawNodes_mutex;
+	NodeOverlay m_nodes; // Tcl add_node lines
 	
 	void ShowNetList(bool *p_open);
 	void ShowPartList(bool *p_open);
@@ -351,9 +577,11 @@ struct BoardView {
 	void DrawPartTooltips(ImDrawList *draw);
 	void DrawPinTooltips(ImDrawList *draw);
 	void DrawAnnotations(ImDrawList *draw);
+	void ShowAnnotationTooltip(void);
 	void DrawOutline(ImDrawList *draw);
 	void DrawNodes(ImDrawList * draw);
 	void DrawPins(ImDrawList *draw);
+	void DrawPinDensity(ImDrawList *draw, BBox const &coord_vis, uint32_t color, float alpha);
 	void DrawParts(ImDrawList *draw);
 	bool DrawPartSymbol(ImDrawList * draw, Component * c);
 	void DrawBoard();
@@ -374,10 +602,22 @@ struct BoardView {
 				{ std::max(p1.x, p2.x), std::max(p1.y, p2.y) } };
 	}
 
+	// CoordToScreen() of the side being drawn as one affine transform, for draw passes to hold on to
+	ViewTransform CoordTransform();
+	// Batched CoordToScreen() and its exact inverse (which, unlike ScreenToCoord(), doesn't try to work out which side of a split view a point is in)
+	void CoordToScreen(const ImVec2 *in, ImVec2 *out, size_t n);
+	void ScreenToCoord(const ImVec2 *in, ImVec2 *out, size_t n);
+	// Points per second through the batched and the single point CoordToScreen()
+	void BenchCoordToScreen(size_t n, double &batched, double &single);
+	std::vector<ImVec2> m_coordScratch;
+
 	// void Move(float x, float y);
 	void Rotate(int count);
 	void DrawSelectedPins(ImDrawList *draw);
 	void ClearAllHighlights(void);
+	void HighlightPin(const obv_shared_ptr<Pin> &pin);
+	void HighlightPart(const obv_shared_ptr<Component> &part);
+	void HighlightsChanged(void);
 
 	// Sets the center of the screen to (x,y) in board space
 	void SetTarget(float x, float y);
@@ -401,7 +641,7 @@ struct BoardView {
 	void SearchNetNoClear(const char *net);
 	void SearchCompound(const char *item);
 	void SearchCompoundNoClear(const char *item);
-	std::pair<SharedVector<Component>, SharedVector<Net>> SearchPartsAndNets(const char *search, int limit);
+	void PreviewSearchResults(const SearchWorker::Results &results);
 
 	void SetLastFileOpenName(const std::string &name);
 	void FlipBoard(int mode = 0);
@@ -0,0 +1,163 @@
+#include "ElementList.h"
+#include "utils.h"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <cstdio>
+
+ElementList::ElementList(TcharStringCallback cbSelected) : cbSelected_(cbSelected) {}
+
+void ElementList::Reset() {
+	for (auto &order : orders_) order.clear();
+	matched_.assign(count_, 0);
+	matches_.clear();
+	filtering_ = false;
+	filter_[0] = '\0';
+	selected_  = -1;
+}
+
+const std::vector<uint32_t> &ElementList::Order(Column column) {
+	auto &order = orders_[column];
+	if (!order.empty() || !count_) return order;
+
+	order.resize(count_);
+	for (uint32_t i = 0; i < count_; i++) order[i] = i;
+
+	switch (column) {
+		case kColumnName: {
+			std::vector<std::string> keys(count_);
+			for (uint32_t i = 0; i < count_; i++) keys[i] = natural_sort_key(Name(i));
+			std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+			break;
+		}
+		case kColumnPins: {
+			// then by name, so runs of equal counts read in order
+			auto &by_name = Order(kColumnName);
+			std::vector<uint32_t> rank(count_);
+			for (uint32_t r = 0; r < count_; r++) rank[by_name[r]] = r;
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				uint32_t pa = Pins(a), pb = Pins(b);
+				return pa != pb ? pa < pb : rank[a] < rank[b];
+			});
+			break;
+		}
+		case kColumnSide: {
+			order = Order(kColumnName);
+			std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return Side(a) < Side(b); });
+			break;
+		}
+		default: break;
+	}
+	return order;
+}
+
+void ElementList::Refilter(const NameIndex &index) {
+	for (uint32_t i : matches_) matched_[i] = 0;
+	matches_.clear();
+
+	filtering_ = filter_[0] != '\0';
+	if (filtering_) {
+		index.Find(NameIndex::Fold(filter_), SearchMode::Sub, -1, matches_);
+		for (uint32_t i : matches_) {
+			if (i < count_) matched_[i] = 1;
+		}
+	}
+	Resort();
+}
+
+void ElementList::Resort() {
+	auto &order = Order(sort_);
+
+	rows_.clear();
+	auto take = [this](uint32_t i) {
+		if (!filtering_ || matched_[i]) rows_.push_back(i);
+	};
+	if (descending_) {
+		for (auto it = order.rbegin(); it != order.rend(); ++it) take(*it);
+	} else {
+		for (uint32_t i : order) take(i);
+	}
+}
+
+void ElementList::DrawList(const char *window, Board *board, size_t count, const void *first, Column last, const NameIndex &index) {
+	static const char *names[kColumns] = {"Name", "Pins", "Side"};
+
+	// TODO: export / fix dimensions & behaviour
+	int width  = 400;
+	int height = 640;
+
+	ImGui::SetNextWindowSize(ImVec2(width, height));
+	ImGui::Begin(window);
+
+	if (board != board_ || count != count_ || first != first_) {
+		board_ = board;
+		count_ = board ? count : 0;
+		first_ = first;
+		Reset();
+		Resort();
+	}
+
+	// names changed under us (Tcl renames), so did their order and matches
+	if (index.Version() != index_version_) {
+		index_version_ = index.Version();
+		for (auto &order : orders_) order.clear();
+		Refilter(index);
+	}
+
+	ImGui::PushItemWidth(-1);
+	if (ImGui::InputText("##filter", filter_, sizeof(filter_))) Refilter(index);
+	ImGui::PopItemWidth();
+
+	ImGui::Columns(last + 1, window);
+	ImGui::Separator();
+
+	for (int c = 0; c <= last; c++) {
+		char label[32];
+		snprintf(label, sizeof(label), "%s%s", names[c], sort_ != c ? "" : descending_ ? " v" : " ^");
+		if (ImGui::Selectable(label, sort_ == c)) {
+			descending_ = sort_ == c ? !descending_ : false;
+			sort_       = Column(c);
+			Resort();
+		}
+		ImGui::NextColumn();
+	}
+	ImGui::Separator();
+
+	if (board) {
+		ImGuiListClipper clipper;
+		clipper.Begin(rows_.size());
+		while (clipper.Step()) {
+			for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+				uint32_t i              = rows_[r];
+				const std::string &name = Name(i);
+
+				ImGui::PushID(int(i));
+				if (ImGui::Selectable(
+				        name.c_str(), selected_ == int(i), ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
+					selected_ = i;
+					if (ImGui::IsMouseDoubleClicked(0)) {
+						cbSelected_(name.c_str());
+					}
+				}
+				ImGui::PopID();
+				ImGui::NextColumn();
+
+				if (last >= kColumnPins) {
+					ImGui::Text("%u", Pins(i));
+					ImGui::NextColumn();
+				}
+				if (last >= kColumnSide) {
+					int side = Side(i);
+					ImGui::TextUnformatted(side == kBoardSideTop ? "Top" : side == kBoardSideBottom ? "Bottom" : "Both");
+					ImGui::NextColumn();
+				}
+			}
+		}
+		clipper.End();
+	}
+	ImGui::Columns(1);
+	ImGui::Separator();
+
+	ImGui::End();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Board.h"
+#include "Searcher.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * What the part and net list windows have in common: a table of the
+ * board's elements that can be sorted by name (naturally, C2 before C10),
+ * pin count or side, and filtered through the search index.
+ *
+ * The orders are worked out once per board (each the first time it's
+ * asked for) as permutations of the element indices, sorting and
+ * filtering only rebuilds the list of rows, and drawing is just the rows
+ * ImGuiListClipper says are visible, nothing gets allocated per frame.
+ */
+class ElementList {
+  public:
+	enum Column { kColumnName, kColumnPins, kColumnSide, kColumns };
+
+	explicit ElementList(TcharStringCallback cbSelected);
+	virtual ~ElementList() {}
+
+  protected:
+	// Draws the window for count elements of board, columns up to last
+	void DrawList(const char *window, Board *board, size_t count, const void *first, Column last, const NameIndex &index);
+
+	virtual const std::string &Name(uint32_t i) const = 0;
+	virtual uint32_t Pins(uint32_t i) const           = 0;
+	virtual int Side(uint32_t) const {
+		return kBoardSideBoth;
+	}
+
+  private:
+	void Reset();
+	void Refilter(const NameIndex &index);
+	void Resort();
+	const std::vector<uint32_t> &Order(Column column);
+
+	TcharStringCallback cbSelected_;
+
+	// the board the orders are for
+	Board *board_       = nullptr;
+	size_t count_       = 0;
+	const void *first_  = nullptr;
+
+	std::vector<uint32_t> orders_[kColumns]; // empty until first needed
+	Column sort_     = kColumnName;
+	bool descending_ = false;
+
+	char filter_[128] = "";
+	std::vector<uint8_t> matched_;
+	std::vector<uint32_t> matches_;
+	bool filtering_         = false;
+	uint32_t index_version_ = 0; // of the index matches_ came from
+
+	std::vector<uint32_t> rows_; // element indices in the order shown
+	int selected_ = -1;
+};
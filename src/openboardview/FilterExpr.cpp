@@ -0,0 +1,792 @@
+#include "FilterExpr.h"
+#include "ParallelDraw.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <strings.h>
+
+// past this integers stop being exact in a double, Tcl would go on with big integers
+static const double kMaxExact = 9007199254740992.0;
+
+class FilterExpr::Parser {
+	FilterExpr &m_e;
+	const std::string &m_s;
+	const std::vector<Object> &m_objects;
+	int m_plain;
+	size_t m_pos = 0;
+
+	void Skip() {
+		while (m_pos < m_s.size() && isspace((unsigned char)m_s[m_pos])) m_pos++;
+	}
+	bool Next(char c) {
+		Skip();
+		if (m_pos < m_s.size() && m_s[m_pos] == c) {
+			m_pos++;
+			return true;
+		}
+		return false;
+	}
+	bool Word(std::string &out) {
+		Skip();
+		size_t start = m_pos;
+		while (m_pos < m_s.size() && (isalnum((unsigned char)m_s[m_pos]) || m_s[m_pos] == '_')) m_pos++;
+		out = m_s.substr(start, m_pos - start);
+		return !out.empty();
+	}
+
+	int Add(Node n) {
+		m_e.m_nodes.push_back(std::move(n));
+		return int(m_e.m_nodes.size()) - 1;
+	}
+	const Node &At(int k) const {
+		return m_e.m_nodes[k];
+	}
+	bool Numeric(int k) const {
+		return At(k).type != kString;
+	}
+	// What can stand as a string on either side of a comparison: strings, and numbers as written
+	bool Text(int k) const {
+		return At(k).type == kString || At(k).op == kLiteral;
+	}
+
+	int Unary(Op op, Type type, int a) {
+		Node n;
+		n.op   = op;
+		n.type = type;
+		n.a    = a;
+		return Add(n);
+	}
+
+	bool Binary(Op op, int a, int b, int &out) {
+		Node n;
+		n.op = op;
+		n.a  = a;
+		n.b  = b;
+
+		bool numbers = Numeric(a) && Numeric(b);
+		bool ints    = At(a).type == kInt && At(b).type == kInt;
+		switch (op) {
+			case kMul:
+			case kDiv:
+			case kAdd:
+			case kSub:
+			case kMin:
+			case kMax:
+				if (!numbers) return false;
+				// min/max hand back one of their operands as it is, whose type isn't known here
+				if ((op == kMin || op == kMax) && At(a).type != At(b).type) return false;
+				n.type = ints ? kInt : kDouble;
+				break;
+			case kMod:
+				if (!ints) return false;
+				n.type = kInt;
+				break;
+			case kLt:
+			case kLe:
+			case kGt:
+			case kGe:
+			case kEq:
+			case kNe:
+				if (!numbers && !(Text(a) && Text(b))) return false;
+				n.type = kInt;
+				break;
+			case kStrEq:
+			case kStrNe:
+				if (!Text(a) || !Text(b)) return false;
+				n.type = kInt;
+				break;
+			case kAnd:
+			case kOr:
+				if (!numbers) return false;
+				n.type = kInt;
+				break;
+			default: return false;
+		}
+		out = Add(n);
+		return true;
+	}
+
+	// The operator at m_pos, if it's one of those handled
+	bool PeekOperator(Op &op, int &precedence, size_t &length) {
+		Skip();
+		static const struct {
+			const char *text;
+			Op op;
+			int precedence;
+		} ops[] = {
+		    {"&&", kAnd, 1},
+		    {"||", kOr, 0},
+		    {"==", kEq, 3},
+		    {"!=", kNe, 3},
+		    {"<=", kLe, 4},
+		    {">=", kGe, 4},
+		    {"eq", kStrEq, 2},
+		    {"ne", kStrNe, 2},
+		    {"<", kLt, 4},
+		    {">", kGt, 4},
+		    {"+", kAdd, 5},
+		    {"-", kSub, 5},
+		    {"*", kMul, 6},
+		    {"/", kDiv, 6},
+		    {"%", kMod, 6},
+		};
+		// ** << >> aren't handled and mustn't be read as the operator they start with
+		if (m_s.compare(m_pos, 2, "**") == 0 || m_s.compare(m_pos, 2, "<<") == 0 || m_s.compare(m_pos, 2, ">>") == 0) return false;
+		for (auto &o : ops) {
+			size_t len = strlen(o.text);
+			if (m_s.compare(m_pos, len, o.text) != 0) continue;
+			if (isalpha((unsigned char)o.text[0]) && m_pos + len < m_s.size() && (isalnum((unsigned char)m_s[m_pos + len]) || m_s[m_pos + len] == '_')) continue;
+			op         = o.op;
+			precedence = o.precedence;
+			length     = len;
+			return true;
+		}
+		return false;
+	}
+
+	// Precedence climbing, all of Tcl's binary operators are left associative
+	bool Expression(int min_precedence, int &out) {
+		if (!Operand(out)) return false;
+		for (;;) {
+			Op op;
+			int precedence;
+			size_t length;
+			if (!PeekOperator(op, precedence, length) || precedence < min_precedence) return true;
+			m_pos += length;
+
+			int rhs;
+			if (!Expression(precedence + 1, rhs) || !Binary(op, out, rhs, out)) return false;
+		}
+	}
+
+	bool Operand(int &out) {
+		Skip();
+		if (m_pos >= m_s.size()) return false;
+
+		char c = m_s[m_pos];
+		if (c == '-' || c == '+' || c == '!') {
+			m_pos++;
+			int a;
+			if (!Operand(a) || !Numeric(a)) return false;
+			if (c == '-') {
+				out = Unary(kNeg, At(a).type, a);
+			} else if (c == '!') {
+				out = Unary(kNot, kInt, a);
+			} else {
+				out = a;
+			}
+			return true;
+		}
+		if (c == '(') {
+			m_pos++;
+			return Expression(0, out) && Next(')');
+		}
+		if (c == '$') return Variable(out);
+		if (c == '[') return Command(out);
+		if (c == '"' || c == '{') return String(out);
+		if (isdigit((unsigned char)c) || c == '.') return Number(out);
+		if (isalpha((unsigned char)c)) return Function(out);
+		return false;
+	}
+
+	bool Number(int &out) {
+		size_t start = m_pos;
+		Node n;
+		n.op   = kLiteral;
+		n.type = kInt;
+
+		if (m_s.compare(m_pos, 2, "0x") == 0 || m_s.compare(m_pos, 2, "0X") == 0) {
+			m_pos += 2;
+			size_t digits = m_pos;
+			while (m_pos < m_s.size() && isxdigit((unsigned char)m_s[m_pos])) m_pos++;
+			if (m_pos == digits || m_pos - digits > 13) return false;
+			n.number = double(strtoll(m_s.c_str() + digits, nullptr, 16));
+		} else {
+			size_t digits = 0;
+			while (m_pos < m_s.size() && isdigit((unsigned char)m_s[m_pos])) m_pos++, digits++;
+			// 0 followed by digits is octal to Tcl 8, decimal to 9
+			if (digits > 1 && m_s[start] == '0') return false;
+			if (m_pos < m_s.size() && m_s[m_pos] == '.') {
+				n.type = kDouble;
+				m_pos++;
+				while (m_pos < m_s.size() && isdigit((unsigned char)m_s[m_pos])) m_pos++, digits++;
+			}
+			if (!digits) return false;
+			if (m_pos < m_s.size() && (m_s[m_pos] == 'e' || m_s[m_pos] == 'E')) {
+				n.type = kDouble;
+				m_pos++;
+				if (m_pos < m_s.size() && (m_s[m_pos] == '+' || m_s[m_pos] == '-')) m_pos++;
+				size_t exponent = m_pos;
+				while (m_pos < m_s.size() && isdigit((unsigned char)m_s[m_pos])) m_pos++;
+				if (m_pos == exponent) return false;
+			}
+			n.number = strtod(m_s.c_str() + start, nullptr);
+			if (n.type == kInt && n.number >= kMaxExact) return false;
+		}
+		if (m_pos < m_s.size() && (isalnum((unsigned char)m_s[m_pos]) || m_s[m_pos] == '_' || m_s[m_pos] == '.')) return false;
+
+		n.text = m_s.substr(start, m_pos - start);
+		out    = Add(n);
+		return true;
+	}
+
+	bool String(int &out) {
+		Node n;
+		n.op   = kLiteral;
+		n.type = kString;
+
+		if (m_s[m_pos] == '"') {
+			size_t end = m_s.find('"', m_pos + 1);
+			if (end == std::string::npos) return false;
+			n.text = m_s.substr(m_pos + 1, end - m_pos - 1);
+			// substitutions are left to Tcl
+			if (n.text.find_first_of("\\$[") != std::string::npos) return false;
+			m_pos = end + 1;
+		} else {
+			int depth    = 0;
+			size_t start = m_pos + 1;
+			for (; m_pos < m_s.size(); m_pos++) {
+				if (m_s[m_pos] == '\\') return false;
+				if (m_s[m_pos] == '{') depth++;
+				if (m_s[m_pos] == '}' && --depth == 0) break;
+			}
+			if (m_pos >= m_s.size()) return false;
+			n.text = m_s.substr(start, m_pos - start);
+			m_pos++;
+		}
+		n.reading = Read(n.text, n.number);
+		out       = Add(n);
+		return true;
+	}
+
+	bool Name(std::string &name) {
+		if (m_pos >= m_s.size() || m_s[m_pos] != '$') return false;
+		m_pos++;
+		if (m_pos < m_s.size() && m_s[m_pos] == '{') {
+			size_t end = m_s.find('}', m_pos);
+			if (end == std::string::npos) return false;
+			name  = m_s.substr(m_pos + 1, end - m_pos - 1);
+			m_pos = end + 1;
+			return !name.empty();
+		}
+		size_t start = m_pos;
+		while (m_pos < m_s.size() && (isalnum((unsigned char)m_s[m_pos]) || m_s[m_pos] == '_')) m_pos++;
+		name = m_s.substr(start, m_pos - start);
+		// namespaces and array elements are Tcl's
+		if (m_pos < m_s.size() && (m_s[m_pos] == ':' || m_s[m_pos] == '(')) return false;
+		return !name.empty();
+	}
+
+	int Slot(const std::string &name) const {
+		for (size_t i = 0; i < m_objects.size(); i++) {
+			if (m_objects[i].name && name == m_objects[i].name) return int(i);
+		}
+		return -1;
+	}
+
+	bool Variable(int &out) {
+		std::string name;
+		if (!Name(name) || Slot(name) >= 0) return false;
+
+		int slot         = m_plain;
+		std::string prop = name;
+		for (size_t i = 0; i < m_objects.size(); i++) {
+			const char *prefix = m_objects[i].prefix;
+			if (prefix && name.size() > strlen(prefix) && name.compare(0, strlen(prefix), prefix) == 0) {
+				slot = int(i);
+				prop = name.substr(strlen(prefix));
+				break;
+			}
+		}
+		if (slot < 0) return false;
+
+		auto &props = m_e.m_schema.properties;
+		for (size_t i = 0; i < props.size(); i++) {
+			if (strcasecmp(props[i].name, prop.c_str()) == 0) {
+				Node n;
+				n.op       = kProperty;
+				n.type     = props[i].type;
+				n.slot     = slot;
+				n.property = int(i);
+				out        = Add(n);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// [distance ?-norm? $x $y] and [angle ?-ortho? $x $y]
+	bool Command(int &out) {
+		m_pos++;
+		std::string command;
+		if (!Word(command)) return false;
+
+		Node n;
+		n.type = kDouble;
+		if (command == "distance" && m_e.m_schema.distance) {
+			n.op = kDistance;
+		} else if (command == "angle" && m_e.m_schema.angle) {
+			n.op = kAngle;
+		} else {
+			return false;
+		}
+
+		for (;;) {
+			Skip();
+			if (m_pos >= m_s.size() || m_s[m_pos] != '-') break;
+			m_pos++;
+			std::string option;
+			if (!Word(option)) return false;
+			if (n.op == kDistance && option == "norm") continue;
+			if (n.op == kAngle && option == "ortho") {
+				n.ortho = true;
+				continue;
+			}
+			return false;
+		}
+
+		std::string x, y;
+		Skip();
+		if (!Name(x)) return false;
+		Skip();
+		if (!Name(y)) return false;
+		n.slot  = Slot(x);
+		n.slot2 = Slot(y);
+		if (n.slot < 0 || n.slot2 < 0 || !Next(']')) return false;
+
+		out = Add(n);
+		return true;
+	}
+
+	bool Function(int &out) {
+		std::string name;
+		if (!Word(name) || !Next('(')) return false;
+
+		std::vector<int> args;
+		if (!Next(')')) {
+			do {
+				int a;
+				if (!Expression(0, a) || !Numeric(a)) return false;
+				args.push_back(a);
+			} while (Next(','));
+			if (!Next(')')) return false;
+		}
+
+		if (name == "min" || name == "max") {
+			if (args.empty()) return false;
+			out = args[0];
+			for (size_t i = 1; i < args.size(); i++) {
+				if (!Binary(name == "min" ? kMin : kMax, out, args[i], out)) return false;
+			}
+			return true;
+		}
+		if (args.size() != 1) return false;
+
+		int a = args[0];
+		if (name == "abs") {
+			out = Unary(kAbs, At(a).type, a);
+		} else if (name == "sqrt") {
+			out = Unary(kSqrt, kDouble, a);
+		} else if (name == "double") {
+			out = Unary(kToDouble, kDouble, a);
+		} else if (name == "int") {
+			out = Unary(kToInt, kInt, a);
+		} else if (name == "round") {
+			out = Unary(kRound, kInt, a);
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+  public:
+	Parser(FilterExpr &e, const std::string &s, const std::vector<FilterExpr::Object> &objects, int plain)
+	    : m_e(e), m_s(s), m_objects(objects), m_plain(plain) {}
+
+	bool Parse() {
+		int root;
+		if (!Expression(0, root)) return false;
+		Skip();
+		return m_pos == m_s.size() && root == int(m_e.m_nodes.size()) - 1 && Numeric(root);
+	}
+};
+
+FilterExpr::Reading FilterExpr::Read(const std::string &s, double &number) {
+	if (s.empty()) return kReadsString;
+	if (isspace((unsigned char)s.front()) || isspace((unsigned char)s.back())) return kReadsUnsure;
+
+	size_t i = 0;
+	if (s[i] == '+' || s[i] == '-') i++;
+	// hex, binary, octal, infinities: forms Tcl reads and aren't worth getting exactly right here
+	if (i + 1 < s.size() && s[i] == '0' && (isdigit((unsigned char)s[i + 1]) || strchr("xXbBoOdD", s[i + 1]))) return kReadsUnsure;
+	if (strncasecmp(s.c_str() + i, "inf", 3) == 0 || strncasecmp(s.c_str() + i, "nan", 3) == 0) return kReadsUnsure;
+
+	size_t digits = 0;
+	while (i < s.size() && isdigit((unsigned char)s[i])) i++, digits++;
+	if (i < s.size() && s[i] == '.') {
+		i++;
+		while (i < s.size() && isdigit((unsigned char)s[i])) i++, digits++;
+	}
+	if (!digits) return kReadsString;
+	if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+		i++;
+		if (i < s.size() && (s[i] == '+' || s[i] == '-')) i++;
+		size_t exponent = i;
+		while (i < s.size() && isdigit((unsigned char)s[i])) i++;
+		if (i == exponent) return kReadsString;
+	}
+	if (i != s.size()) return kReadsString;
+
+	number = strtod(s.c_str(), nullptr);
+	return kReadsNumber;
+}
+
+void FilterExpr::Clear() {
+	m_nodes.clear();
+	m_schema = Schema();
+}
+
+bool FilterExpr::Compile(const std::string &expr, const Schema &schema, const std::vector<Object> &objects, int plain) {
+	Clear();
+	m_schema = schema;
+
+	Parser parser(*this, expr, objects, plain);
+	if (!parser.Parse()) {
+		Clear();
+		return false;
+	}
+
+	m_num.assign(m_nodes.size() * kBatch, 0.0);
+	m_str.assign(m_nodes.size() * kBatch, nullptr);
+	m_undecided.assign(m_nodes.size() * kBatch, 0);
+	return true;
+}
+
+bool FilterExpr::CompileKey(const std::string &expr, const Schema &schema, const std::vector<Object> &objects, int a, int b, bool &descending) {
+	if (!Compile(expr, schema, objects, -1)) return false;
+
+	const Node &root = m_nodes.back();
+	if (root.op != kLt && root.op != kGt) {
+		Clear();
+		return false;
+	}
+
+	int key = root.a, other = root.b;
+	descending = root.op == kGt;
+	if (Depends(key, b)) {
+		std::swap(key, other);
+		descending = !descending;
+	}
+	if (m_nodes[key].type == kString || !Depends(key, a) || Depends(key, b) || !Mirrors(key, other, a, b)) {
+		Clear();
+		return false;
+	}
+
+	Keep(key);
+	return true;
+}
+
+bool FilterExpr::Depends(int node, int slot) const {
+	const Node &n = m_nodes[node];
+	return n.slot == slot || n.slot2 == slot || (n.a >= 0 && Depends(n.a, slot)) || (n.b >= 0 && Depends(n.b, slot));
+}
+
+bool FilterExpr::Mirrors(int x, int y, int a, int b) const {
+	const Node &p = m_nodes[x], &q = m_nodes[y];
+	auto swap     = [a, b](int slot) { return slot == a ? b : slot == b ? a : slot; };
+
+	if (p.op != q.op || p.type != q.type || p.property != q.property || p.ortho != q.ortho || p.number != q.number || p.text != q.text) return false;
+	if (swap(p.slot) != q.slot || swap(p.slot2) != q.slot2) return false;
+	if ((p.a >= 0) != (q.a >= 0) || (p.b >= 0) != (q.b >= 0)) return false;
+	return (p.a < 0 || Mirrors(p.a, q.a, a, b)) && (p.b < 0 || Mirrors(p.b, q.b, a, b));
+}
+
+void FilterExpr::Keep(int root) {
+	// children come before their parents, one pass down from root finds them all
+	std::vector<uint8_t> used(root + 1, 0);
+	used[root] = 1;
+	for (int k = root; k >= 0; k--) {
+		if (!used[k]) continue;
+		if (m_nodes[k].a >= 0) used[m_nodes[k].a] = 1;
+		if (m_nodes[k].b >= 0) used[m_nodes[k].b] = 1;
+	}
+
+	std::vector<int> index(root + 1, -1);
+	std::vector<Node> kept;
+	for (int k = 0; k <= root; k++) {
+		if (!used[k]) continue;
+		Node n = m_nodes[k];
+		if (n.a >= 0) n.a = index[n.a];
+		if (n.b >= 0) n.b = index[n.b];
+		index[k] = int(kept.size());
+		kept.push_back(std::move(n));
+	}
+	m_nodes.swap(kept);
+
+	m_num.assign(m_nodes.size() * kBatch, 0.0);
+	m_str.assign(m_nodes.size() * kBatch, nullptr);
+	m_undecided.assign(m_nodes.size() * kBatch, 0);
+}
+
+bool FilterExpr::Uses(int slot) const {
+	for (auto &n : m_nodes) {
+		if (n.slot == slot || n.slot2 == slot) return true;
+	}
+	return false;
+}
+
+void FilterExpr::Evaluate(const Node &n, int k, size_t from, size_t count, const void *const *items, int vary, const void *const *fixed) {
+	double *v             = &m_num[k * kBatch];
+	const std::string **s = &m_str[k * kBatch];
+	uint8_t *u            = &m_undecided[k * kBatch];
+	const double *a       = n.a >= 0 ? &m_num[n.a * kBatch] : nullptr;
+	const double *b       = n.b >= 0 ? &m_num[n.b * kBatch] : nullptr;
+	const uint8_t *ua     = n.a >= 0 ? &m_undecided[n.a * kBatch] : nullptr;
+	const uint8_t *ub     = n.b >= 0 ? &m_undecided[n.b * kBatch] : nullptr;
+
+	auto object = [&](int slot, size_t i) { return slot == vary ? items[from + i] : fixed[slot]; };
+
+	switch (n.op) {
+		case kLiteral:
+			for (size_t i = 0; i < count; i++) {
+				v[i] = n.number;
+				s[i] = &n.text;
+				u[i] = 0;
+			}
+			return;
+		case kProperty: {
+			const Property &p = m_schema.properties[n.property];
+			if (p.type == kString) {
+				for (size_t i = 0; i < count; i++) s[i] = &p.string(object(n.slot, i));
+			} else {
+				for (size_t i = 0; i < count; i++) v[i] = p.number(object(n.slot, i));
+			}
+			std::fill(u, u + count, 0);
+			return;
+		}
+		case kDistance:
+			for (size_t i = 0; i < count; i++) v[i] = double(m_schema.distance(object(n.slot, i), object(n.slot2, i)));
+			std::fill(u, u + count, 0);
+			return;
+		case kAngle:
+			for (size_t i = 0; i < count; i++) v[i] = double(m_schema.angle(object(n.slot, i), object(n.slot2, i), n.ortho));
+			std::fill(u, u + count, 0);
+			return;
+		case kAnd:
+			for (size_t i = 0; i < count; i++) {
+				v[i] = a[i] != 0 && b[i] != 0;
+				u[i] = ua[i] || (a[i] != 0 && ub[i]);
+			}
+			return;
+		case kOr:
+			for (size_t i = 0; i < count; i++) {
+				v[i] = a[i] != 0 || b[i] != 0;
+				u[i] = ua[i] || (a[i] == 0 && ub[i]);
+			}
+			return;
+		default: break;
+	}
+
+	for (size_t i = 0; i < count; i++) u[i] = ua[i] | (ub ? ub[i] : 0);
+
+	switch (n.op) {
+		case kNeg:
+			for (size_t i = 0; i < count; i++) v[i] = -a[i];
+			break;
+		case kNot:
+			for (size_t i = 0; i < count; i++) v[i] = a[i] == 0;
+			break;
+		case kAbs:
+			for (size_t i = 0; i < count; i++) v[i] = fabs(a[i]);
+			break;
+		case kSqrt:
+			for (size_t i = 0; i < count; i++) {
+				v[i] = sqrt(a[i]);
+				if (a[i] < 0) u[i] = 1;
+			}
+			break;
+		case kToDouble:
+			for (size_t i = 0; i < count; i++) v[i] = a[i];
+			break;
+		case kToInt:
+			for (size_t i = 0; i < count; i++) v[i] = trunc(a[i]);
+			break;
+		case kRound:
+			for (size_t i = 0; i < count; i++) v[i] = round(a[i]);
+			break;
+		case kMin:
+			for (size_t i = 0; i < count; i++) v[i] = std::min(a[i], b[i]);
+			break;
+		case kMax:
+			for (size_t i = 0; i < count; i++) v[i] = std::max(a[i], b[i]);
+			break;
+		case kMul:
+			for (size_t i = 0; i < count; i++) v[i] = a[i] * b[i];
+			break;
+		case kAdd:
+			for (size_t i = 0; i < count; i++) v[i] = a[i] + b[i];
+			break;
+		case kSub:
+			for (size_t i = 0; i < count; i++) v[i] = a[i] - b[i];
+			break;
+		case kDiv:
+			if (n.type == kInt) {
+				// rounding down, not towards zero
+				for (size_t i = 0; i < count; i++) {
+					if (b[i] == 0) {
+						u[i] = 1;
+						continue;
+					}
+					int64_t x = int64_t(a[i]), y = int64_t(b[i]), q = x / y;
+					if (x % y != 0 && (x < 0) != (y < 0)) q--;
+					v[i] = double(q);
+				}
+			} else {
+				for (size_t i = 0; i < count; i++) {
+					if (b[i] == 0) u[i] = 1;
+					v[i] = a[i] / b[i];
+				}
+			}
+			break;
+		case kMod:
+			// the remainder takes the divisor's sign
+			for (size_t i = 0; i < count; i++) {
+				if (b[i] == 0) {
+					u[i] = 1;
+					continue;
+				}
+				int64_t x = int64_t(a[i]), y = int64_t(b[i]), r = x % y;
+				if (r != 0 && (r < 0) != (y < 0)) r += y;
+				v[i] = double(r);
+			}
+			break;
+		case kStrEq:
+		case kStrNe: {
+			const std::string *const *sa = &m_str[n.a * kBatch];
+			const std::string *const *sb = &m_str[n.b * kBatch];
+			for (size_t i = 0; i < count; i++) v[i] = (*sa[i] == *sb[i]) == (n.op == kStrEq);
+			break;
+		}
+		case kLt:
+		case kLe:
+		case kGt:
+		case kGe:
+		case kEq:
+		case kNe: {
+			auto compare = [&n](double x, double y) {
+				switch (n.op) {
+					case kLt: return x < y;
+					case kLe: return x <= y;
+					case kGt: return x > y;
+					case kGe: return x >= y;
+					case kEq: return x == y;
+					default: return x != y;
+				}
+			};
+			const Node &na = m_nodes[n.a], &nb = m_nodes[n.b];
+			if (na.type != kString && nb.type != kString) {
+				for (size_t i = 0; i < count; i++) v[i] = compare(a[i], b[i]);
+				break;
+			}
+
+			// strings compare as numbers when both read as one, as strings otherwise
+			const std::string *const *sa = &m_str[n.a * kBatch];
+			const std::string *const *sb = &m_str[n.b * kBatch];
+			auto read = [](const Node &node, const std::string *s, double &x) {
+				if (node.op == kLiteral) {
+					x = node.number;
+					return node.type == kString ? node.reading : kReadsNumber;
+				}
+				return Read(*s, x);
+			};
+			for (size_t i = 0; i < count; i++) {
+				double x = 0, y = 0;
+				Reading ra = read(na, sa[i], x), rb = read(nb, sb[i], y);
+				if (ra == kReadsUnsure || rb == kReadsUnsure) {
+					u[i] = 1;
+				} else if (ra == kReadsNumber && rb == kReadsNumber) {
+					v[i] = compare(x, y);
+				} else {
+					v[i] = compare(sa[i]->compare(*sb[i]), 0);
+				}
+			}
+			break;
+		}
+		default: break;
+	}
+
+	if (n.type == kInt && (n.op == kMul || n.op == kAdd || n.op == kSub || n.op == kNeg || n.op == kAbs)) {
+		for (size_t i = 0; i < count; i++) {
+			if (fabs(v[i]) >= kMaxExact) u[i] = 1;
+		}
+	}
+}
+
+void FilterExpr::Run(const void *const *items, size_t count, int vary, const void *const *fixed, double *value, uint8_t *decided) {
+	if (m_nodes.empty()) return;
+
+	// what doesn't depend on the varying slot is worked out once and spread over the batch
+	m_varying.assign(m_nodes.size(), 0);
+	for (size_t k = 0; k < m_nodes.size(); k++) {
+		const Node &n = m_nodes[k];
+		m_varying[k]  = n.slot == vary || n.slot2 == vary || (n.a >= 0 && m_varying[n.a]) || (n.b >= 0 && m_varying[n.b]);
+	}
+
+	for (size_t from = 0; from < count; from += kBatch) {
+		size_t batch = std::min(kBatch, count - from);
+
+		for (size_t k = 0; k < m_nodes.size(); k++) {
+			if (m_varying[k]) {
+				Evaluate(m_nodes[k], int(k), from, batch, items, vary, fixed);
+			} else if (from == 0) {
+				Evaluate(m_nodes[k], int(k), from, 1, items, vary, fixed);
+				std::fill(&m_num[k * kBatch + 1], &m_num[(k + 1) * kBatch], m_num[k * kBatch]);
+				std::fill(&m_str[k * kBatch + 1], &m_str[(k + 1) * kBatch], m_str[k * kBatch]);
+				std::fill(&m_undecided[k * kBatch + 1], &m_undecided[(k + 1) * kBatch], m_undecided[k * kBatch]);
+			}
+		}
+
+		size_t root = (m_nodes.size() - 1) * kBatch;
+		for (size_t i = 0; i < batch; i++) {
+			value[from + i]   = m_num[root + i];
+			decided[from + i] = !m_undecided[root + i];
+		}
+	}
+}
+
+void FilterExpr::Order(const double *keys, size_t count, bool descending, size_t first, std::vector<uint32_t> &order) {
+	order.resize(count);
+	std::iota(order.begin(), order.end(), 0);
+
+	auto less = [keys, descending](uint32_t i, uint32_t j) {
+		if (keys[i] != keys[j]) return descending ? keys[i] > keys[j] : keys[i] < keys[j];
+		return i < j;
+	};
+
+	if (first < count) {
+		std::partial_sort(order.begin(), order.begin() + first, order.end(), less);
+		order.resize(first);
+		return;
+	}
+
+	size_t workers = ParallelDraw::Workers(count);
+	if (workers == 1) {
+		std::sort(order.begin(), order.end(), less);
+		return;
+	}
+
+	std::vector<size_t> bounds(workers + 1, count);
+	ParallelDraw::For(count, workers, [&](size_t w, size_t from, size_t to) {
+		bounds[w] = from;
+		std::sort(order.begin() + from, order.begin() + to, less);
+	});
+	for (size_t step = 1; step < workers; step *= 2) {
+		for (size_t w = 0; w + step < workers; w += 2 * step) {
+			std::inplace_merge(order.begin() + bounds[w], order.begin() + bounds[w + step], order.begin() + bounds[std::min(w + 2 * step, workers)], less);
+		}
+	}
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * The Tcl expressions scripts hand to -filter, worked out without the
+ * interpreter.
+ *
+ * Most filters are a property or two compared to a number ($isgnd,
+ * $pins > 100, !$highlighted && $marked) or [distance $r $_] < 200;
+ * installing variables and running expr for each of 100k pins is what
+ * makes them slow.  Expressions made only of what's below are compiled
+ * into a list of nodes, children first, and each node is then worked out
+ * for a whole batch of elements at a time:
+ *
+ * - integer and decimal numbers, "strings" and {strings} without
+ *   substitutions,
+ * - $property, $prefix_property (the reference element's), and the
+ *   objects themselves as arguments to [distance ?-norm? $x $y] and
+ *   [angle ?-ortho? $x $y],
+ * - unary - + !, * / %, + -, < <= > >=, == !=, eq ne, && ||, parentheses,
+ * - abs() sqrt() double() int() round() min() max().
+ *
+ * Anything else fails Compile() and the caller keeps evaluating with Tcl.
+ * Tcl's rules are followed: integers stay integers (/ rounds down), ==
+ * and friends compare strings as numbers when both read as one.  Where
+ * the answer for one element can't be told the Tcl way (dividing by
+ * zero, a name that may be a number in a form Tcl reads differently) that
+ * element is left undecided for the caller to hand to Tcl.
+ *
+ * -sort expressions compare two elements, $a and $b; when they're of the
+ * form K($a) < K($b) (or >) the key K is kept alone (CompileKey()), to be
+ * worked out once per element rather than once per comparison.
+ */
+class FilterExpr {
+  public:
+	enum Type { kInt, kDouble, kString };
+
+	// A built-in property of one type of element; bools are kInt
+	struct Property {
+		const char *name;
+		Type type;
+		double (*number)(const void *element);
+		const std::string &(*string)(const void *element);
+	};
+
+	// What the expression can know about one type of element
+	struct Schema {
+		std::vector<Property> properties;
+		// The distance and angle commands between two of them, null when they don't take this type
+		float (*distance)(const void *a, const void *b) = nullptr;
+		float (*angle)(const void *a, const void *b, bool ortho) = nullptr;
+	};
+
+	// An element the expression can refer to: itself as $name, its properties as $prefix<property>
+	struct Object {
+		const char *name;
+		const char *prefix;
+	};
+
+	/*
+	 * objects are the slots Run() fills, null names and prefixes aren't
+	 * there; unprefixed property names belong to slot plain (-1 for none).
+	 * The result has to be a number.  Returns false when expr isn't of the
+	 * subset handled.
+	 */
+	bool Compile(const std::string &expr, const Schema &schema, const std::vector<Object> &objects, int plain);
+	/*
+	 * Compiles a comparison of slots a and b down to the numeric key of
+	 * slot a; descending is set when the greater key comes first.  Fails
+	 * for anything else, a comparison of strings included.
+	 */
+	bool CompileKey(const std::string &expr, const Schema &schema, const std::vector<Object> &objects, int a, int b, bool &descending);
+	void Clear();
+
+	bool Compiled() const {
+		return !m_nodes.empty();
+	}
+	// Whether slot is used at all, and so must be given to Run()
+	bool Uses(int slot) const;
+
+	/*
+	 * Works the expression out count times, slot vary being each of items
+	 * in turn and the other slots fixed[slot].  decided[i] is 0 where Tcl
+	 * has to be asked instead.
+	 */
+	void Run(const void *const *items, size_t count, int vary, const void *const *fixed, double *value, uint8_t *decided);
+
+	/*
+	 * Indices of keys in key order, equal keys in index order; only the
+	 * first `first` of them (partial_sort), or all of them sorted in
+	 * parallel chunks merged back together.
+	 */
+	static void Order(const double *keys, size_t count, bool descending, size_t first, std::vector<uint32_t> &order);
+
+  private:
+	enum Op {
+		kLiteral,
+		kProperty,
+		kDistance,
+		kAngle,
+		kNeg,
+		kNot,
+		kAbs,
+		kSqrt,
+		kToDouble,
+		kToInt,
+		kRound,
+		kMin,
+		kMax,
+		kMul,
+		kDiv,
+		kMod,
+		kAdd,
+		kSub,
+		kLt,
+		kLe,
+		kGt,
+		kGe,
+		kEq,
+		kNe,
+		kStrEq,
+		kStrNe,
+		kAnd,
+		kOr,
+	};
+
+	// How a string reads to Tcl as an operand of ==, < and so on
+	enum Reading { kReadsNumber, kReadsString, kReadsUnsure };
+
+	struct Node {
+		Op op;
+		Type type;
+		int a = -1, b = -1;        // operand nodes
+		int slot = -1, slot2 = -1; // the objects of a property, distance or angle
+		int property = -1;         // into m_schema.properties
+		bool ortho = false;
+		double number = 0;         // literal, or what a string literal reads as
+		Reading reading = kReadsString;
+		std::string text;          // literals as written
+	};
+
+	class Parser;
+	friend class Parser;
+
+	static Reading Read(const std::string &s, double &number);
+	bool Depends(int node, int slot) const;
+	// Whether node y is node x with slots a and b swapped
+	bool Mirrors(int x, int y, int a, int b) const;
+	// Drops all nodes but root and what it's made of
+	void Keep(int root);
+	void Evaluate(const Node &n, int k, size_t from, size_t count, const void *const *items, int vary, const void *const *fixed);
+
+	std::vector<Node> m_nodes; // children before parents, the last is the result
+	Schema m_schema;
+
+	// one batch worth of values per node
+	static constexpr size_t kBatch = 256;
+	std::vector<double> m_num;
+	std::vector<const std::string *> m_str;
+	std::vector<uint8_t> m_undecided;
+	std::vector<uint8_t> m_varying;
+};
@@ -0,0 +1,211 @@
+#include "platform.h"
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/select.h>
+#include <unistd.h>
+#endif
+
+void LatencyHistogram::Add(std::chrono::steady_clock::duration latency) {
+	int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+	if (us < 0) us = 0;
+
+	// the first four buckets are a microsecond each, after that four per power of two
+	int bucket = int(us);
+	if (us >= 4) {
+		int e = 2;
+		while ((us >> (e + 1)) != 0) e++;
+		bucket = (e - 1) * 4 + int((us >> (e - 2)) & 3);
+	}
+	if (bucket >= kBuckets) bucket = kBuckets - 1;
+
+	m_buckets[bucket]++;
+	m_count++;
+}
+
+float LatencyHistogram::Percentile(float p) const {
+	if (!m_count) return 0.0f;
+
+	uint64_t want = uint64_t(p * m_count);
+	if (want >= m_count) want = m_count - 1;
+
+	uint64_t seen = 0;
+	int bucket    = 0;
+	for (; bucket < kBuckets - 1; bucket++) {
+		seen += m_buckets[bucket];
+		if (seen > want) break;
+	}
+
+	uint64_t upper = bucket + 1;
+	if (bucket >= 4) {
+		int e = bucket / 4 + 1;
+		upper = uint64_t(5 + bucket % 4) << (e - 2);
+	}
+	return upper / 1000.0f;
+}
+
+FrameScheduler::FrameScheduler() {
+	m_wakeup_event = SDL_RegisterEvents(1);
+	m_next_frame   = clock::now();
+}
+
+FrameScheduler::~FrameScheduler() {
+#ifndef _WIN32
+	if (m_watcher.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_watch_mutex);
+			m_watch_quit = true;
+		}
+		m_watch_cv.notify_one();
+		write(m_quit_pipe[1], "\0", 1);
+		m_watcher.join();
+	}
+	for (int fd : m_quit_pipe) {
+		if (fd >= 0) close(fd);
+	}
+#endif
+}
+
+void FrameScheduler::Watch(const std::vector<int> &fds) {
+#ifndef _WIN32
+	if (m_watcher.joinable() || m_wakeup_event == (Uint32)-1) return;
+	if (pipe(m_quit_pipe)) return;
+
+	m_watch_fds = fds;
+	m_watcher   = std::thread(&FrameScheduler::WatchLoop, this);
+#endif
+}
+
+void FrameScheduler::Unwatch(int fd) {
+	std::lock_guard<std::mutex> lock(m_watch_mutex);
+	m_watch_fds.erase(std::remove(m_watch_fds.begin(), m_watch_fds.end(), fd), m_watch_fds.end());
+}
+
+void FrameScheduler::WatchLoop() {
+#ifndef _WIN32
+	std::vector<int> fds;
+	for (;;) {
+		{
+			// the main loop hasn't read what woke it up last time yet, select() would only return straight away
+			std::unique_lock<std::mutex> lock(m_watch_mutex);
+			m_watch_cv.wait(lock, [this] { return m_watch_serviced || m_watch_quit; });
+			if (m_watch_quit) return;
+			fds = m_watch_fds;
+		}
+
+		fd_set fd_r;
+		FD_ZERO(&fd_r);
+		int maxfd = m_quit_pipe[0];
+		FD_SET(m_quit_pipe[0], &fd_r);
+		for (int fd : fds) {
+			if (fd < 0) continue;
+			FD_SET(fd, &fd_r);
+			maxfd = std::max(maxfd, fd);
+		}
+
+		int r = ::select(maxfd + 1, &fd_r, nullptr, nullptr, nullptr);
+		if (r < 0 && errno == EINTR) continue;
+		if (r < 0 || FD_ISSET(m_quit_pipe[0], &fd_r)) return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_watch_mutex);
+			m_watch_serviced = false;
+		}
+
+		SDL_Event event;
+		SDL_zero(event);
+		event.type      = m_wakeup_event;
+		event.user.code = kWakeupWatcher;
+		SDL_PushEvent(&event);
+	}
+#endif
+}
+
+void FrameScheduler::Serviced() {
+	{
+		std::lock_guard<std::mutex> lock(m_watch_mutex);
+		if (m_watch_serviced) return;
+		m_watch_serviced = true;
+	}
+	m_watch_cv.notify_one();
+}
+
+void FrameScheduler::Wake() {
+	if (m_wakeup_event == (Uint32)-1) return;
+
+	SDL_Event event;
+	SDL_zero(event);
+	event.type      = m_wakeup_event;
+	event.user.code = kWakeupApplication;
+	SDL_PushEvent(&event);
+}
+
+bool FrameScheduler::IsWakeup(const SDL_Event &event) {
+	if (event.type != m_wakeup_event) return false;
+	if (event.user.code == kWakeupApplication) Damage();
+	return true;
+}
+
+void FrameScheduler::Wait() {
+	if (Due()) return;
+
+	if (!m_continue && !m_settle) {
+		SDL_WaitEvent(nullptr);
+		return;
+	}
+
+	auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(m_next_frame - clock::now()).count();
+	SDL_WaitEventTimeout(nullptr, int(std::max<int64_t>(wait, 1)));
+}
+
+void FrameScheduler::Event(const SDL_Event &event) {
+	LatencyKind kind;
+
+	Damage();
+
+	switch (event.type) {
+		case SDL_MOUSEMOTION: kind = kLatencyMotion; break;
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_TEXTINPUT: kind = kLatencyInput; break;
+		default: return;
+	}
+	if (m_input_pending[kind]) return;
+
+	// the event may have sat in the queue while the previous frame was drawn, SDL stamps it in ms
+	Uint32 now    = SDL_GetTicks();
+	Uint32 queued = now >= event.common.timestamp ? now - event.common.timestamp : 0;
+
+	m_input_pending[kind] = true;
+	m_input_time[kind]    = clock::now() - std::chrono::milliseconds(queued);
+}
+
+bool FrameScheduler::Due() const {
+	if (m_damaged) return true;
+	return (m_continue || m_settle) && clock::now() >= m_next_frame;
+}
+
+void FrameScheduler::Presented() {
+	clock::time_point now = clock::now();
+
+	for (int k = 0; k < kLatencyKinds; k++) {
+		if (!m_input_pending[k]) continue;
+		m_latency[k].Add(now - m_input_time[k]);
+		m_input_pending[k] = false;
+	}
+
+	if (m_damaged) {
+		m_settle = kSettleFrames;
+	} else if (m_settle) {
+		m_settle--;
+	}
+	m_damaged  = false;
+	m_continue = false;
+
+	m_next_frame = now + std::chrono::microseconds(1000000 / kFrameRate);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <SDL.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Input-to-present latencies, in buckets a quarter of an octave wide
+ * (so any percentile read back is within ~20% of the real value).
+ */
+class LatencyHistogram {
+  public:
+	static const int kBuckets = 4 * 32;
+
+	void Add(std::chrono::steady_clock::duration latency);
+	// Upper bound of the bucket holding the p-th (0..1) fraction of the samples, in ms
+	float Percentile(float p) const;
+	uint64_t Count() const {
+		return m_count;
+	}
+
+  private:
+	uint64_t m_buckets[kBuckets] = {};
+	uint64_t m_count             = 0;
+};
+
+/*
+ * Decides when the main loop draws a frame.
+ *
+ * The loop blocks in one place, the SDL event queue.  Anything else that
+ * should wake it ends up there as well: a watcher thread select()s on the
+ * Tcl console and the BoardView::wakeup() pipe (which worker threads write
+ * to when they finish) and posts an SDL event when one of them is ready.
+ *
+ * A frame is drawn when something damaged the picture (input, a wakeup,
+ * a window event), right away for input.  After that a few more frames
+ * follow for ImGui to settle, and the application can ask for more
+ * (something still animating or pending a re-record); those follow at
+ * most kFrameRate a second.  With nothing to do the loop sleeps until the
+ * next event.
+ */
+class FrameScheduler {
+  public:
+	enum LatencyKind { kLatencyInput, kLatencyMotion, kLatencyKinds };
+
+	static const int kFrameRate    = 60;
+	static const int kSettleFrames = 3;
+
+	FrameScheduler();
+	~FrameScheduler();
+
+	// Starts watching fds for reads, the main loop gets woken up whenever one of them is ready
+	void Watch(const std::vector<int> &fds);
+	// Stops watching fd, one that reached its end and would only ever read as ready
+	void Unwatch(int fd);
+
+	// Blocks until there's an event to handle or the next follow-up frame is due
+	void Wait();
+
+	/*
+	 * Whether event is a wakeup, and not for anything else to handle.
+	 * Those from Wake() damage the picture, the watcher's don't: it's up
+	 * to whatever reads the fds to say whether there was anything to do.
+	 */
+	bool IsWakeup(const SDL_Event &event);
+	// The watched fds have been dealt with, the watcher can go back to waiting on them
+	void Serviced();
+	// Wakes the main loop up for a frame, from any thread
+	void Wake();
+
+	// Records an event; input ones get their latency measured from when they were queued
+	void Event(const SDL_Event &event);
+	// Something changed the picture
+	void Damage() {
+		m_damaged = true;
+	}
+	// The application wants another frame after this one
+	void Continue() {
+		m_continue = true;
+	}
+
+	// Whether to draw a frame now
+	bool Due() const;
+	// Call once the frame has been handed to the display
+	void Presented();
+
+	const LatencyHistogram &Latency(LatencyKind kind) const {
+		return m_latency[kind];
+	}
+
+  private:
+	typedef std::chrono::steady_clock clock;
+
+	void WatchLoop();
+
+	enum WakeupCode { kWakeupWatcher, kWakeupApplication };
+
+	bool m_damaged   = true;
+	bool m_continue  = false;
+	int m_settle     = 0;
+	clock::time_point m_next_frame;
+	bool m_input_pending[kLatencyKinds] = {};
+	clock::time_point m_input_time[kLatencyKinds]; // oldest input not presented yet
+	LatencyHistogram m_latency[kLatencyKinds];
+
+	Uint32 m_wakeup_event = (Uint32)-1;
+	std::thread m_watcher;
+	std::mutex m_watch_mutex;
+	std::condition_variable m_watch_cv;
+	std::vector<int> m_watch_fds;
+	bool m_watch_serviced = true;
+	bool m_watch_quit     = false;
+	int m_quit_pipe[2]    = {-1, -1};
+};
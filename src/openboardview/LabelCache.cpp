@@ -0,0 +1,107 @@
+#include "LabelCache.h"
+
+#include <cmath>
+
+LabelCache::~LabelCache() {
+	if (m_scratch) IM_DELETE(m_scratch);
+}
+
+void LabelCache::Clear() {
+	m_labels.clear();
+	m_font      = nullptr;
+	m_font_size = 0.0f;
+}
+
+const Label &LabelCache::Get(const std::string &text) {
+	ImFont *font    = ImGui::GetFont();
+	float font_size = ImGui::GetFontSize();
+
+	// quads are only good for the font (and atlas) they were shaped with
+	if (font != m_font || font_size != m_font_size) {
+		m_labels.clear();
+		m_font      = font;
+		m_font_size = font_size;
+	}
+
+	auto it = m_labels.find(text);
+	if (it != m_labels.end()) return it->second;
+
+	if (!m_scratch) m_scratch = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+	m_scratch->_ResetForNewFrame();
+	m_scratch->PushClipRectFullScreen();
+	m_scratch->PushTextureID(ImGui::GetIO().Fonts->TexID);
+	m_scratch->AddText(font, font_size, ImVec2(0.0f, 0.0f), 0xffffffff, text.c_str());
+
+	Label &label = m_labels[text];
+	label.size   = ImGui::CalcTextSize(text.c_str());
+	label.vtx.assign(m_scratch->VtxBuffer.Data, m_scratch->VtxBuffer.Data + m_scratch->VtxBuffer.Size);
+	return label;
+}
+
+void LabelCache::Emit(ImDrawList *draw, const Label &label, ImVec2 pos, uint32_t color) {
+	int quads = label.vtx.size() / 4;
+	if (!quads) return;
+
+	// AddText() snaps to whole pixels too
+	pos.x = floorf(pos.x);
+	pos.y = floorf(pos.y);
+
+	draw->PrimReserve(quads * 6, quads * 4);
+
+	ImDrawVert *vtx = draw->_VtxWritePtr;
+	ImDrawIdx *idx  = draw->_IdxWritePtr;
+	ImDrawIdx base  = draw->_VtxCurrentIdx;
+
+	for (auto &v : label.vtx) {
+		vtx->pos.x = v.pos.x + pos.x;
+		vtx->pos.y = v.pos.y + pos.y;
+		vtx->uv    = v.uv;
+		vtx->col   = color;
+		vtx++;
+	}
+	for (int q = 0; q < quads; q++, base += 4) {
+		idx[0] = base;
+		idx[1] = base + 1;
+		idx[2] = base + 2;
+		idx[3] = base;
+		idx[4] = base + 2;
+		idx[5] = base + 3;
+		idx += 6;
+	}
+
+	draw->_VtxWritePtr   = vtx;
+	draw->_IdxWritePtr   = idx;
+	draw->_VtxCurrentIdx = base;
+}
+
+void LabelPlacer::Reset(float cell) {
+	m_cell = cell > 1.0f ? cell : 1.0f;
+	m_boxes.clear();
+	m_grid.clear();
+}
+
+bool LabelPlacer::Place(ImVec2 min, ImVec2 max) {
+	int x0 = int(floorf(min.x / m_cell)), x1 = int(floorf(max.x / m_cell));
+	int y0 = int(floorf(min.y / m_cell)), y1 = int(floorf(max.y / m_cell));
+
+	auto key = [](int x, int y) { return (int64_t(y) << 32) | uint32_t(x); };
+
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			auto it = m_grid.find(key(x, y));
+			if (it == m_grid.end()) continue;
+
+			for (int i : it->second) {
+				const ImVec4 &b = m_boxes[i];
+				if (min.x < b.z && max.x > b.x && min.y < b.w && max.y > b.y) return false;
+			}
+		}
+	}
+
+	int n = m_boxes.size();
+	m_boxes.push_back(ImVec4(min.x, min.y, max.x, max.y));
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) m_grid[key(x, y)].push_back(n);
+	}
+	return true;
+}
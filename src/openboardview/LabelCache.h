@@ -0,0 +1,66 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Measured and pre-shaped text labels.
+ *
+ * Pin and part names never change once a board is loaded, yet drawing one
+ * meant CalcTextSize() plus AddText() walking the font glyph by glyph on
+ * every redraw.  A label is laid out once per font (and size) by letting
+ * ImGui render it at the origin of a scratch draw list and keeping the
+ * resulting quads; drawing it is then a copy of those quads with an offset
+ * and a colour.
+ */
+struct Label {
+	ImVec2 size;
+	std::vector<ImDrawVert> vtx; // 4 per glyph quad, relative to the top left corner
+};
+
+class LabelCache {
+	std::unordered_map<std::string, Label> m_labels;
+	ImDrawList *m_scratch = nullptr;
+	ImFont *m_font        = nullptr;
+	float m_font_size     = 0.0f;
+
+  public:
+	~LabelCache();
+
+	// Label for text in the current font, laid out on first use; stays valid until Clear()
+	const Label &Get(const std::string &text);
+	void Clear();
+
+	// Appends the label's quads to the current channel of draw, top left corner at pos
+	static void Emit(ImDrawList *draw, const Label &label, ImVec2 pos, uint32_t color);
+};
+
+/*
+ * Greedy label placement: a label only goes in if its box doesn't overlap
+ * any label placed before it, so the order of Place() calls sets who wins.
+ * Boxes are bucketed in a coarse screen grid, a test only looks at the
+ * buckets it covers.
+ */
+class LabelPlacer {
+	float m_cell = 32.0f;
+	std::vector<ImVec4> m_boxes; // min.x, min.y, max.x, max.y
+	std::unordered_map<int64_t, std::vector<int>> m_grid;
+
+  public:
+	// Forgets all the placed boxes; cell should be around the size of a label
+	void Reset(float cell);
+
+	// Places the box if it's clear of the others, returns whether it was
+	bool Place(ImVec2 min, ImVec2 max);
+};
+
+// A label waiting for placement
+struct LabelRequest {
+	ImVec2 pos;
+	const Label *label;
+	uint32_t color;
+	int priority;
+};
@@ -1,54 +1,23 @@
 #include "NetList.h"
 
-#include "imgui/imgui.h"
-
-NetList::NetList(TcharStringCallback cbNetSelected) {
-	cbNetSelected_ = cbNetSelected;
-}
+NetList::NetList(TcharStringCallback cbNetSelected) : ElementList(cbNetSelected) {}
 
 NetList::~NetList() {}
 
-void NetList::Draw(const char *title, bool *p_open, Board *board) {
-	if (title && p_open) { }
-
-	// TODO: export / fix dimensions & behaviour
-	int width  = 400;
-	int height = 640;
-
-	ImGui::SetNextWindowSize(ImVec2(width, height));
-	ImGui::Begin("Net List");
-
-	ImGui::Columns(1, "part_infos");
-	ImGui::Separator();
+const std::string &NetList::Name(uint32_t i) const {
+	return (*nets_)[i]->name;
+}
 
-	ImGui::Text("Name");
-	ImGui::NextColumn();
-	ImGui::Separator();
+uint32_t NetList::Pins(uint32_t i) const {
+	return (*nets_)[i]->pins.size();
+}
 
-	if (board) {
-		auto nets = board->Nets();
+void NetList::Draw(const char *title, bool *p_open, Board *board, const NameIndex &index) {
+	if (title && p_open) { }
 
-		static int selected = -1;
-		string net_name     = "";
-		ImGuiListClipper clipper;
-		clipper.Begin(nets.size());
-		while (clipper.Step()) {
-			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
-				net_name = nets.at(i)->name;
-				if (ImGui::Selectable(
-					net_name.c_str(), selected == i, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
-					selected = i;
-					if (ImGui::IsMouseDoubleClicked(0)) {
-						cbNetSelected_(net_name.c_str());
-					}
-				}
-				ImGui::NextColumn();
-			}
-		}
-		clipper.End();
-	}
-	ImGui::Columns(1);
-	ImGui::Separator();
+	nets_ = board ? &board->Nets() : nullptr;
+	size_t count      = nets_ ? nets_->size() : 0;
+	const void *first = count ? (*nets_)[0].get() : nullptr;
 
-	ImGui::End();
+	DrawList("Net List", board, count, first, kColumnPins, index);
 }
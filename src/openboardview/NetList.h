@@ -1,17 +1,21 @@
 #pragma once
 
 #include "Board.h"
+#include "ElementList.h"
 
 #include <vector>
 
-class NetList {
+class NetList : public ElementList {
 
   public:
 	NetList(TcharStringCallback cbNetSelected);
 	~NetList();
 
-	void Draw(const char *title, bool *p_open, Board *board);
+	void Draw(const char *title, bool *p_open, Board *board, const NameIndex &index);
 
   private:
-	TcharStringCallback cbNetSelected_;
+	const std::string &Name(uint32_t i) const override;
+	uint32_t Pins(uint32_t i) const override;
+
+	SharedVector<Net> *nets_ = nullptr;
 };
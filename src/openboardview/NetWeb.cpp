@@ -0,0 +1,249 @@
+#include "NetWeb.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_set>
+
+/*
+ * The tree is built with Borůvka's algorithm: every round each group of
+ * pins already joined up gets linked to the closest pin outside it, which
+ * at least halves the number of groups.  The closest outside pin is found
+ * through a k-d tree of the pins whose nodes know when everything under
+ * them is in one group, so a pin deep inside its own group skips its
+ * neighbourhood in a few steps rather than looking at it pin by pin.
+ * About O(n log² n) over the rounds, whatever the size of the net.
+ *
+ * Equal distances are told apart by the pin indices, so each round's
+ * links can't form a loop and the result is a true minimum spanning tree.
+ */
+namespace {
+class SpanningTree {
+	struct Link {
+		float d = FLT_MAX;
+		uint32_t a = 0, b = 0; // a < b
+
+		bool operator<(const Link &o) const {
+			return d != o.d ? d < o.d : a != o.a ? a < o.a : b < o.b;
+		}
+	};
+
+	struct Node {
+		Point min, max;
+		uint32_t begin, end; // into m_order
+		int left = -1, right = -1;
+		int32_t group;       // of everything under it, -1 when mixed
+	};
+
+	static const uint32_t kLeafPins = 8;
+
+	const SharedVector<Pin> &m_pins;
+	std::vector<uint32_t> m_order;
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_parent; // union-find
+	std::vector<int32_t> m_group;   // of each pin this round
+	std::vector<Link> m_best;       // per group
+
+	const Point &At(uint32_t i) const {
+		return m_pins[i]->position;
+	}
+
+	uint32_t Find(uint32_t i) {
+		while (m_parent[i] != i) i = m_parent[i] = m_parent[m_parent[i]];
+		return i;
+	}
+
+	int Build(uint32_t begin, uint32_t end) {
+		int k = m_nodes.size();
+		m_nodes.emplace_back();
+		Node n;
+		n.begin = begin;
+		n.end   = end;
+		n.min = n.max = At(m_order[begin]);
+		for (uint32_t i = begin + 1; i < end; i++) {
+			const Point &p = At(m_order[i]);
+			n.min.x = std::min(n.min.x, p.x);
+			n.min.y = std::min(n.min.y, p.y);
+			n.max.x = std::max(n.max.x, p.x);
+			n.max.y = std::max(n.max.y, p.y);
+		}
+
+		if (end - begin > kLeafPins) {
+			// split the wider side at the median
+			bool by_x    = n.max.x - n.min.x >= n.max.y - n.min.y;
+			uint32_t mid = begin + (end - begin) / 2;
+			std::nth_element(m_order.begin() + begin, m_order.begin() + mid, m_order.begin() + end, [&](uint32_t a, uint32_t b) {
+				return by_x ? At(a).x < At(b).x : At(a).y < At(b).y;
+			});
+			n.left  = Build(begin, mid);
+			n.right = Build(mid, end);
+		}
+		m_nodes[k] = n;
+		return k;
+	}
+
+	// Children come after their parent, so going backwards sees them first
+	void Label() {
+		for (size_t k = m_nodes.size(); k-- > 0;) {
+			Node &n = m_nodes[k];
+			if (n.left >= 0) {
+				int32_t l = m_nodes[n.left].group;
+				n.group   = l == m_nodes[n.right].group ? l : -1;
+				continue;
+			}
+			n.group = m_group[m_order[n.begin]];
+			for (uint32_t i = n.begin + 1; i < n.end && n.group >= 0; i++) {
+				if (m_group[m_order[i]] != n.group) n.group = -1;
+			}
+		}
+	}
+
+	static float BoxDist2(const Node &n, const Point &p) {
+		float dx = std::max(std::max(n.min.x - p.x, p.x - n.max.x), 0.0f);
+		float dy = std::max(std::max(n.min.y - p.y, p.y - n.max.y), 0.0f);
+		return dx * dx + dy * dy;
+	}
+
+	// Closest pin to pin i outside its group, kept in best if closer than what's there
+	void Closest(int k, uint32_t i, Link &best) {
+		const Node &n = m_nodes[k];
+		int32_t g     = m_group[i];
+		if (n.group == g || BoxDist2(n, At(i)) > best.d) return;
+
+		if (n.left < 0) {
+			for (uint32_t o = n.begin; o < n.end; o++) {
+				uint32_t j = m_order[o];
+				if (m_group[j] == g) continue;
+				float dx = At(i).x - At(j).x, dy = At(i).y - At(j).y;
+				Link l;
+				l.d = dx * dx + dy * dy;
+				l.a = std::min(i, j);
+				l.b = std::max(i, j);
+				if (l < best) best = l;
+			}
+			return;
+		}
+
+		// nearer child first, it's likely to shrink best for the other
+		int first = n.left, second = n.right;
+		if (BoxDist2(m_nodes[second], At(i)) < BoxDist2(m_nodes[first], At(i))) std::swap(first, second);
+		Closest(first, i, best);
+		Closest(second, i, best);
+	}
+
+  public:
+	explicit SpanningTree(const SharedVector<Pin> &pins) : m_pins(pins) {}
+
+	void Run(std::vector<NetWeb::Edge> &tree) {
+		uint32_t n = m_pins.size();
+		m_order.resize(n);
+		m_parent.resize(n);
+		m_group.resize(n);
+		for (uint32_t i = 0; i < n; i++) m_order[i] = m_parent[i] = i;
+		m_nodes.reserve(2 * (n / kLeafPins + 1));
+		Build(0, n);
+
+		while (tree.size() + 1 < n) {
+			for (uint32_t i = 0; i < n; i++) m_group[i] = Find(i);
+			Label();
+
+			m_best.assign(n, Link());
+			for (uint32_t i = 0; i < n; i++) Closest(0, i, m_best[m_group[i]]);
+
+			for (uint32_t g = 0; g < n; g++) {
+				if (m_group[g] != int32_t(g)) continue;
+				const Link &l = m_best[g];
+				uint32_t a = Find(l.a), b = Find(l.b);
+				if (a == b) continue; // the other group picked the same link
+				m_parent[a] = b;
+				tree.push_back({l.a, l.b});
+			}
+		}
+	}
+};
+} // namespace
+
+const std::vector<NetWeb::Edge> &NetWeb::Tree(Net &net) {
+	auto it = m_trees.find(&net);
+	if (it != m_trees.end()) return it->second;
+
+	std::vector<Edge> &tree = m_trees[&net];
+	if (net.pins.size() < 2) return tree;
+
+	tree.reserve(net.pins.size() - 1);
+	SpanningTree(net.pins).Run(tree);
+	return tree;
+}
+
+void NetWeb::Clear() {
+	m_trees.clear();
+}
+
+namespace {
+struct CellPair {
+	int32_t ax, ay, bx, by;
+	uint32_t color;
+
+	bool operator==(const CellPair &o) const {
+		return ax == o.ax && ay == o.ay && bx == o.bx && by == o.by && color == o.color;
+	}
+};
+
+struct CellPairHash {
+	size_t operator()(const CellPair &k) const {
+		uint64_t h = uint32_t(k.ax);
+		h          = h * 0x9E3779B97F4A7C15ull ^ uint32_t(k.ay);
+		h          = h * 0x9E3779B97F4A7C15ull ^ uint32_t(k.bx);
+		h          = h * 0x9E3779B97F4A7C15ull ^ uint32_t(k.by);
+		h          = h * 0x9E3779B97F4A7C15ull ^ k.color;
+		return h ^ (h >> 29);
+	}
+};
+} // namespace
+
+static int32_t Snap(float v, float cell) {
+	float c = floorf(v / cell);
+	return int32_t(std::min(std::max(c, -1e9f), 1e9f));
+}
+
+void MergeWebLines(std::vector<WebLine> &lines, float cell, size_t max_lines) {
+	std::unordered_set<CellPair, CellPairHash> seen;
+	std::vector<WebLine> kept;
+
+	if (cell < 1.0f) cell = 1.0f;
+
+	for (;;) {
+		seen.clear();
+		kept.clear();
+
+		for (auto &l : lines) {
+			CellPair k = {Snap(l.a.x, cell), Snap(l.a.y, cell), Snap(l.b.x, cell), Snap(l.b.y, cell), l.color};
+			if (k.ax == k.bx && k.ay == k.by) continue;
+
+			// same line either way round
+			if (k.ax > k.bx || (k.ax == k.bx && k.ay > k.by)) {
+				std::swap(k.ax, k.bx);
+				std::swap(k.ay, k.by);
+			}
+			if (seen.insert(k).second) kept.push_back(l);
+		}
+
+		if (kept.size() <= max_lines || cell > 1e6f) break;
+		cell *= 2.0f;
+	}
+
+	lines.swap(kept);
+}
+
+void MergeWebMarks(std::vector<WebMark> &marks, float cell) {
+	std::unordered_set<CellPair, CellPairHash> seen;
+	size_t n = 0;
+
+	if (cell < 1.0f) cell = 1.0f;
+
+	for (auto &m : marks) {
+		CellPair k = {Snap(m.pos.x, cell), Snap(m.pos.y, cell), 0, 0, 0};
+		if (seen.insert(k).second) marks[n++] = m;
+	}
+	marks.resize(n);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Board.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Ratsnest of a net: the pins of the net joined by a spanning tree of
+ * short connections rather than every one of them to the selected pin.
+ * Worked out the first time a net is shown and kept until the board
+ * changes.
+ */
+class NetWeb {
+  public:
+	// indices into Net::pins
+	struct Edge {
+		uint32_t a, b;
+	};
+
+	// Minimum spanning tree of the net's pins
+	const std::vector<Edge> &Tree(Net &net);
+	void Clear();
+
+  private:
+	std::unordered_map<const Net *, std::vector<Edge>> m_trees;
+};
+
+/*
+ * Screen space thinning of the web's lines.  Lines whose ends fall into
+ * the same pair of cells would be drawn on top of each other, so only the
+ * first one is kept, and lines within a single cell are dropped.  If that
+ * still leaves more than max_lines the cells are made coarser until it
+ * doesn't.
+ */
+struct WebLine {
+	ImVec2 a, b;
+	uint32_t color;
+};
+
+// circle around a pin of the net on the side not shown
+struct WebMark {
+	ImVec2 pos;
+	float r;
+};
+
+void MergeWebLines(std::vector<WebLine> &lines, float cell, size_t max_lines);
+void MergeWebMarks(std::vector<WebMark> &marks, float cell);
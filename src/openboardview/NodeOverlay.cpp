@@ -0,0 +1,37 @@
+#include "NodeOverlay.h"
+
+#include <cmath>
+
+void NodeOverlay::Add(const Node &node) {
+	NodeLine line = {node.p1, node.p2, node.stub};
+
+	if (node.stub) {
+		ImVec2 v  = ImVec2(node.p1.x - node.p2.x, node.p1.y - node.p2.y);
+		float deg = v.y == 0 ? 0.0f : atanf(v.x / v.y);
+		line.p2   = ImVec2(cosf(deg), sinf(deg));
+	}
+
+	std::lock_guard<std::mutex> lock(m_writers);
+
+	auto next = std::make_shared<NodeSnapshot>();
+	if (auto current = std::atomic_load(&m_current)) *next = *current;
+
+	auto &chunks = next->sides[node.top ? 0 : 1];
+	if (chunks.empty() || chunks.back()->lines.size() >= kChunkSize) {
+		auto chunk = std::make_shared<NodeChunk>();
+		chunk->lines.reserve(kChunkSize);
+		chunk->lines.push_back(line);
+		chunks.push_back(chunk);
+	} else {
+		auto chunk = std::make_shared<NodeChunk>(*chunks.back());
+		chunk->lines.push_back(line);
+		chunks.back() = chunk;
+	}
+
+	std::atomic_store(&m_current, std::shared_ptr<const NodeSnapshot>(next));
+}
+
+void NodeOverlay::Clear() {
+	std::lock_guard<std::mutex> lock(m_writers);
+	std::atomic_store(&m_current, std::shared_ptr<const NodeSnapshot>());
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Board.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+ * The node lines Tcl scripts add to the board (see add_node), handed over
+ * to the renderer as immutable snapshots.
+ *
+ * Scripts add nodes from their own threads while the board is being
+ * drawn.  Rather than both sides sharing a locked list, every Add() builds
+ * the next snapshot next to the current one and swaps it in atomically;
+ * the renderer just picks up whatever snapshot is current and never waits
+ * for a script.  Nodes are kept in fixed size chunks that snapshots share,
+ * so an Add() copies one partly filled chunk and the chunk pointers, not
+ * all the nodes.
+ *
+ * Stub directions are worked out when a node is added, drawing one is a
+ * multiply-add.
+ */
+struct NodeLine {
+	ImVec2 p1;
+	ImVec2 p2; // for stubs, the unit direction from p1
+	bool stub;
+};
+
+struct NodeChunk {
+	std::vector<NodeLine> lines;
+};
+
+struct NodeSnapshot {
+	// nodes to show with the top [0] or the bottom [1] side up
+	std::vector<std::shared_ptr<const NodeChunk>> sides[2];
+};
+
+class NodeOverlay {
+	std::shared_ptr<const NodeSnapshot> m_current;
+	std::mutex m_writers; // only ever taken by Add() and Clear()
+
+  public:
+	static const size_t kChunkSize = 1024;
+
+	void Add(const Node &node);
+	void Clear();
+
+	// Current nodes, may be null; stays valid for as long as it's held
+	std::shared_ptr<const NodeSnapshot> Snapshot() const {
+		return std::atomic_load(&m_current);
+	}
+};
@@ -0,0 +1,158 @@
+#include "ParallelDraw.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/*
+ * The threads For() hands its chunks to, started on first use and parked
+ * on a condition variable in between.  Whoever posts a job works on it as
+ * well (chunk 0 first), so jobs posted from several threads at once or
+ * from inside a chunk never wait on each other.
+ */
+class WorkerPool {
+  public:
+	struct Job {
+		const std::function<void(size_t, size_t, size_t)> *fn;
+		size_t count, chunk, chunks;
+		size_t next = 1; // chunks handed out, 0 is the poster's
+		size_t done = 0;
+	};
+
+	static WorkerPool &Get() {
+		static WorkerPool pool;
+		return pool;
+	}
+
+	void Run(Job &job) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobs.push_back(&job);
+		m_work.notify_all();
+
+		lock.unlock();
+		Chunk(job, 0);
+		lock.lock();
+		job.done++;
+
+		while (job.next < job.chunks) {
+			size_t c = Take(job);
+			lock.unlock();
+			Chunk(job, c);
+			lock.lock();
+			job.done++;
+		}
+		m_done.wait(lock, [&job] { return job.done == job.chunks; });
+	}
+
+  private:
+	WorkerPool() {
+		size_t threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+		for (size_t t = 0; t < threads; t++) m_threads.emplace_back(&WorkerPool::Loop, this);
+	}
+
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_work.notify_all();
+		for (auto &t : m_threads) t.join();
+	}
+
+	static void Chunk(Job &job, size_t c) {
+		size_t from = std::min(c * job.chunk, job.count);
+		size_t to   = std::min(from + job.chunk, job.count);
+		(*job.fn)(c, from, to);
+	}
+
+	// The next chunk of job, which is dropped from the queue with its last one; m_mutex held
+	size_t Take(Job &job) {
+		size_t c = job.next++;
+		if (job.next == job.chunks) m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+		return c;
+	}
+
+	void Loop() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			m_work.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+			if (m_quit) return;
+
+			Job &job = *m_jobs.front();
+			size_t c = Take(job);
+			lock.unlock();
+			Chunk(job, c);
+			lock.lock();
+			// the poster may return as soon as this is counted, job isn't touched after
+			if (++job.done == job.chunks) m_done.notify_all();
+		}
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_work, m_done;
+	std::deque<Job *> m_jobs; // with chunks left to hand out
+	std::vector<std::thread> m_threads;
+	bool m_quit = false;
+};
+
+size_t ParallelDraw::Workers(size_t count) {
+	size_t workers = std::max(1u, std::thread::hardware_concurrency());
+	return std::max<size_t>(1, std::min(workers, count / kMinChunk));
+}
+
+void ParallelDraw::For(size_t count, size_t workers, const std::function<void(size_t, size_t, size_t)> &fn) {
+	if (workers <= 1) {
+		fn(0, 0, count);
+		return;
+	}
+
+	WorkerPool::Job job;
+	job.fn     = &fn;
+	job.count  = count;
+	job.chunk  = (count + workers - 1) / workers;
+	job.chunks = workers;
+	WorkerPool::Get().Run(job);
+}
+
+void ParallelDraw::Run(ImDrawList *draw, size_t count, const std::function<void(ImDrawList *, size_t, size_t)> &fn) {
+	size_t workers = Workers(count);
+
+	if (workers == 1) {
+		fn(draw, 0, count);
+		return;
+	}
+
+	// worker 0 draws into the target itself
+	while (m_workers.size() < workers - 1) m_workers.emplace_back(new Worker);
+	for (size_t w = 0; w < workers - 1; w++) {
+		Worker &worker = *m_workers[w];
+		worker.shared  = *ImGui::GetDrawListSharedData();
+		worker.list._ResetForNewFrame();
+		worker.list.PushClipRectFullScreen();
+		worker.list.PushTextureID(ImGui::GetIO().Fonts->TexID);
+	}
+
+	For(count, workers, [&](size_t w, size_t from, size_t to) { fn(w ? &m_workers[w - 1]->list : draw, from, to); });
+
+	for (size_t w = 0; w < workers - 1; w++) Append(draw, &m_workers[w]->list);
+}
+
+void ParallelDraw::Append(ImDrawList *draw, const ImDrawList *src) {
+	int vtx_count = src->VtxBuffer.Size;
+	int idx_count = src->IdxBuffer.Size;
+
+	if (!idx_count) return;
+
+	draw->PrimReserve(idx_count, vtx_count);
+
+	ImDrawIdx base = draw->_VtxCurrentIdx;
+	memcpy(draw->_VtxWritePtr, src->VtxBuffer.Data, vtx_count * sizeof(ImDrawVert));
+	for (int i = 0; i < idx_count; i++) draw->_IdxWritePtr[i] = src->IdxBuffer.Data[i] + base;
+
+	draw->_VtxWritePtr += vtx_count;
+	draw->_IdxWritePtr += idx_count;
+	draw->_VtxCurrentIdx += vtx_count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+ * Board geometry built on several threads.
+ *
+ * A run of elements is cut into contiguous chunks, one per worker.  The
+ * first chunk is drawn straight into the target draw list on the calling
+ * thread, the others each into a draw list of their own (with their own
+ * copy of ImGui's shared draw data, whose scratch buffers aren't safe to
+ * share), which then get appended to the target's current channel in
+ * chunk order.  ImGui's primitives only depend on their arguments, so the
+ * result is vertex for vertex what drawing everything in one go gives.
+ *
+ * The draw callbacks must stay in the current channel and may only read
+ * the board and view state.
+ */
+class ParallelDraw {
+  public:
+	// fewer elements than this per worker aren't worth handing to another thread
+	static const size_t kMinChunk = 4096;
+
+	// How many workers count elements get spread over, 1 meaning just the calling thread
+	static size_t Workers(size_t count);
+
+	// Calls fn(worker, begin, end) for each chunk of [0, count) on a pool of threads kept around, the first one on the calling thread
+	static void For(size_t count, size_t workers, const std::function<void(size_t, size_t, size_t)> &fn);
+
+	// Draws [0, count) with fn(list, begin, end) into the current channel of draw
+	void Run(ImDrawList *draw, size_t count, const std::function<void(ImDrawList *, size_t, size_t)> &fn);
+
+	// Appends all of src's geometry to the current channel of draw
+	static void Append(ImDrawList *draw, const ImDrawList *src);
+
+  private:
+	struct Worker {
+		ImDrawListSharedData shared;
+		ImDrawList list{&shared};
+	};
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
@@ -1,15 +1,20 @@
 #pragma once
 
 #include "Board.h"
+#include "ElementList.h"
 #include "FileFormats/BRDFile.h"
 
-class PartList {
+class PartList : public ElementList {
   public:
 	PartList(TcharStringCallback cbNetSelected);
 	~PartList();
 
-	void Draw(const char *title, bool *p_open, Board *board);
+	void Draw(const char *title, bool *p_open, Board *board, const NameIndex &index);
 
   private:
-	TcharStringCallback cbNetSelected_;
+	const std::string &Name(uint32_t i) const override;
+	uint32_t Pins(uint32_t i) const override;
+	int Side(uint32_t i) const override;
+
+	SharedVector<Component> *parts_ = nullptr;
 };
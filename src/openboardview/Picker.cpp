@@ -0,0 +1,271 @@
+#include "Picker.h"
+#include "imgui_operators.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// same bound as the PinGrid cells
+static const int kMaxCells = 1 << 20;
+
+// boxes wider or taller than this many cells are tested on every query instead
+static const int kMaxSpan = 16;
+
+void BoxGrid::Clear() {
+	m_boxes.clear();
+	m_cell_start.clear();
+	m_items.clear();
+	m_large.clear();
+	m_cols = 0;
+	m_rows = 0;
+}
+
+void BoxGrid::Build(std::vector<BBox> boxes, int per_cell) {
+	Clear();
+	m_boxes = std::move(boxes);
+	if (m_boxes.empty()) return;
+
+	ImVec2 min{FLT_MAX, FLT_MAX}, max{-FLT_MAX, -FLT_MAX};
+	for (auto &b : m_boxes) {
+		min.x = std::min(min.x, b.min.x);
+		min.y = std::min(min.y, b.min.y);
+		max.x = std::max(max.x, b.max.x);
+		max.y = std::max(max.y, b.max.y);
+	}
+
+	float w = max.x - min.x;
+	float h = max.y - min.y;
+
+	m_origin = min;
+	m_cell   = std::max(sqrtf(w * h * per_cell / m_boxes.size()), 1.0f);
+	while ((w / m_cell + 1) * (h / m_cell + 1) > kMaxCells) m_cell *= 2.0f;
+	m_cols = int(w / m_cell) + 1;
+	m_rows = int(h / m_cell) + 1;
+
+	auto span = [this](const BBox &b, int &c0, int &r0, int &c1, int &r1) {
+		c0 = std::min(int((b.min.x - m_origin.x) / m_cell), m_cols - 1);
+		r0 = std::min(int((b.min.y - m_origin.y) / m_cell), m_rows - 1);
+		c1 = std::min(int((b.max.x - m_origin.x) / m_cell), m_cols - 1);
+		r1 = std::min(int((b.max.y - m_origin.y) / m_cell), m_rows - 1);
+	};
+
+	// counting sort, boxes going in in index order keeps every cell ascending
+	m_cell_start.assign(m_cols * m_rows + 1, 0);
+	for (uint32_t i = 0; i < m_boxes.size(); i++) {
+		int c0, r0, c1, r1;
+		span(m_boxes[i], c0, r0, c1, r1);
+		if (c1 - c0 >= kMaxSpan || r1 - r0 >= kMaxSpan) {
+			m_large.push_back(i);
+			continue;
+		}
+		for (int r = r0; r <= r1; r++) {
+			for (int c = c0; c <= c1; c++) m_cell_start[r * m_cols + c + 1]++;
+		}
+	}
+	for (size_t c = 1; c < m_cell_start.size(); c++) m_cell_start[c] += m_cell_start[c - 1];
+
+	std::vector<uint32_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+	m_items.resize(m_cell_start.back());
+	size_t large = 0;
+	for (uint32_t i = 0; i < m_boxes.size(); i++) {
+		if (large < m_large.size() && m_large[large] == i) {
+			large++;
+			continue;
+		}
+		int c0, r0, c1, r1;
+		span(m_boxes[i], c0, r0, c1, r1);
+		for (int r = r0; r <= r1; r++) {
+			for (int c = c0; c <= c1; c++) m_items[fill[r * m_cols + c]++] = i;
+		}
+	}
+}
+
+void BoxGrid::Query(const BBox &box, std::vector<uint32_t> &out) const {
+	out.clear();
+	if (!m_cols) return;
+
+	auto overlaps = [&box](const BBox &b) {
+		return b.min.x <= box.max.x && b.max.x >= box.min.x && b.min.y <= box.max.y && b.max.y >= box.min.y;
+	};
+
+	// clamped while still a float, the box can be far bigger than the board when zoomed out
+	auto index = [this](float v, float origin, int count) {
+		float i = floorf((v - origin) / m_cell);
+		return int(std::min(std::max(i, -1.0f), float(count)));
+	};
+
+	int c0 = std::max(index(box.min.x, m_origin.x, m_cols), 0);
+	int r0 = std::max(index(box.min.y, m_origin.y, m_rows), 0);
+	int c1 = std::min(index(box.max.x, m_origin.x, m_cols), m_cols - 1);
+	int r1 = std::min(index(box.max.y, m_origin.y, m_rows), m_rows - 1);
+
+	for (int r = r0; r <= r1; r++) {
+		for (int c = c0; c <= c1; c++) {
+			for (uint32_t k = m_cell_start[r * m_cols + c]; k < m_cell_start[r * m_cols + c + 1]; k++) {
+				if (overlaps(m_boxes[m_items[k]])) out.push_back(m_items[k]);
+			}
+		}
+	}
+	for (uint32_t i : m_large) {
+		if (overlaps(m_boxes[i])) out.push_back(i);
+	}
+
+	// a box in several of the cells comes up once per cell
+	if (c0 != c1 || r0 != r1 || !m_large.empty()) {
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+}
+
+void Picker::Clear() {
+	m_pins.Clear();
+	m_parts.Clear();
+	m_annotations.Clear();
+	m_pin_pos.clear();
+	m_pin_diameter.clear();
+	m_pin_side.clear();
+	m_pin_testpad.clear();
+	m_part_side.clear();
+	m_part_outline.clear();
+	m_max_diameter      = 0.0f;
+	m_built             = false;
+	m_annotations_built = false;
+	m_last_pin.valid = m_last_testpad.valid = m_last_parts.valid = false;
+}
+
+void Picker::InvalidateAnnotations() {
+	m_annotations.Clear();
+	m_annotations_built = false;
+}
+
+void Picker::Build(Board &board) {
+	Clear();
+	m_built = true;
+
+	std::vector<BBox> boxes;
+
+	// a pin is hit within its diameter of the centre
+	for (auto &pin : board.Pins()) {
+		float d = pin->diameter;
+		boxes.push_back({pin->position - ImVec2(d, d), pin->position + ImVec2(d, d)});
+		m_pin_pos.push_back(pin->position);
+		m_pin_diameter.push_back(d);
+		m_pin_side.push_back(pin->component ? pin->component->board_side : kBoardSideBoth);
+		m_pin_testpad.push_back(pin->type == Pin::kPinTypeTestPad);
+		m_max_diameter = std::max(m_max_diameter, d);
+	}
+	m_pins.Build(std::move(boxes), 4);
+
+	boxes.clear();
+	for (auto &part : board.Components()) {
+		std::array<ImVec2, 4> q = {part->outline[0], part->outline[1], part->outline[2], part->outline[3]};
+		BBox b                  = {q[0], q[0]};
+		for (auto &p : q) {
+			b.min.x = std::min(b.min.x, p.x);
+			b.min.y = std::min(b.min.y, p.y);
+			b.max.x = std::max(b.max.x, p.x);
+			b.max.y = std::max(b.max.y, p.y);
+		}
+		boxes.push_back(b);
+		m_part_side.push_back(part->board_side);
+		m_part_outline.push_back(q);
+	}
+	m_parts.Build(std::move(boxes), 2);
+}
+
+static bool SideVisible(int element_side, int side) {
+	return side < 0 || element_side == side || element_side == kBoardSideBoth;
+}
+
+int Picker::PinAt(int side, ImVec2 pos, float max_dist) {
+	if (m_last_pin.valid && m_last_pin.pos == pos && m_last_pin.side == side && m_last_pin.max_dist == max_dist) return m_pin;
+
+	m_last_pin = {true, pos, side, max_dist};
+	m_pin      = -1;
+
+	m_pins.Query({pos, pos}, m_candidates);
+
+	float min_dist = max_dist * max_dist; // all distance squared
+	for (uint32_t i : m_candidates) {
+		if (!SideVisible(m_pin_side[i], side)) continue;
+
+		float dx   = m_pin_pos[i].x - pos.x;
+		float dy   = m_pin_pos[i].y - pos.y;
+		float dist = dx * dx + dy * dy;
+		if ((dist < (m_pin_diameter[i] * m_pin_diameter[i])) && (dist < min_dist)) {
+			m_pin    = i;
+			min_dist = dist;
+		}
+	}
+	return m_pin;
+}
+
+int Picker::TestPadAt(ImVec2 pos) {
+	if (m_last_testpad.valid && m_last_testpad.pos == pos) return m_testpad;
+
+	m_last_testpad = {true, pos, -1, 0.0f};
+	m_testpad      = -1;
+
+	m_pins.Query({pos, pos}, m_candidates);
+	for (uint32_t i : m_candidates) {
+		if (!m_pin_testpad[i]) continue;
+
+		float dx = m_pin_pos[i].x - pos.x;
+		float dy = m_pin_pos[i].y - pos.y;
+		if (dx * dx + dy * dy < m_pin_diameter[i] * m_pin_diameter[i]) {
+			m_testpad = i;
+			break;
+		}
+	}
+	return m_testpad;
+}
+
+const std::vector<uint32_t> &Picker::PartsAt(int side, ImVec2 pos) {
+	if (m_last_parts.valid && m_last_parts.pos == pos && m_last_parts.side == side) return m_hit_parts;
+
+	m_last_parts = {true, pos, side, 0.0f};
+	m_hit_parts.clear();
+
+	m_parts.Query({pos, pos}, m_candidates);
+	for (uint32_t k : m_candidates) {
+		if (!SideVisible(m_part_side[k], side)) continue;
+
+		// crossing number, odd being inside
+		const std::array<ImVec2, 4> &poly = m_part_outline[k];
+		int hit                           = 0;
+		for (int i = 0, j = 3; i < 4; j = i++) {
+			if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
+			    (pos.x < (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
+				hit ^= 1;
+		}
+		if (hit) m_hit_parts.push_back(k);
+	}
+	return m_hit_parts;
+}
+
+void Picker::PinsNear(ImVec2 pos, float radius, std::vector<uint32_t> &out) {
+	m_pins.Query({pos - ImVec2(radius, radius), pos + ImVec2(radius, radius)}, out);
+}
+
+void Picker::PinsIn(int side, const BBox &box, std::vector<uint32_t> &out) {
+	m_pins.Query(box, out);
+	out.erase(std::remove_if(out.begin(), out.end(), [&](uint32_t i) { return !SideVisible(m_pin_side[i], side); }), out.end());
+}
+
+void Picker::PartsIn(int side, const BBox &box, std::vector<uint32_t> &out) {
+	m_parts.Query(box, out);
+	out.erase(std::remove_if(out.begin(), out.end(), [&](uint32_t k) { return !SideVisible(m_part_side[k], side); }), out.end());
+}
+
+void Picker::AnnotationsIn(const Annotations &annotations, const BBox &box, std::vector<uint32_t> &out) {
+	if (!m_annotations_built) {
+		std::vector<BBox> boxes;
+		for (auto &ann : annotations.annotations) {
+			ImVec2 a(ann.x, ann.y);
+			boxes.push_back({a, a});
+		}
+		m_annotations.Build(std::move(boxes), 4);
+		m_annotations_built = true;
+	}
+	m_annotations.Query(box, out);
+}
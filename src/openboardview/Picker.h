@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Board.h"
+#include "annotations.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Boxes bucketed in a uniform grid, for finding the ones under a point
+ * without walking them all.  A box goes in every cell it overlaps, those
+ * spanning too many cells (a connector the length of the board) are kept
+ * aside and always tested.
+ */
+class BoxGrid {
+	std::vector<BBox> m_boxes;
+	std::vector<uint32_t> m_cell_start; // into m_items, per cell, plus the end
+	std::vector<uint32_t> m_items;      // box indices grouped by cell, ascending within a cell
+	std::vector<uint32_t> m_large;
+	ImVec2 m_origin;
+	float m_cell = 1.0f;
+	int m_cols   = 0;
+	int m_rows   = 0;
+
+  public:
+	// boxes per cell the grid is sized for
+	void Build(std::vector<BBox> boxes, int per_cell);
+	void Clear();
+
+	// Indices of the boxes overlapping box (edges included), ascending
+	void Query(const BBox &box, std::vector<uint32_t> &out) const;
+};
+
+/*
+ * Hit-testing of the board for clicks, hovers and tooltips.
+ *
+ * Pins, part outlines and annotations each get a BoxGrid, so finding what's
+ * under the mouse only looks at the few elements near it.  The pin and part
+ * answers only depend on the board position and the side looked at, the
+ * last one of each is kept and handed back again as long as those stay the
+ * same, which is every frame the mouse and view don't move.
+ *
+ * side is the side seen (kBoardSideTop or kBoardSideBottom), elements on
+ * the other side are skipped; -1 takes both.
+ */
+class Picker {
+	BoxGrid m_pins;
+	BoxGrid m_parts;
+	BoxGrid m_annotations;
+	bool m_built             = false;
+	bool m_annotations_built = false;
+
+	// what the pins and parts are, for the tests after the grid
+	std::vector<ImVec2> m_pin_pos;
+	std::vector<float> m_pin_diameter;
+	std::vector<int8_t> m_pin_side;
+	std::vector<uint8_t> m_pin_testpad;
+	std::vector<int8_t> m_part_side;
+	std::vector<std::array<ImVec2, 4>> m_part_outline;
+	float m_max_diameter = 0.0f;
+
+	struct Last {
+		bool valid = false;
+		ImVec2 pos;
+		int side;
+		float max_dist;
+	};
+	Last m_last_pin, m_last_testpad, m_last_parts;
+	int m_pin     = -1;
+	int m_testpad = -1;
+	std::vector<uint32_t> m_hit_parts;
+	std::vector<uint32_t> m_candidates;
+
+  public:
+	void Build(Board &board);
+	void Clear();
+	// The annotations got reloaded, they're indexed again on the next query
+	void InvalidateAnnotations();
+
+	bool Built() const {
+		return m_built;
+	}
+	float MaxDiameter() const {
+		return m_max_diameter;
+	}
+
+	// Pin nearest to pos, within its diameter and max_dist of it; first in board order on a tie, -1 for none
+	int PinAt(int side, ImVec2 pos, float max_dist);
+
+	// First test pad in board order within its diameter of pos, either side, -1 for none
+	int TestPadAt(ImVec2 pos);
+
+	// Parts whose outline holds pos, in board (= drawing) order, so the topmost one is last
+	const std::vector<uint32_t> &PartsAt(int side, ImVec2 pos);
+
+	// Pins whose hit box (their diameter around the centre) comes within radius of pos, board order; not cached
+	void PinsNear(ImVec2 pos, float radius, std::vector<uint32_t> &out);
+
+	// Pins seen from side whose hit box overlaps box, and parts whose outline's bounding box does; board order, not cached
+	void PinsIn(int side, const BBox &box, std::vector<uint32_t> &out);
+	void PartsIn(int side, const BBox &box, std::vector<uint32_t> &out);
+
+	size_t PinCount() const {
+		return m_pin_pos.size();
+	}
+	size_t PartCount() const {
+		return m_part_outline.size();
+	}
+	ImVec2 PinPosition(uint32_t i) const {
+		return m_pin_pos[i];
+	}
+	const std::array<ImVec2, 4> &PartOutline(uint32_t k) const {
+		return m_part_outline[k];
+	}
+
+	// Annotations anchored inside box (board coordinates), in list order; not cached
+	void AnnotationsIn(const Annotations &annotations, const BBox &box, std::vector<uint32_t> &out);
+};
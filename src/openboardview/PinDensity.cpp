@@ -0,0 +1,83 @@
+#include "platform.h"
+#include "PinDensity.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/*
+ * Upper bound on the tile count of the finest level, so boards
+ * with a handful of huge pads and a few tiny vias don't end up
+ * allocating a grid bigger than the pin list itself.
+ */
+static const int kMaxTiles = 1 << 20;
+
+void PinDensity::Clear() {
+	m_levels.clear();
+	m_typical_diameter = 0.0f;
+	m_built            = false;
+}
+
+void PinDensity::Build(SharedVector<Pin> &pins) {
+	Clear();
+	m_built = true;
+
+	if (pins.empty()) return;
+
+	ImVec2 min{FLT_MAX, FLT_MAX}, max{-FLT_MAX, -FLT_MAX};
+	std::vector<float> diameters;
+	diameters.reserve(pins.size());
+
+	for (auto &pin : pins) {
+		min.x = std::min(min.x, pin->position.x);
+		min.y = std::min(min.y, pin->position.y);
+		max.x = std::max(max.x, pin->position.x);
+		max.y = std::max(max.y, pin->position.y);
+		diameters.push_back(pin->diameter);
+	}
+
+	std::nth_element(diameters.begin(), diameters.begin() + diameters.size() / 2, diameters.end());
+	m_typical_diameter = diameters[diameters.size() / 2];
+	m_origin           = min;
+
+	float w    = max.x - min.x;
+	float h    = max.y - min.y;
+	float tile = std::max(m_typical_diameter * 4.0f, 1.0f);
+	while ((w / tile + 1) * (h / tile + 1) > kMaxTiles) tile *= 2.0f;
+
+	m_levels.resize(kLevels);
+	for (auto &level : m_levels) {
+		level.tile = tile;
+		level.cols = int(w / tile) + 1;
+		level.rows = int(h / tile) + 1;
+		for (auto &c : level.coverage) c.assign(level.cols * level.rows, 0.0f);
+
+		for (auto &pin : pins) {
+			int col = int((pin->position.x - min.x) / tile);
+			int row = int((pin->position.y - min.y) / tile);
+			int idx = row * level.cols + col;
+
+			// pins are drawn with their diameter as the circle radius
+			float area = float(M_PI) * pin->diameter * pin->diameter;
+
+			if (pin->board_side != kBoardSideBottom) level.coverage[kBoardSideTop][idx] += area;
+			if (pin->board_side != kBoardSideTop) level.coverage[kBoardSideBottom][idx] += area;
+		}
+
+		float inv_area = 1.0f / (tile * tile);
+		for (auto &c : level.coverage) {
+			for (auto &v : c) v = std::min(v * inv_area, 1.0f);
+		}
+
+		tile *= 2.0f;
+	}
+}
+
+const PinDensityLevel *PinDensity::LevelFor(float scale, float min_px) const {
+	if (m_levels.empty()) return nullptr;
+
+	for (auto &level : m_levels) {
+		if (level.tile * scale >= min_px) return &level;
+	}
+	return &m_levels.back();
+}
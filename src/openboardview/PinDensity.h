@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Board.h"
+#include <vector>
+
+/*
+ * Zoomed out level-of-detail representation of the pins.
+ *
+ * The board is cut into square tiles at a few zoom levels, each level
+ * doubling the tile edge of the previous one.  Every tile accumulates the
+ * pad area of the pins falling into it, separately for the top and bottom
+ * side, so once the pins shrink to a pixel or two we can paint one quad
+ * per tile with an alpha matching the pad coverage instead of emitting a
+ * circle for every single pin.
+ *
+ * Coverage is an area ratio, so it reads the same at every level; moving
+ * from one level to the next only changes the resolution of the picture.
+ */
+struct PinDensityLevel {
+	float tile = 0.0f; // tile edge, in board units
+	int cols   = 0;
+	int rows   = 0;
+
+	// fraction (0..1) of each tile covered by pads, [side][row * cols + col]
+	std::vector<float> coverage[2];
+
+	float at(int side, int col, int row) const {
+		return coverage[side][row * cols + col];
+	}
+};
+
+class PinDensity {
+	std::vector<PinDensityLevel> m_levels;
+	ImVec2 m_origin;
+	float m_typical_diameter = 0.0f;
+	bool m_built             = false;
+
+  public:
+	static const int kLevels = 4;
+
+	void Build(SharedVector<Pin> &pins);
+	void Clear();
+
+	bool Built() const {
+		return m_built;
+	}
+	ImVec2 Origin() const {
+		return m_origin;
+	}
+
+	// median pin diameter, used to decide board-wide how small the pins are on screen
+	float TypicalDiameter() const {
+		return m_typical_diameter;
+	}
+
+	// Finest level whose tiles are at least min_px wide at the given scale
+	const PinDensityLevel *LevelFor(float scale, float min_px) const;
+};
@@ -0,0 +1,162 @@
+#include "platform.h"
+#include "PinGlyphs.h"
+#include "ParallelDraw.h"
+#include "imgui_operators.h"
+
+#include <cmath>
+
+static const uint32_t kOpaque      = 0xffffffff;
+static const uint32_t kTransparent = 0x00ffffff;
+
+/*
+ * Closed outline of n points, point i at dir[i] * r + off[i] with vertex
+ * normal nrm[i] (already lengthened for the corner, as ImGui does), either
+ * filled or stroked one pixel wide.  Same vertex and index layout as
+ * ImGui's own AddConvexPolyFilled() and thin AddPolyline(), so the pins
+ * look the way they always did.
+ */
+static void Fill(PinGlyph &g, int n, const ImVec2 *dir, const ImVec2 *off, const ImVec2 *nrm, bool aa) {
+	g.vtx.clear();
+	g.idx.clear();
+
+	if (!aa) {
+		for (int i = 0; i < n; i++) g.vtx.push_back({dir[i], off[i], kOpaque});
+		for (int i = 2; i < n; i++) g.idx.insert(g.idx.end(), {0, ImDrawIdx(i - 1), ImDrawIdx(i)});
+		return;
+	}
+
+	// inner (opaque) and outer (transparent) vertex per point, half a pixel either side of the edge
+	for (int i = 0; i < n; i++) {
+		g.vtx.push_back({dir[i], off[i] - nrm[i] * 0.5f, kOpaque});
+		g.vtx.push_back({dir[i], off[i] + nrm[i] * 0.5f, kTransparent});
+	}
+	for (int i = 2; i < n; i++) g.idx.insert(g.idx.end(), {0, ImDrawIdx((i - 1) * 2), ImDrawIdx(i * 2)});
+	for (int i = 0, j = n - 1; i < n; j = i++) {
+		ImDrawIdx ii = i * 2, jj = j * 2;
+		g.idx.insert(g.idx.end(), {ii, jj, ImDrawIdx(jj + 1), ImDrawIdx(jj + 1), ImDrawIdx(ii + 1), ii});
+	}
+}
+
+static void Stroke(PinGlyph &g, int n, const ImVec2 *dir, const ImVec2 *off, const ImVec2 *nrm, bool aa) {
+	g.vtx.clear();
+	g.idx.clear();
+
+	if (!aa) {
+		// one pixel wide band
+		for (int i = 0; i < n; i++) {
+			g.vtx.push_back({dir[i], off[i] - nrm[i] * 0.5f, kOpaque});
+			g.vtx.push_back({dir[i], off[i] + nrm[i] * 0.5f, kOpaque});
+		}
+		for (int i = 0, j = n - 1; i < n; j = i++) {
+			ImDrawIdx ii = i * 2, jj = j * 2;
+			g.idx.insert(g.idx.end(), {jj, ImDrawIdx(jj + 1), ImDrawIdx(ii + 1), jj, ImDrawIdx(ii + 1), ii});
+		}
+		return;
+	}
+
+	// opaque centre line with a transparent fringe a pixel out on each side
+	for (int i = 0; i < n; i++) {
+		g.vtx.push_back({dir[i], off[i], kOpaque});
+		g.vtx.push_back({dir[i], off[i] + nrm[i], kTransparent});
+		g.vtx.push_back({dir[i], off[i] - nrm[i], kTransparent});
+	}
+	for (int i = 0, j = n - 1; i < n; j = i++) {
+		ImDrawIdx a = j * 3, b = i * 3;
+		g.idx.insert(g.idx.end(),
+		             {b, a, ImDrawIdx(a + 2), ImDrawIdx(a + 2), ImDrawIdx(b + 2), b, ImDrawIdx(b + 1), ImDrawIdx(a + 1), a, a, b, ImDrawIdx(b + 1)});
+	}
+}
+
+void PinGlyphs::Build(bool anti_aliased) {
+	if (m_built && m_anti_aliased == anti_aliased) return;
+
+	ImVec2 dir[kMaxSegments], off[kMaxSegments], nrm[kMaxSegments];
+
+	for (int n = kMinSegments; n <= kMaxSegments; n++) {
+		// averaged edge normals of a regular polygon point outwards, 1/cos(half step) long
+		float stretch = 1.0f / cosf(float(M_PI) / n);
+
+		for (int i = 0; i < n; i++) {
+			float a = 2.0f * float(M_PI) * i / n;
+			dir[i]  = ImVec2(cosf(a), sinf(a));
+			nrm[i]  = ImVec2(dir[i].x * stretch, dir[i].y * stretch);
+			off[i]  = ImVec2(0.0f, 0.0f);
+		}
+		Fill(m_discs[n], n, dir, off, nrm, anti_aliased);
+
+		// AddCircle() strokes half a pixel inside the radius
+		for (int i = 0; i < n; i++) off[i] = ImVec2(dir[i].x * -0.5f, dir[i].y * -0.5f);
+		Stroke(m_rings[n], n, dir, off, nrm, anti_aliased);
+	}
+
+	// corners of AddRectFilled(), not anti-aliased in ImGui either
+	const ImVec2 corners[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+	m_square.vtx.clear();
+	m_square.idx = {0, 1, 2, 0, 2, 3};
+	for (auto &c : corners) m_square.vtx.push_back({c, ImVec2(0.0f, 0.0f), kOpaque});
+
+	// AddRect() strokes half a pixel inside
+	for (int i = 0; i < 4; i++) {
+		dir[i] = corners[i];
+		off[i] = ImVec2(corners[i].x * -0.5f, corners[i].y * -0.5f);
+		nrm[i] = corners[i];
+	}
+	Stroke(m_square_ring, 4, dir, off, nrm, anti_aliased);
+
+	m_built        = true;
+	m_anti_aliased = anti_aliased;
+}
+
+static void Write(const PinStamp *s, const PinStamp *end, ImDrawVert *vtx, ImDrawIdx *idx, ImDrawIdx base, ImVec2 uv) {
+	for (; s != end; s++) {
+		const PinGlyph &g = *s->glyph;
+		int n             = g.vtx.size();
+
+		for (int i = 0; i < n; i++) {
+			const PinGlyph::Vertex &t = g.vtx[i];
+			vtx[i].pos.x              = s->pos.x + t.dir.x * s->r + t.off.x;
+			vtx[i].pos.y              = s->pos.y + t.dir.y * s->r + t.off.y;
+			vtx[i].uv                 = uv;
+			vtx[i].col                = s->color & t.col_mask;
+		}
+		for (ImDrawIdx i : g.idx) *idx++ = base + i;
+
+		vtx += n;
+		base += n;
+	}
+}
+
+void PinGlyphs::Stamp(ImDrawList *draw, const std::vector<PinStamp> &stamps) {
+	size_t workers = ParallelDraw::Workers(stamps.size());
+	size_t chunk   = (stamps.size() + workers - 1) / workers;
+
+	// where each worker's share of the stamps starts in the reserved buffers
+	std::vector<int> vtx_start(workers + 1, 0), idx_start(workers + 1, 0);
+	for (size_t i = 0; i < stamps.size(); i++) {
+		vtx_start[i / chunk + 1] += stamps[i].glyph->vtx.size();
+		idx_start[i / chunk + 1] += stamps[i].glyph->idx.size();
+	}
+	for (size_t w = 0; w < workers; w++) {
+		vtx_start[w + 1] += vtx_start[w];
+		idx_start[w + 1] += idx_start[w];
+	}
+
+	int vtx_count = vtx_start[workers], idx_count = idx_start[workers];
+	if (!idx_count) return;
+
+	draw->PrimReserve(idx_count, vtx_count);
+
+	ImDrawVert *vtx   = draw->_VtxWritePtr;
+	ImDrawIdx *idx    = draw->_IdxWritePtr;
+	ImDrawIdx base    = draw->_VtxCurrentIdx;
+	ImVec2 uv         = ImGui::GetFontTexUvWhitePixel();
+	const PinStamp *s = stamps.data();
+
+	ParallelDraw::For(stamps.size(), workers, [&](size_t w, size_t from, size_t to) {
+		Write(s + from, s + to, vtx + vtx_start[w], idx + idx_start[w], base + vtx_start[w], uv);
+	});
+
+	draw->_VtxWritePtr   = vtx + vtx_count;
+	draw->_IdxWritePtr   = idx + idx_count;
+	draw->_VtxCurrentIdx = base + vtx_count;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Pre-built geometry for the pin shapes.
+ *
+ * AddCircle() and friends rebuild the same path with cos()/sin() for every
+ * single pin, then run it through the generic polyline code to work out
+ * normals and anti-aliasing fringes.  For a pin all of that only depends on
+ * the shape and the segment count, so it's done once here: every template
+ * vertex is a direction, scaled by the pin's radius (half the edge for the
+ * squares), plus a fixed pixel offset for the fringes and insets, which
+ * keeps the fringes one pixel wide whatever the pin size.
+ *
+ * Pins are collected as stamps during DrawPins() and written out at the
+ * end with a single PrimReserve().
+ */
+struct PinGlyph {
+	struct Vertex {
+		ImVec2 dir;         // times the radius
+		ImVec2 off;         // plus this many pixels
+		uint32_t col_mask;  // 0x00ffffff on the transparent side of a fringe
+	};
+	std::vector<Vertex> vtx;
+	std::vector<ImDrawIdx> idx;
+};
+
+struct PinStamp {
+	ImVec2 pos; // screen
+	float r;
+	uint32_t color;
+	const PinGlyph *glyph;
+};
+
+class PinGlyphs {
+  public:
+	static const int kMinSegments = 8;
+	static const int kMaxSegments = 32;
+
+	// Builds the templates matching the anti-aliasing setting, if not already done so
+	void Build(bool anti_aliased);
+
+	const PinGlyph &Disc(int segments) const {
+		return m_discs[Clamp(segments)];
+	}
+	const PinGlyph &Ring(int segments) const {
+		return m_rings[Clamp(segments)];
+	}
+	const PinGlyph &Square() const {
+		return m_square;
+	}
+	const PinGlyph &SquareRing() const {
+		return m_square_ring;
+	}
+
+	// Writes all the stamps, in order, into the current channel of draw; big batches are split over threads
+	static void Stamp(ImDrawList *draw, const std::vector<PinStamp> &stamps);
+
+  private:
+	static int Clamp(int segments) {
+		return segments < kMinSegments ? kMinSegments : segments > kMaxSegments ? kMaxSegments : segments;
+	}
+
+	PinGlyph m_discs[kMaxSegments + 1];
+	PinGlyph m_rings[kMaxSegments + 1];
+	PinGlyph m_square;
+	PinGlyph m_square_ring;
+	bool m_built        = false;
+	bool m_anti_aliased = false;
+};
@@ -0,0 +1,104 @@
+#include "PinGrid.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// same bound as the PinDensity tiles
+static const int kMaxCells = 1 << 20;
+
+// pins per cell the grid is sized for
+static const int kPinsPerCell = 16;
+
+void PinGrid::Clear() {
+	for (auto &s : m_sides) {
+		s.cell_start.clear();
+		s.pins.clear();
+		s.all.clear();
+	}
+	m_cols         = 0;
+	m_rows         = 0;
+	m_max_diameter = 0.0f;
+	m_built        = false;
+}
+
+void PinGrid::Build(SharedVector<Pin> &pins) {
+	Clear();
+	m_built = true;
+
+	if (pins.empty()) return;
+
+	ImVec2 min{FLT_MAX, FLT_MAX}, max{-FLT_MAX, -FLT_MAX};
+	for (auto &pin : pins) {
+		min.x          = std::min(min.x, pin->position.x);
+		min.y          = std::min(min.y, pin->position.y);
+		max.x          = std::max(max.x, pin->position.x);
+		max.y          = std::max(max.y, pin->position.y);
+		m_max_diameter = std::max(m_max_diameter, pin->diameter);
+	}
+
+	float w = max.x - min.x;
+	float h = max.y - min.y;
+
+	m_origin = min;
+	m_cell   = std::max(sqrtf(w * h * kPinsPerCell / pins.size()), 1.0f);
+	while ((w / m_cell + 1) * (h / m_cell + 1) > kMaxCells) m_cell *= 2.0f;
+	m_cols = int(w / m_cell) + 1;
+	m_rows = int(h / m_cell) + 1;
+
+	std::vector<uint32_t> cell(pins.size());
+	for (size_t i = 0; i < pins.size(); i++) {
+		int col = int((pins[i]->position.x - min.x) / m_cell);
+		int row = int((pins[i]->position.y - min.y) / m_cell);
+		cell[i] = row * m_cols + col;
+	}
+
+	// counting sort per side, which keeps board order within each cell
+	for (int side = 0; side < 2; side++) {
+		Side &s = m_sides[side];
+		s.cell_start.assign(m_cols * m_rows + 1, 0);
+
+		for (size_t i = 0; i < pins.size(); i++) {
+			if (pins[i]->board_side == (side == kBoardSideTop ? kBoardSideBottom : kBoardSideTop)) continue;
+			s.all.push_back(i);
+			s.cell_start[cell[i] + 1]++;
+		}
+		for (size_t c = 1; c < s.cell_start.size(); c++) s.cell_start[c] += s.cell_start[c - 1];
+
+		std::vector<uint32_t> fill(s.cell_start.begin(), s.cell_start.end() - 1);
+		s.pins.resize(s.all.size());
+		for (uint32_t i : s.all) s.pins[fill[cell[i]]++] = i;
+	}
+}
+
+void PinGrid::Query(int side, const BBox &box, std::vector<uint32_t> &out) const {
+	out.clear();
+	if (!m_cols || side < 0 || side > 1) return;
+
+	const Side &s = m_sides[side];
+
+	// clamped while still a float, the box can be far bigger than the board when zoomed out
+	auto index = [this](float v, float origin, int count) {
+		float i = floorf((v - origin) / m_cell);
+		return int(std::min(std::max(i, -1.0f), float(count)));
+	};
+
+	int c0 = std::max(index(box.min.x, m_origin.x, m_cols), 0);
+	int r0 = std::max(index(box.min.y, m_origin.y, m_rows), 0);
+	int c1 = std::min(index(box.max.x, m_origin.x, m_cols), m_cols - 1);
+	int r1 = std::min(index(box.max.y, m_origin.y, m_rows), m_rows - 1);
+	if (c0 > c1 || r0 > r1) return;
+
+	// most of the board in view: sorting would cost more than taking every pin
+	if (int64_t(c1 - c0 + 1) * (r1 - r0 + 1) * 4 >= int64_t(m_cols) * m_rows) {
+		out = s.all;
+		return;
+	}
+
+	for (int r = r0; r <= r1; r++) {
+		const uint32_t *from = s.pins.data() + s.cell_start[r * m_cols + c0];
+		const uint32_t *to   = s.pins.data() + s.cell_start[r * m_cols + c1 + 1];
+		out.insert(out.end(), from, to);
+	}
+	std::sort(out.begin(), out.end());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Board.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Pins bucketed by position, once for each side of the board.
+ *
+ * Every view of the board (split view halves, the second side of a dual
+ * view) culls its pins through the same grid instead of walking all the
+ * pins of the board: a view only visits the cells under its own surface,
+ * so two half size views cost about what a single full one does.  The
+ * grid only depends on the board, so it's built once and shared by all
+ * the views.
+ */
+class PinGrid {
+	struct Side {
+		std::vector<uint32_t> cell_start; // into pins, per cell, plus the end
+		std::vector<uint32_t> pins;       // indices into the board's pins, grouped by cell, board order within a cell
+		std::vector<uint32_t> all;        // the same pins in board order
+	};
+
+	Side m_sides[2];
+	ImVec2 m_origin;
+	float m_cell         = 1.0f;
+	int m_cols           = 0;
+	int m_rows           = 0;
+	float m_max_diameter = 0.0f;
+	bool m_built         = false;
+
+  public:
+	void Build(SharedVector<Pin> &pins);
+	void Clear();
+
+	bool Built() const {
+		return m_built;
+	}
+
+	// largest pin diameter, for widening a query by the pin size
+	float MaxDiameter() const {
+		return m_max_diameter;
+	}
+
+	/*
+	 * Indices of the pins seen from side (top or bottom, pins on both
+	 * sides included) in the cells overlapping box, in board order.
+	 */
+	void Query(int side, const BBox &box, std::vector<uint32_t> &out) const;
+};
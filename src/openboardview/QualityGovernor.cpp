@@ -0,0 +1,44 @@
+#include "QualityGovernor.h"
+
+bool QualityGovernor::EndFrame(bool enabled, bool busy) {
+	float frame_ms = m_frame_ms;
+	int level      = m_level;
+	m_frame_ms     = 0.0f;
+
+	// quick to follow a sudden slow down, a spike on its own is forgotten again within a few frames
+	m_average_ms += (frame_ms - m_average_ms) * 0.25f;
+
+	if (!enabled || !busy) {
+		m_level = kFull;
+		m_over = m_under = 0;
+		return m_level != level;
+	}
+
+	if (m_average_ms > m_budget_ms) {
+		m_under = 0;
+		if (++m_over >= kStepDownFrames && m_level < kLevels - 1) {
+			m_level++;
+			m_over = 0;
+		}
+	} else if (m_average_ms < m_budget_ms * 0.5f) {
+		m_over = 0;
+		if (++m_under >= kStepUpFrames && m_level > kFull) {
+			m_level--;
+			m_under = 0;
+		}
+	} else {
+		m_over = m_under = 0;
+	}
+
+	return m_level != level;
+}
+
+const char *QualityGovernor::Describe() const {
+	switch (m_level) {
+		case kFull: return "full";
+		case kFewerSegments: return "-segments";
+		case kNoFill: return "-segments -fill";
+		case kFewerLabels: return "-segments -fill -labels";
+		default: return "-segments -fill -labels +LOD";
+	}
+}
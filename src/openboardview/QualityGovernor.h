@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Adaptive render quality.
+ *
+ * DrawBoard() reports how long it took, once a frame the total is folded
+ * into a running average and compared with the budget.  While the view is
+ * being moved around and the average stays over budget, quality is given
+ * up one step at a time, cheapest loss first:
+ *
+ *   1  fewer circle segments on the round pins
+ *   2  no board or part fills
+ *   3  only the first few labels
+ *   4  pin level-of-detail kicks in earlier (or at all)
+ *
+ * Frames well under budget win the steps back one by one, and once the
+ * view has been left alone for a moment the full quality is restored
+ * straight away, so a still board always ends up drawn properly.
+ */
+class QualityGovernor {
+  public:
+	enum Level { kFull, kFewerSegments, kNoFill, kFewerLabels, kCoarseLOD, kLevels };
+
+	// Times its scope into the current frame
+	class Scope {
+		QualityGovernor &m_governor;
+		std::chrono::steady_clock::time_point m_start;
+
+	  public:
+		explicit Scope(QualityGovernor &governor) : m_governor(governor), m_start(std::chrono::steady_clock::now()) {}
+		~Scope() {
+			m_governor.m_frame_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+		}
+	};
+
+	void SetBudget(float ms) {
+		m_budget_ms = ms > 1.0f ? ms : 1.0f;
+	}
+
+	// Closes the frame; busy is whether the view has been moving lately.  Returns whether the level changed.
+	bool EndFrame(bool enabled, bool busy);
+
+	int Level() const {
+		return m_level;
+	}
+	float AverageMs() const {
+		return m_average_ms;
+	}
+	// Short description of what's been given up, for the status bar
+	const char *Describe() const;
+
+	// Knobs, as they apply at the current level
+	int MaxSegments(int segments) const {
+		return m_level >= kFewerSegments && segments > kReducedSegments ? kReducedSegments : segments;
+	}
+	bool Fills() const {
+		return m_level < kNoFill;
+	}
+	size_t MaxLabels() const {
+		return m_level >= kFewerLabels ? kReducedLabels : SIZE_MAX;
+	}
+	// Pin LOD threshold in pixels to use instead of the configured one (0 meaning off)
+	float LODThreshold(float threshold) const {
+		if (m_level < kCoarseLOD) return threshold;
+		return threshold > 0.0f ? threshold * 2.0f : kFallbackLOD;
+	}
+
+  private:
+	static const int kReducedSegments = 12;
+	static const size_t kReducedLabels = 64;
+	static constexpr float kFallbackLOD = 6.0f;
+
+	// consecutive frames over budget before a step down, well under it before a step up
+	static const int kStepDownFrames = 8;
+	static const int kStepUpFrames   = 60;
+
+	float m_budget_ms  = 8.0f;
+	float m_frame_ms   = 0.0f;
+	float m_average_ms = 0.0f;
+	int m_level        = kFull;
+	int m_over         = 0;
+	int m_under        = 0;
+};
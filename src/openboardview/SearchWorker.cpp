@@ -0,0 +1,108 @@
+#include "SearchWorker.h"
+
+SearchWorker::SearchWorker(const Searcher &searcher, const SpellCorrector &scparts, const SpellCorrector &scnets)
+    : m_searcher(searcher), m_scparts(scparts), m_scnets(scnets) {}
+
+SearchWorker::~SearchWorker() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_cv.notify_all();
+	if (m_thread.joinable()) m_thread.join();
+}
+
+void SearchWorker::SetNotify(std::function<void()> notify) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_notify = notify;
+}
+
+void SearchWorker::Post(int slot, const Query &query) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Slot &s = m_slots[slot];
+	if (query == s.query) return;
+
+	s.query = query;
+	s.generation++;
+
+	// nothing to look for, no need to wait for that
+	if (query.text.empty()) {
+		s.results = Results();
+		s.fresh   = true;
+		s.done    = s.generation;
+		return;
+	}
+
+	if (!m_thread.joinable()) m_thread = std::thread(&SearchWorker::Run, this);
+	m_cv.notify_all();
+}
+
+bool SearchWorker::Collect(int slot, Results &results) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Slot &s = m_slots[slot];
+	if (!s.fresh) return false;
+
+	std::swap(results, s.results);
+	s.results = Results();
+	s.fresh   = false;
+	return true;
+}
+
+bool SearchWorker::Pending(int slot) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_slots[slot].generation != m_slots[slot].done;
+}
+
+void SearchWorker::Reset() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cv.wait(lock, [this] { return !m_busy; });
+	for (auto &s : m_slots) s = Slot();
+}
+
+void SearchWorker::Run() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		Slot *slot = nullptr;
+		m_cv.wait(lock, [&] {
+			if (m_quit) return true;
+			for (auto &s : m_slots) {
+				if (s.generation != s.done) {
+					slot = &s;
+					return true;
+				}
+			}
+			return false;
+		});
+		if (m_quit) return;
+
+		Query query         = slot->query;
+		uint64_t generation = slot->generation;
+		Results results;
+
+		// the narrowing state is only ever touched here and in Reset(), which waits for this
+		m_busy = true;
+		lock.unlock();
+		Search(query, *slot, results);
+		lock.lock();
+		m_busy = false;
+		m_cv.notify_all();
+
+		// typed on in the meantime, this one's already out of date
+		if (slot->generation != generation) continue;
+
+		slot->results = std::move(results);
+		slot->fresh   = true;
+		slot->done    = generation;
+		if (m_notify) m_notify();
+	}
+}
+
+void SearchWorker::Search(const Query &query, Slot &narrowing, Results &results) {
+	if (query.parts) results.parts = m_searcher.parts(query.text, query.mode, query.limit, narrowing.parts);
+	if (query.nets) results.nets = m_searcher.nets(query.text, query.mode, query.limit, narrowing.nets);
+
+	// suggestions only if there is no result at all
+	if (!results.parts.empty() || !results.nets.empty()) return;
+	if (query.parts) results.part_suggestions = m_scparts.suggest(query.text, query.limit);
+	if (query.nets) results.net_suggestions = m_scnets.suggest(query.text, query.limit);
+}
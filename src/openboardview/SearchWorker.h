@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Searcher.h"
+#include "SpellCorrector.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * Search-as-you-type off the main thread.
+ *
+ * Each search box is a slot.  Posting a query that differs from the last
+ * one posted to the slot bumps its generation and wakes the worker, which
+ * always takes the newest query of a slot; a result only gets handed back
+ * if no newer query came in while it was being worked out, so the box
+ * never goes back to an older answer.  Until then the previous results stay
+ * up and the frame isn't held up.
+ *
+ * Every slot keeps the full matches of its last parts and nets search
+ * (SearchNarrowing), typing on just filters those.  "Did you mean" gets
+ * worked out here as well when nothing matched at all.
+ *
+ * The worker reads the Searcher and SpellCorrectors it was given; they
+ * may only be rebuilt between Reset() and the next Post().
+ */
+class SearchWorker {
+  public:
+	static const int kSlots = 3;
+
+	struct Query {
+		std::string text;
+		SearchMode mode = SearchMode::Sub;
+		bool parts      = true;
+		bool nets       = true;
+		int limit       = -1;
+
+		bool operator==(const Query &o) const {
+			return text == o.text && mode == o.mode && parts == o.parts && nets == o.nets && limit == o.limit;
+		}
+	};
+
+	struct Results {
+		SharedVector<Component> parts;
+		SharedVector<Net> nets;
+		std::vector<std::string> part_suggestions;
+		std::vector<std::string> net_suggestions;
+	};
+
+	SearchWorker(const Searcher &searcher, const SpellCorrector &scparts, const SpellCorrector &scnets);
+	~SearchWorker();
+
+	// Called from the worker whenever a slot gets new results, for waking the main loop
+	void SetNotify(std::function<void()> notify);
+
+	// Searches for query in slot unless that's what it already has
+	void Post(int slot, const Query &query);
+	// Swaps in the slot's newest results if there are any since the last call, returns whether there were
+	bool Collect(int slot, Results &results);
+	// Whether the slot's results are still for an older query
+	bool Pending(int slot);
+
+	// Drops every query and result and waits for the worker to be idle, before the board changes
+	void Reset();
+
+  private:
+	struct Slot {
+		Query query;
+		uint64_t generation = 0; // of query
+		uint64_t done       = 0; // generation last worked out or dropped
+		bool fresh          = false;
+		Results results;
+		SearchNarrowing parts, nets;
+	};
+
+	void Run();
+	void Search(const Query &query, Slot &narrowing, Results &results);
+
+	const Searcher &m_searcher;
+	const SpellCorrector &m_scparts;
+	const SpellCorrector &m_scnets;
+	std::function<void()> m_notify;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::thread m_thread;
+	bool m_busy = false;
+	bool m_quit = false;
+	Slot m_slots[kSlots];
+};
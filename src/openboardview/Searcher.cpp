@@ -1,12 +1,194 @@
 #include "platform.h"
 #include "Searcher.h"
 
+#include <algorithm>
+
+static uint32_t GramKey(const char *s, size_t n) {
+	uint32_t key = uint32_t(n) << 24;
+	for (size_t i = 0; i < n; i++) key |= uint32_t((unsigned char)s[i]) << (16 - 8 * i);
+	return key;
+}
+
+std::string NameIndex::Fold(const std::string &s) {
+	std::string folded(s);
+	// same folding as strcasestr() in the C locale
+	for (auto &c : folded) {
+		if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+	}
+	return folded;
+}
+
+void NameIndex::Build(const std::vector<const std::string *> &names) {
+	m_folded.clear();
+	m_sorted.clear();
+	m_grams.clear();
+	m_version++;
+
+	for (auto name : names) m_folded.push_back(Fold(*name));
+
+	m_sorted.resize(m_folded.size());
+	for (uint32_t i = 0; i < m_sorted.size(); i++) m_sorted[i] = i;
+	std::sort(m_sorted.begin(), m_sorted.end(), [this](uint32_t a, uint32_t b) { return m_folded[a] < m_folded[b]; });
+
+	for (uint32_t i = 0; i < m_folded.size(); i++) {
+		const std::string &s = m_folded[i];
+		for (size_t n = 1; n <= 3; n++) {
+			for (size_t p = 0; p + n <= s.size(); p++) {
+				auto &list = m_grams[GramKey(s.data() + p, n)];
+				// names go in in order, a gram seen twice in one name is already last
+				if (list.empty() || list.back() != i) list.push_back(i);
+			}
+		}
+	}
+}
+
+void NameIndex::Candidates(const std::string &needle, std::vector<uint32_t> &out) const {
+	out.clear();
+
+	std::vector<const std::vector<uint32_t> *> lists;
+	size_t n = std::min<size_t>(needle.size(), 3);
+	for (size_t p = 0; p + n <= needle.size(); p++) {
+		auto it = m_grams.find(GramKey(needle.data() + p, n));
+		if (it == m_grams.end()) return;
+		lists.push_back(&it->second);
+	}
+
+	std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b) { return a->size() < b->size(); });
+	lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+	out = *lists[0];
+	std::vector<uint32_t> merged;
+	for (size_t l = 1; l < lists.size() && !out.empty(); l++) {
+		merged.clear();
+		std::set_intersection(out.begin(), out.end(), lists[l]->begin(), lists[l]->end(), std::back_inserter(merged));
+		out.swap(merged);
+	}
+}
+
+void NameIndex::Find(const std::string &needle, SearchMode mode, int limit, std::vector<uint32_t> &out) const {
+	out.clear();
+	if (needle.empty()) return;
+
+	size_t want = limit > 0 ? size_t(limit) : m_folded.size();
+	size_t nl   = needle.size();
+
+	auto starts = [&](uint32_t i) { return m_folded[i].compare(0, nl, needle) == 0; };
+
+	// everything starting with needle is one run of the sorted names, the name itself first
+	auto first = std::lower_bound(m_sorted.begin(), m_sorted.end(), needle, [this](uint32_t i, const std::string &s) { return m_folded[i] < s; });
+	auto last  = first;
+	while (last != m_sorted.end() && m_folded[*last].size() == nl && starts(*last)) last++;
+
+	std::vector<uint32_t> tier(first, last);
+	std::sort(tier.begin(), tier.end());
+	for (uint32_t i : tier) {
+		if (out.size() == want) return;
+		out.push_back(i);
+	}
+	if (mode == SearchMode::Whole) return;
+
+	first = last;
+	last  = std::partition_point(first, m_sorted.end(), starts);
+	tier.assign(first, last);
+	std::sort(tier.begin(), tier.end());
+	for (uint32_t i : tier) {
+		if (out.size() == want) return;
+		out.push_back(i);
+	}
+	if (mode == SearchMode::Prefix) return;
+
+	Candidates(needle, tier);
+	for (uint32_t i : tier) {
+		if (out.size() == want) return;
+		// prefixes are in already; a trigram hit can still miss if the grams are out of order
+		if (starts(i)) continue;
+		if (nl > 3 && m_folded[i].find(needle) == std::string::npos) continue;
+		out.push_back(i);
+	}
+}
+
+bool NameIndex::Matches(uint32_t i, const std::string &needle, SearchMode mode) const {
+	const std::string &s = m_folded[i];
+	switch (mode) {
+		case SearchMode::Sub: return s.find(needle) != std::string::npos;
+		case SearchMode::Prefix: return s.compare(0, needle.size(), needle) == 0;
+		case SearchMode::Whole: return s == needle;
+	}
+	return false;
+}
+
+/*
+ * The same order as Find(): the name itself, names starting with needle,
+ * then the rest.
+ */
+void NameIndex::Rank(const std::string &needle, const std::vector<uint32_t> &matches, size_t want, std::vector<uint32_t> &out) const {
+	out.clear();
+	for (int tier = 0; tier < 3; tier++) {
+		for (uint32_t i : matches) {
+			if (out.size() == want) return;
+			const std::string &s = m_folded[i];
+			bool starts          = s.compare(0, needle.size(), needle) == 0;
+			int t                = starts ? (s.size() == needle.size() ? 0 : 1) : 2;
+			if (t == tier) out.push_back(i);
+		}
+	}
+}
+
+void NameIndex::Find(const std::string &needle, SearchMode mode, int limit, std::vector<uint32_t> &out, SearchNarrowing &narrowing) const {
+	out.clear();
+	if (needle.empty()) {
+		narrowing.valid = false;
+		return;
+	}
+
+	// what matches needle matches anything it extends in that mode
+	bool narrows = narrowing.valid && narrowing.mode == mode;
+	if (narrows) {
+		const std::string &prev = narrowing.needle;
+		switch (mode) {
+			case SearchMode::Sub: narrows = needle.find(prev) != std::string::npos; break;
+			case SearchMode::Prefix: narrows = needle.compare(0, prev.size(), prev) == 0; break;
+			case SearchMode::Whole: narrows = needle == prev; break;
+		}
+	}
+
+	auto &matches = narrowing.matches;
+	if (narrows) {
+		matches.erase(std::remove_if(matches.begin(), matches.end(), [&](uint32_t i) { return !Matches(i, needle, mode); }), matches.end());
+	} else if (mode == SearchMode::Sub) {
+		Candidates(needle, matches);
+		if (needle.size() > 3) {
+			matches.erase(std::remove_if(matches.begin(), matches.end(), [&](uint32_t i) { return !Matches(i, needle, mode); }),
+			              matches.end());
+		}
+	} else {
+		auto first = std::lower_bound(m_sorted.begin(), m_sorted.end(), needle, [this](uint32_t i, const std::string &s) { return m_folded[i] < s; });
+		auto last  = std::partition_point(first, m_sorted.end(), [&](uint32_t i) { return Matches(i, needle, mode); });
+		matches.assign(first, last);
+		std::sort(matches.begin(), matches.end());
+	}
+
+	narrowing.valid  = true;
+	narrowing.needle = needle;
+	narrowing.mode   = mode;
+
+	Rank(needle, matches, limit > 0 ? size_t(limit) : matches.size(), out);
+}
+
 void Searcher::setNets(SharedVector<Net> nets) {
 	this->m_nets = nets;
+
+	std::vector<const std::string *> names;
+	for (auto &net : m_nets) names.push_back(&net->name);
+	m_netIndex.Build(names);
 }
 
 void Searcher::setParts(SharedVector<Component> components) {
 	this->m_parts = components;
+
+	std::vector<const std::string *> names;
+	for (auto &part : m_parts) names.push_back(&part->name);
+	m_partIndex.Build(names);
 }
 
 bool Searcher::isMode(SearchMode sm) {
@@ -17,41 +199,36 @@ void Searcher::setMode(SearchMode sm) {
 	m_searchMode = sm;
 }
 
-bool Searcher::strstrModeSearch(const std::string &strhaystack, const std::string &strneedle) {
-	size_t nl = strneedle.size();
-	size_t hl = strhaystack.size();
-	const char *needle = strneedle.c_str();
-	const char *haystack = strhaystack.c_str();
-	const char *sr;
-
-	sr = strcasestr(haystack, needle);
-	if (sr) {
-		if ((m_searchMode == SearchMode::Sub) || ((m_searchMode == SearchMode::Prefix) && (sr == haystack)) ||
-		    ((m_searchMode == SearchMode::Whole) && (sr == haystack) && (nl == hl))) {
-			return true;
-		}
-	}
+template<class T> std::vector<T> Searcher::searchFor(const std::string& search, const std::vector<T> &v, const NameIndex &index, int limit) {
+	std::vector<T> results;
+	std::vector<uint32_t> found;
 
-	return false;
+	index.Find(NameIndex::Fold(search), m_searchMode, limit, found);
+	results.reserve(found.size());
+	for (uint32_t i : found) results.push_back(v[i]);
+	return results;
 }
 
-template<class T> std::vector<T> Searcher::searchFor(const std::string& search, std::vector<T> v,  int limit) {
+template<class T> std::vector<T> Searcher::searchFor(const std::string& search, SearchMode mode, const std::vector<T> &v, const NameIndex &index, int limit, SearchNarrowing &narrowing) const {
 	std::vector<T> results;
+	std::vector<uint32_t> found;
 
-	if (search.empty()) return results;
-
-	for (auto &p : v) {
-		if (strstrModeSearch(p->name, search)) {
-			results.push_back(p);
-			limit--;
-		}
-		if (limit == 0) return results;
-	}
+	index.Find(NameIndex::Fold(search), mode, limit, found, narrowing);
+	results.reserve(found.size());
+	for (uint32_t i : found) results.push_back(v[i]);
 	return results;
 }
 
+SharedVector<Component> Searcher::parts(const std::string& search, SearchMode mode, int limit, SearchNarrowing &narrowing) const {
+	return searchFor(search, mode, m_parts, m_partIndex, limit, narrowing);
+}
+
+SharedVector<Net> Searcher::nets(const std::string& search, SearchMode mode, int limit, SearchNarrowing &narrowing) const {
+	return searchFor(search, mode, m_nets, m_netIndex, limit, narrowing);
+}
+
 SharedVector<Component> Searcher::parts(const std::string& search, int limit) {
-	return searchFor(search, m_parts, limit);
+	return searchFor(search, m_parts, m_partIndex, limit);
 }
 
 SharedVector<Component> Searcher::parts(const std::string& search) {
@@ -59,7 +236,7 @@ SharedVector<Component> Searcher::parts(const std::string& search) {
 }
 
 SharedVector<Net> Searcher::nets(const std::string& search, int limit) {
-	return searchFor(search, m_nets, limit);
+	return searchFor(search, m_nets, m_netIndex, limit);
 }
 
 SharedVector<Net> Searcher::nets(const std::string& search) {
@@ -1,27 +1,99 @@
+#pragma once
+
 #include "BRDBoard.h"
 
+#include <cstdint>
+#include <unordered_map>
+
 enum class SearchMode {
 	Sub,
 	Prefix,
 	Whole,
 };
 
+/*
+ * Every match of the last needle searched, kept between searches: when the
+ * next needle only extends it (typing on), its matches are among these and
+ * there's no need to go back to the whole index.
+ */
+struct SearchNarrowing {
+	bool valid = false;
+	std::string needle;
+	SearchMode mode;
+	std::vector<uint32_t> matches; // ascending
+};
+
+/*
+ * Case-folded index over a list of names, so a search doesn't have to look
+ * at every one of them.
+ *
+ * Names are kept lowercased once, plus a sorted copy of their order for
+ * prefix and whole-name lookups (binary search), and a posting list for
+ * every 1-, 2- and 3-gram found in them for substrings: a name holding the
+ * needle holds all its trigrams, so only the names on the shortest lists
+ * intersected are verified.  Needles under three characters use their own
+ * gram's list directly.
+ */
+class NameIndex {
+	std::vector<std::string> m_folded;
+	std::vector<uint32_t> m_sorted; // indices ordered by folded name
+	std::unordered_map<uint32_t, std::vector<uint32_t>> m_grams; // ascending indices per gram
+	uint32_t m_version = 0; // bumped by every Build()
+
+	void Candidates(const std::string &needle, std::vector<uint32_t> &out) const;
+	bool Matches(uint32_t i, const std::string &needle, SearchMode mode) const;
+	void Rank(const std::string &needle, const std::vector<uint32_t> &matches, size_t want, std::vector<uint32_t> &out) const;
+
+  public:
+	void Build(const std::vector<const std::string *> &names);
+	// Changes whenever the index gets rebuilt, for holders of earlier results
+	uint32_t Version() const {
+		return m_version;
+	}
+
+	/*
+	 * Indices of the names matching needle (already folded), best first:
+	 * the name itself, then names starting with it, then the rest, board
+	 * order within each; stops after limit (<= 0 for all).
+	 */
+	void Find(const std::string &needle, SearchMode mode, int limit, std::vector<uint32_t> &out) const;
+	// Same, starting from the previous search's matches when needle narrows them down, and leaving its own there
+	void Find(const std::string &needle, SearchMode mode, int limit, std::vector<uint32_t> &out, SearchNarrowing &narrowing) const;
+
+	static std::string Fold(const std::string &s);
+};
+
 class Searcher {
 	SearchMode m_searchMode = SearchMode::Sub;
 
 	SharedVector<Net> m_nets;
 	SharedVector<Component> m_parts;
+	NameIndex m_netIndex;
+	NameIndex m_partIndex;
 
-	template<class T> std::vector<T> searchFor(const std::string& search, std::vector<T> v,  int limit);
-	bool strstrModeSearch(const std::string &strhaystack, const std::string &strneedle);
+	template<class T> std::vector<T> searchFor(const std::string& search, const std::vector<T> &v, const NameIndex &index, int limit);
+	template<class T> std::vector<T> searchFor(const std::string& search, SearchMode mode, const std::vector<T> &v, const NameIndex &index, int limit, SearchNarrowing &narrowing) const;
 public:
 	void setNets(SharedVector<Net> nets);
 	void setParts(SharedVector<Component> components);
 
 	bool isMode(SearchMode sm);
+	SearchMode getMode() const {
+		return m_searchMode;
+	}
+	const NameIndex &partIndex() const {
+		return m_partIndex;
+	}
+	const NameIndex &netIndex() const {
+		return m_netIndex;
+	}
 	void setMode(SearchMode sm);
 	SharedVector<Component> parts(const std::string& search, int limit);
 	SharedVector<Component> parts(const std::string& search);
 	SharedVector<Net> nets(const std::string& search, int limit);
 	SharedVector<Net> nets(const std::string& search);
+
+	// For searching off the main thread: the mode is passed in, nothing gets changed but narrowing
+	SharedVector<Component> parts(const std::string& search, SearchMode mode, int limit, SearchNarrowing &narrowing) const;
+	SharedVector<Net> nets(const std::string& search, SearchMode mode, int limit, SearchNarrowing &narrowing) const;
 };
@@ -0,0 +1,152 @@
+#include "SelectionBand.h"
+#include "imgui_operators.h"
+
+#include <algorithm>
+
+static BBox Bounds(ImVec2 a, ImVec2 b) {
+	return {ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)), ImVec2(std::max(a.x, b.x), std::max(a.y, b.y))};
+}
+
+static bool InRect(const BBox &r, ImVec2 p) {
+	return p.x >= r.min.x && p.x <= r.max.x && p.y >= r.min.y && p.y <= r.max.y;
+}
+
+/*
+ * Crossing number of a triangle.  Each edge is taken lower end first, so
+ * an edge gives the same answer whichever polygon it's part of and the
+ * flips add up to exactly the even-odd test of the whole lasso.
+ */
+static bool InTriangle(ImVec2 a, ImVec2 b, ImVec2 c, ImVec2 p) {
+	const ImVec2 poly[3] = {a, b, c};
+	bool in              = false;
+	for (int i = 0, j = 2; i < 3; j = i++) {
+		ImVec2 e0 = poly[i], e1 = poly[j];
+		if (e1.y < e0.y) std::swap(e0, e1);
+		if ((e0.y > p.y) != (e1.y > p.y) && p.x < (e1.x - e0.x) * (p.y - e0.y) / (e1.y - e0.y) + e0.x) in = !in;
+	}
+	return in;
+}
+
+void SelectionBand::Begin(Picker &picker, Mode mode, int side, ImVec2 pos) {
+	End();
+
+	m_mode   = mode;
+	m_side   = side;
+	m_anchor = pos;
+	m_rect   = {pos, pos};
+	m_outline.assign(1, pos);
+	m_pin_in.resize(picker.PinCount(), 0);
+	m_part_corners.resize(picker.PartCount(), 0);
+
+	if (mode == kRect) Retest(picker, m_rect);
+}
+
+void SelectionBand::End() {
+	for (uint32_t i : m_pins_touched) m_pin_in[i] = 0;
+	for (uint32_t k : m_parts_touched) m_part_corners[k] = 0;
+	m_pins_touched.clear();
+	m_parts_touched.clear();
+	m_outline.clear();
+	m_mode = kNone;
+}
+
+void SelectionBand::Extend(Picker &picker, ImVec2 pos) {
+	if (m_mode == kLasso) {
+		ImVec2 last = m_outline.back();
+		if (pos == last) return;
+
+		m_outline.push_back(pos);
+		Flip(picker, last, pos, m_outline.front());
+		return;
+	}
+
+	if (m_mode != kRect) return;
+
+	BBox a = m_rect;
+	BBox b = Bounds(m_anchor, pos);
+	m_rect = b;
+	m_outline = {b.min, ImVec2(b.max.x, b.min.y), b.max, ImVec2(b.min.x, b.max.y)};
+
+	BBox u = {ImVec2(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)), ImVec2(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y))};
+	BBox i = {ImVec2(std::max(a.min.x, b.min.x), std::max(a.min.y, b.min.y)), ImVec2(std::min(a.max.x, b.max.x), std::min(a.max.y, b.max.y))};
+
+	if (i.min.x > i.max.x || i.min.y > i.max.y) {
+		Retest(picker, a);
+		Retest(picker, b);
+		return;
+	}
+
+	// what's in one rectangle and not the other lies around their overlap
+	if (u.min.x < i.min.x) Retest(picker, {u.min, ImVec2(i.min.x, u.max.y)});
+	if (i.max.x < u.max.x) Retest(picker, {ImVec2(i.max.x, u.min.y), u.max});
+	if (u.min.y < i.min.y) Retest(picker, {ImVec2(i.min.x, u.min.y), ImVec2(i.max.x, i.min.y)});
+	if (i.max.y < u.max.y) Retest(picker, {ImVec2(i.min.x, i.max.y), ImVec2(i.max.x, u.max.y)});
+}
+
+void SelectionBand::SetPin(uint32_t i, bool in) {
+	uint8_t &v = m_pin_in[i];
+	if (in && !(v & kTouched)) {
+		v |= kTouched;
+		m_pins_touched.push_back(i);
+	}
+	v = (v & kTouched) | uint8_t(in);
+}
+
+void SelectionBand::SetCorners(uint32_t k, uint8_t corners) {
+	uint8_t &v = m_part_corners[k];
+	if (corners && !(v & kTouched)) {
+		v |= kTouched;
+		m_parts_touched.push_back(k);
+	}
+	v = (v & kTouched) | corners;
+}
+
+void SelectionBand::Retest(Picker &picker, const BBox &region) {
+	picker.PinsIn(m_side, region, m_candidates);
+	for (uint32_t i : m_candidates) SetPin(i, InRect(m_rect, picker.PinPosition(i)));
+
+	picker.PartsIn(m_side, region, m_candidates);
+	for (uint32_t k : m_candidates) {
+		auto &q         = picker.PartOutline(k);
+		uint8_t corners = 0;
+		for (int c = 0; c < 4; c++) {
+			if (InRect(m_rect, q[c])) corners |= 1 << c;
+		}
+		SetCorners(k, corners);
+	}
+}
+
+void SelectionBand::Flip(Picker &picker, ImVec2 a, ImVec2 b, ImVec2 c) {
+	BBox region = {ImVec2(std::min({a.x, b.x, c.x}), std::min({a.y, b.y, c.y})), ImVec2(std::max({a.x, b.x, c.x}), std::max({a.y, b.y, c.y}))};
+
+	picker.PinsIn(m_side, region, m_candidates);
+	for (uint32_t i : m_candidates) {
+		if (InTriangle(a, b, c, picker.PinPosition(i))) SetPin(i, !(m_pin_in[i] & 1));
+	}
+
+	picker.PartsIn(m_side, region, m_candidates);
+	for (uint32_t k : m_candidates) {
+		auto &q         = picker.PartOutline(k);
+		uint8_t corners = m_part_corners[k] & 0x0f;
+		for (int n = 0; n < 4; n++) {
+			if (InTriangle(a, b, c, q[n])) corners ^= 1 << n;
+		}
+		SetCorners(k, corners);
+	}
+}
+
+void SelectionBand::Pins(std::vector<uint32_t> &out) const {
+	out.clear();
+	for (uint32_t i : m_pins_touched) {
+		if (m_pin_in[i] & 1) out.push_back(i);
+	}
+	std::sort(out.begin(), out.end());
+}
+
+void SelectionBand::Parts(std::vector<uint32_t> &out) const {
+	out.clear();
+	for (uint32_t k : m_parts_touched) {
+		if ((m_part_corners[k] & 0x0f) == 0x0f) out.push_back(k);
+	}
+	std::sort(out.begin(), out.end());
+}
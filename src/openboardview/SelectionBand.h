@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Picker.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Rubber-band (rectangle) and lasso selection of pins and parts.
+ *
+ * What's inside the band is kept up to date as it's dragged rather than
+ * worked out again from scratch every frame, and only for the elements
+ * near the part of the band that changed, found through the Picker:
+ *
+ * - the rectangle going from A to B only changes for what lies in one of
+ *   them but not the other, a handful of strips around their overlap;
+ * - the lasso is a polygon closed back to its first point, adding a point
+ *   n+1 after n swaps the closing edge n-0 for n-(n+1)-0, which (with
+ *   even-odd filling) flips inside/outside for exactly what lies in the
+ *   triangle n, n+1, 0.
+ *
+ * Pins are in when their centre is, parts when all four outline corners
+ * are.  Everything is in board coordinates; the view only rotates in
+ * quarter turns, so a screen rectangle is a board rectangle too.
+ */
+class SelectionBand {
+  public:
+	enum Mode { kNone, kRect, kLasso };
+
+	void Begin(Picker &picker, Mode mode, int side, ImVec2 pos);
+	// Moves the far corner of the rectangle, or adds a point to the lasso
+	void Extend(Picker &picker, ImVec2 pos);
+	void End();
+
+	bool Active() const {
+		return m_mode != kNone;
+	}
+	Mode GetMode() const {
+		return m_mode;
+	}
+	int Side() const {
+		return m_side;
+	}
+
+	// The band's outline, closed back to its first point
+	const std::vector<ImVec2> &Outline() const {
+		return m_outline;
+	}
+
+	// Indices of the pins and parts inside right now, board order
+	void Pins(std::vector<uint32_t> &out) const;
+	void Parts(std::vector<uint32_t> &out) const;
+
+  private:
+	void Retest(Picker &picker, const BBox &region);
+	void Flip(Picker &picker, ImVec2 a, ImVec2 b, ImVec2 c);
+	void SetPin(uint32_t i, bool in);
+	void SetCorners(uint32_t k, uint8_t corners);
+
+	Mode m_mode = kNone;
+	int m_side  = 0;
+	std::vector<ImVec2> m_outline;
+	ImVec2 m_anchor;
+	BBox m_rect;
+
+	static const uint8_t kTouched = 0x80; // in the touched list already
+	std::vector<uint8_t> m_pin_in;        // bit 0: inside
+	std::vector<uint8_t> m_part_corners;  // bits 0-3: which outline corners are inside
+	std::vector<uint32_t> m_pins_touched; // everything that was ever inside, for resetting and listing
+	std::vector<uint32_t> m_parts_touched;
+	std::vector<uint32_t> m_candidates;
+};
@@ -1,59 +1,140 @@
 #include "SpellCorrector.h"
 
+static std::string lowercase(const std::string &s) {
+	std::string l = s;
+	std::transform(l.begin(), l.end(), l.begin(), ::tolower);
+	return l;
+}
+
 void SpellCorrector::setDictionary(const std::vector<std::string>& dictionary) {
-	this->dictionary = dictionary;
+	m_words = dictionary;
+	m_folded.clear();
+	for (auto &w : m_words) m_folded.push_back(lowercase(w));
+
+	m_sorted.resize(m_words.size());
+	for (uint32_t i = 0; i < m_sorted.size(); i++) m_sorted[i] = i;
+	std::sort(m_sorted.begin(), m_sorted.end(), [this](uint32_t a, uint32_t b) { return m_folded[a] < m_folded[b]; });
+
+	m_nodes.clear();
+	m_children.clear();
+	build(0, m_sorted.size(), 0, 0);
 }
 
-/**
- * From https://en.wikibooks.org/wiki/Algorithm_Implementation/Strings/Levenshtein_distance#C.2B.2B
- * Added a limit parameter to limit the machting to n characters of the second string.
+/*
+ * Node for the sorted words lo..hi, which all share their first depth
+ * characters.  Those ending there sort first, the rest are split up by
+ * their next character.
  */
-unsigned int SpellCorrector::levenshtein_distance(const std::string& s1, const std::string& s2, size_t limit) {
-	const std::size_t len1 = s1.size(), len2 = s2.size();
-	limit = std::min(limit, len2);
-	std::vector<unsigned int> col(limit+1), prevCol(limit+1);
-
-	for (unsigned int i = 0; i < prevCol.size(); i++)
-		prevCol[i] = i;
-	for (unsigned int i = 0; i < len1; i++) {
-		col[0] = i+1;
-		for (unsigned int j = 0; j < limit; j++)
-			col[j+1] = std::min({ prevCol[1 + j] + 1, col[j] + 1, prevCol[j] + (s1[i]==s2[j] ? 0 : 1) });
-		col.swap(prevCol);
+uint32_t SpellCorrector::build(uint32_t lo, uint32_t hi, size_t depth, char c) {
+	uint32_t n = m_nodes.size();
+	m_nodes.push_back({lo, hi, lo, 0, 0, c});
+
+	uint32_t i = lo;
+	while (i < hi && m_folded[m_sorted[i]].size() == depth) i++;
+	m_nodes[n].words_end = i;
+
+	std::vector<uint32_t> children;
+	while (i < hi) {
+		char next  = m_folded[m_sorted[i]][depth];
+		uint32_t j = i;
+		while (j < hi && m_folded[m_sorted[j]][depth] == next) j++;
+		children.push_back(build(i, j, depth + 1, next));
+		i = j;
 	}
-	return prevCol[limit];
+
+	m_nodes[n].children = m_children.size();
+	m_nodes[n].count    = children.size();
+	m_children.insert(m_children.end(), children.begin(), children.end());
+	return n;
 }
 
 /**
- * Compute the levenshtein distance with a limit to s1 length + 1 character.
- * Returns 0 (meaning not matched) when the distance is above the threshold.
+ * The match is the Levenshtein distance between the word and the first
+ * (word length + 1) characters of the dictionary word, kept when under the
+ * threshold.  Once limit words are found within some distance, nothing
+ * further away can make it in and the bound shrinks to that.
  */
-unsigned int SpellCorrector::fuzzy_match(const std::string& s1, const std::string& s2) {
-	unsigned int score = levenshtein_distance(s1, s2, s1.size() + 1);
-	if (score > this->threshold) return 0;
-	return threshold - score;
-}
+std::vector<std::string> SpellCorrector::suggest(const std::string& word, int limit) const {
+	std::vector<std::string> suggestions;
+	if (m_nodes.empty()) return suggestions;
 
-std::vector<std::string> SpellCorrector::suggest(const std::string& word) {
-	std::vector<std::string> suggestions; // What will actually be returned, a vector of matched words with levenshtein below the threshold
-	std::vector<std::pair<std::string, unsigned int>> scores; // Vector of pairs of matched words and their associated score
-	std::string wordLower = word;
-	std::transform(wordLower.begin(), wordLower.end(), wordLower.begin(), ::tolower); // Lowercase the word to search for
+	const std::string w   = lowercase(word);
+	const size_t len      = w.size();
+	const size_t depth    = len + 1;
+	unsigned int max_dist = threshold - 1;
 
-	for (auto &s : dictionary) {
-		std::string sLower = s;
-		std::transform(sLower.begin(), sLower.end(), sLower.begin(), ::tolower); // Lowercase the word from the dictionary
+	std::vector<std::vector<uint32_t>> found(threshold); // word indices per distance
+	size_t want   = limit > 0 ? size_t(limit) : m_words.size();
+	size_t within = 0;
 
-		unsigned int score = fuzzy_match(wordLower, sLower);
-		if (score) scores.push_back({s, score});
-	}
+	auto add = [&](uint32_t lo, uint32_t hi, unsigned int dist) {
+		if (dist > max_dist) return;
+		for (uint32_t k = lo; k < hi; k++) found[dist].push_back(m_sorted[k]);
+		within += hi - lo;
+		// fewer edits only ever push the worse ones out
+		while (max_dist > 0 && within - found[max_dist].size() >= want) {
+			within -= found[max_dist].size();
+			found[max_dist].clear();
+			max_dist--;
+		}
+	};
 
-	// Sort by score, descending
-	std::sort(scores.begin(), scores.end(), [] (const std::pair<std::string, unsigned int>& v1, const std::pair<std::string, unsigned int>& v2) {
-		return v1.second > v2.second;
-	});
+	// one column of the distance table per trie depth, column[i] for the first i characters of the word
+	std::vector<unsigned int> columns((depth + 1) * (len + 1));
+	for (size_t i = 0; i <= len; i++) columns[i] = i;
 
-	for (auto &p : scores) suggestions.push_back(p.first);
+	struct Step {
+		uint32_t node;
+		uint32_t depth;
+	};
+	std::vector<Step> stack;
+
+	// the child following the word goes on top, exact prefixes found early bring the bound down sooner
+	auto push = [&](const Node &node, uint32_t depth) {
+		size_t top = stack.size();
+		for (uint32_t c = 0; c < node.count; c++) {
+			uint32_t child = m_children[node.children + c];
+			stack.push_back({child, depth + 1});
+			if (depth < len && m_nodes[child].c == w[depth]) top = stack.size() - 1;
+		}
+		if (top < stack.size()) std::swap(stack[top], stack.back());
+	};
+
+	const Node &root = m_nodes[0];
+	add(root.lo, root.words_end, columns[len]);
+	push(root, 0);
+
+	while (!stack.empty()) {
+		Step s = stack.back();
+		stack.pop_back();
+		const Node &node = m_nodes[s.node];
+
+		const unsigned int *prev = &columns[(s.depth - 1) * (len + 1)];
+		unsigned int *col        = &columns[s.depth * (len + 1)];
+		col[0]                   = s.depth;
+		unsigned int best        = col[0];
+		for (size_t i = 0; i < len; i++) {
+			col[i + 1] = std::min({prev[i + 1] + 1, col[i] + 1, prev[i] + (w[i] == node.c ? 0 : 1)});
+			best       = std::min(best, col[i + 1]);
+		}
+		if (best > max_dist) continue;
+
+		if (s.depth == depth) {
+			add(node.lo, node.hi, col[len]);
+			continue;
+		}
+
+		add(node.lo, node.words_end, col[len]);
+		push(node, s.depth);
+	}
+
+	for (unsigned int d = 0; d <= max_dist && suggestions.size() < want; d++) {
+		std::sort(found[d].begin(), found[d].end());
+		for (uint32_t k : found[d]) {
+			if (suggestions.size() == want) break;
+			suggestions.push_back(m_words[k]);
+		}
+	}
 
 	return suggestions;
 }
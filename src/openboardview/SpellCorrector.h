@@ -1,16 +1,41 @@
+#pragma once
+
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
+/*
+ * "Did you mean" suggestions: dictionary words whose start is within a
+ * couple of edits of the word typed.
+ *
+ * The dictionary is lowercased once and sorted into a trie, so every word
+ * under a node covers one range of the sorted list.  suggest() walks it
+ * carrying one Levenshtein column per node and gives up on a branch as soon
+ * as the whole column is over the threshold; past the length of the word
+ * plus one, the distance is the same for the whole subtree.
+ */
 class SpellCorrector {
 	unsigned int threshold = 3;
-	std::vector<std::string> dictionary;
 
-	unsigned int levenshtein_distance(const std::string& s1, const std::string& s2, size_t limit);
-	unsigned int fuzzy_match(const std::string& s1, const std::string& s2);
+	struct Node {
+		uint32_t lo, hi;          // words under this node, in m_sorted
+		uint32_t words_end;       // lo..words_end end here
+		uint32_t children, count; // in m_children
+		char c;
+	};
+
+	std::vector<std::string> m_words;   // as given
+	std::vector<std::string> m_folded;  // lowercased, same order
+	std::vector<uint32_t> m_sorted;     // word indices by folded word
+	std::vector<Node> m_nodes;          // m_nodes[0] is the root
+	std::vector<uint32_t> m_children;
+
+	uint32_t build(uint32_t lo, uint32_t hi, size_t depth, char c);
 
 public:
 	void setDictionary(const std::vector<std::string>& dictionnary);
 
-	std::vector<std::string> suggest(const std::string& word);
+	// Closest first, dictionary order between equals; at most limit of them (<= 0 for all)
+	std::vector<std::string> suggest(const std::string& word, int limit = -1) const;
 };
@@ -290,8 +290,8 @@ namespace OBV_Tcl {
 			is_top = true;
 		}
 		
-		std::lock_guard lck(boardview()->m_DrawNodes_mutex);
-		boardview()->m_board->Nodes().push_back(obv_shared_ptr<Node>(new Node {p1->position, p2->position, n, is_top, bool(stub) }));
+		boardview()->m_nodes.Add(Node {p1->position, p2->position, n, is_top, bool(stub) });
+		boardview()->m_stats.NodeAdded(boardview()->m_registry.NetId(n));
 	}
 	
 #ifdef OBV_USE_POPPLER
@@ -308,7 +308,7 @@ namespace OBV_Tcl {
 		return r;
 	}
 
-	object TCL::get_schem_words(interpreter * tcli, getopt<int> const & page, getopt<std::string> const & filter_arg, getopt<bool> const & use_regex, getopt<pdf_txt_bbox *> const & ref, getopt<std::string> const & sort, getopt<list<pdf_txt_bbox> > const & not_, getopt<any<list<Component> , list<Pin>, list<Net>, list<pdf_txt_bbox> > > const & of, getopt<std::string> const & exact, getopt<std::string> const & color, getopt<list<pdf_txt_bbox> > const & bbox, getopt<float> const & radius, getopt<int> const & nearest, variadic<std::string> const & match) {
+	object TCL::get_schem_words(interpreter * tcli, getopt<int> const & page, getopt<std::string> const & filter_arg, getopt<bool> const & use_regex, getopt<pdf_txt_bbox *> const & ref, getopt<std::string> const & sort, getopt<list<pdf_txt_bbox> > const & not_, getopt<any<list<Component> , list<Pin>, list<Net>, list<pdf_txt_bbox> > > const & of, getopt<std::string> const & exact, getopt<std::string> const & color, getopt<list<pdf_txt_bbox> > const & bbox, getopt<float> const & radius, getopt<int> const & nearest, getopt<int> const & first, variadic<std::string> const & match) {
 		object r;
 		object filter_o; int filter = 0; std::string filter_ns;
 		object sort_o; int sort_ix; std::string sort_ns;
@@ -374,8 +374,10 @@ namespace OBV_Tcl {
 		auto * filter_vars = filter_vars1 ? &*filter_vars1 : nullptr;
 
 		auto filter_vars_holder = make_variables_installer(tcli, filter_ns, filter_vars ? &*filter_vars : nullptr);
+		native_filter<pdf_txt_bbox, Tcl_Obj *> native(filter_arg, ref ? *ref : nullptr);
 		
 		auto try_append = [&](pdf_txt_bbox * p, Tcl_Obj * obj = nullptr) {
+			if (native.queue(p, obj)) return;
 			//std::cerr << "try " << p->word << " " << p << "\n";
 			if (matches(match, re, p->word, use_regex)
 				&& (!radius || ((*ref)->page == p->page && distance((*ref)->box, p->box) < *radius))
@@ -383,9 +385,9 @@ namespace OBV_Tcl {
 				&& (!exact || *exact == p->word)
 				&& not_set.find(p) == not_set.end()
 				&& (exact_match.empty() || exact_match.find(p->word) != exact_match.end())
-				&& filter_match(tcli, filter_ns, filter_vars, filter_o, p, nullptr, ref ? *ref : nullptr)
+				&& native.match([&] { return filter_match(tcli, filter_ns, filter_vars, filter_o, p, nullptr, ref ? *ref : nullptr); })
 				) {
-				if (sort) {
+				if (sort || first) {
 					//std::cerr << "push " << p->word << "\n";
 					ret.push_back(std::pair(p, obj));
 				} else {
@@ -443,14 +445,25 @@ namespace OBV_Tcl {
 				}
 			}
 		}
-		if (sort) {
-			auto vars = get_variables_from_expr(tcli, *sort);
-			auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
+		native.replay([&](pdf_txt_bbox * p, Tcl_Obj * o) { try_append(p, o); });
 
-			std::sort(ret.begin(), ret.end(), [&](std::pair<pdf_txt_bbox *, Tcl_Obj *> a, std::pair<pdf_txt_bbox *, Tcl_Obj *> b) -> bool {
-						  //std::cerr << "less " << a->word << " " << b->word << "\n";
-						  return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a.first, b.first, ref ? *ref : nullptr);
-					  });
+		if (sort || first) {
+			std::size_t n = first ? std::max(*first, 0) : ret.size();
+			if (sort && ! native_sort(*sort, ref ? *ref : nullptr, ret, [](std::pair<pdf_txt_bbox *, Tcl_Obj *> const & e) { return e.first; }, n)) {
+				auto vars = get_variables_from_expr(tcli, *sort);
+				auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
+
+				auto less = [&](std::pair<pdf_txt_bbox *, Tcl_Obj *> a, std::pair<pdf_txt_bbox *, Tcl_Obj *> b) -> bool {
+					//std::cerr << "less " << a->word << " " << b->word << "\n";
+					return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a.first, b.first, ref ? *ref : nullptr);
+				};
+				if (n < ret.size()) {
+					std::partial_sort(ret.begin(), ret.begin() + n, ret.end(), less);
+				} else {
+					std::sort(ret.begin(), ret.end(), less);
+				}
+			}
+			if (ret.size() > n) ret.resize(n);
 			for (auto & p : ret) {
 				//std::cerr << "ret " << p->word << "\n";
 				if (p.second) {
@@ -493,13 +506,15 @@ namespace OBV_Tcl {
 		auto * filter_vars = filter_vars1 ? &*filter_vars1 : nullptr;
 
 		auto filter_vars_holder = make_variables_installer(tcli, filter_ns, filter_vars ? &*filter_vars : nullptr);
+		native_filter<Net, Component *> native(filter_arg);
 		
 		auto try_append = [&](Net * n, Component * of = nullptr) {
+			if (native.queue(n, of)) return true;
 			if ((gnd || !n->is_ground)
 				&& (all || dup.find(n) == dup.end())
 				&& not_set.find(n) == not_set.end()
 				&& matches(match, re, n->name, use_regex)
-				&& filter_match(tcli, filter_ns, filter_vars, filter_o, n, of)) {
+				&& native.match([&] { return filter_match(tcli, filter_ns, filter_vars, filter_o, n, of); })) {
 				r.append(tcli->makeobj(n));
 				if (!all) dup.insert(n);
 			}
@@ -548,11 +563,12 @@ namespace OBV_Tcl {
 				}
 			}				
 		}
+		native.replay([&](Net * n, Component * of) { try_append(n, of); });
 		return r;
 	}
 
 
-	object TCL::get_pins(interpreter * tcli, getopt<bool> const & use_regex, getopt<bool> const & all, getopt<bool> const & parallel, getopt<std::string> const & filter_arg, getopt<bool> const & via, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & of, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & notof, getopt<list<Pin> > const & not_, getopt<Pin *> const & ref, getopt<std::string> const & sort, getopt<bool> const & brief, variadic<std::string> const & match) {
+	object TCL::get_pins(interpreter * tcli, getopt<bool> const & use_regex, getopt<bool> const & all, getopt<bool> const & parallel, getopt<std::string> const & filter_arg, getopt<bool> const & via, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & of, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & notof, getopt<list<Pin> > const & not_, getopt<Pin *> const & ref, getopt<std::string> const & sort, getopt<bool> const & brief, getopt<int> const & first, variadic<std::string> const & match) {
 		if (brief) { }
 
 		object r;
@@ -593,10 +609,12 @@ namespace OBV_Tcl {
 		auto * filter_vars = filter_vars1 ? &*filter_vars1 : nullptr;
 
 		auto filter_vars_holder = make_variables_installer(tcli, filter_ns, filter_vars ? &*filter_vars : nullptr);
+		native_filter<Pin, Tcl_Obj *> native(filter_arg, ref ? *ref : nullptr);
 
 		std::vector<std::pair<Pin *, Tcl_Obj *> > ret;
 		
 		auto try_append = [&](Pin * c, Tcl_Obj * obj = nullptr) {
+			if (native.queue(c, obj)) return true;
 			std::string m(c->name);
 			if (match_has_slash) {
 				m = c->component->name + "/" + c->name;
@@ -605,7 +623,7 @@ namespace OBV_Tcl {
 				&& matches(match ? match : variadic<std::string>{}, re, m, use_regex)
 				&& not_set.find(c) == not_set.end()
 				&& (via || c->component.get() && c->component->component_type != Component::kComponentTypeDummy)
-				&& filter_match(tcli, filter_ns, filter_vars, filter_o, c, nullptr, ref ? *ref : nullptr)) {
+				&& native.match([&] { return filter_match(tcli, filter_ns, filter_vars, filter_o, c, nullptr, ref ? *ref : nullptr); })) {
 
 				bool keep = true;
 				if (notof) {
@@ -628,7 +646,7 @@ namespace OBV_Tcl {
 					
 				}
 				if (keep) {
-					if (sort) {
+					if (sort || first) {
 						ret.push_back(std::pair(c, obj));
 					} else {
 						if (obj) {
@@ -690,14 +708,24 @@ namespace OBV_Tcl {
 				}					
 			}
 		}
-		if (sort) {
-			auto vars = get_variables_from_expr(tcli, *sort);
-			auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
+		native.replay([&](Pin * p, Tcl_Obj * o) { try_append(p, o); });
 
-			std::sort(ret.begin(), ret.end(), [&](std::pair<Pin *, Tcl_Obj *> a, std::pair<Pin *, Tcl_Obj *> b) -> bool {
-						  //std::cerr << "less " << a->word << " " << b->word << "\n";
-						  return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a.first, b.first, ref ? *ref : nullptr);
-					  });
+		if (sort || first) {
+			std::size_t n = first ? std::max(*first, 0) : ret.size();
+			if (sort && ! native_sort(*sort, ref ? *ref : nullptr, ret, [](std::pair<Pin *, Tcl_Obj *> const & e) { return e.first; }, n)) {
+				auto vars = get_variables_from_expr(tcli, *sort);
+				auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
+
+				auto less = [&](std::pair<Pin *, Tcl_Obj *> a, std::pair<Pin *, Tcl_Obj *> b) -> bool {
+					return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a.first, b.first, ref ? *ref : nullptr);
+				};
+				if (n < ret.size()) {
+					std::partial_sort(ret.begin(), ret.begin() + n, ret.end(), less);
+				} else {
+					std::sort(ret.begin(), ret.end(), less);
+				}
+			}
+			if (ret.size() > n) ret.resize(n);
 			for (auto & p : ret) {
 				if (p.second) {
 					r.append(object(p.second));
@@ -713,7 +741,7 @@ namespace OBV_Tcl {
 	object TCL::get_cells(interpreter * tcli, getopt<std::string> const & filter_arg, getopt<std::string> const & sort, getopt<bool> const & use_regex, getopt<any<list<Component>, list<Net>, list<Pin>, list<pdf_txt_bbox> > > const & of, getopt<bool> const & all,
 						  getopt<bool> const & top,
 						  getopt<bool> const & bottom,
-						  getopt<list<Component> > const & not_, getopt<Component *> const & ref, variadic<std::string> const & match) {
+						  getopt<list<Component> > const & not_, getopt<Component *> const & ref, getopt<int> const & first, variadic<std::string> const & match) {
 		object r;
 		int filter = 0; std::string filter_ns; object filter_o;
 		int sort_ix; std::string sort_ns; object sort_o;
@@ -750,16 +778,18 @@ namespace OBV_Tcl {
 		auto * filter_vars = filter_vars1 ? &*filter_vars1 : nullptr;
 
 		auto filter_vars_holder = make_variables_installer(tcli, filter_ns, filter_vars ? &*filter_vars : nullptr);
+		native_filter<Component> native(filter_arg, ref ? *ref : nullptr);
 		
 		auto try_append = [&](Component * c) {
+			if (native.queue(c)) return true;
 			if (!is_dummy(c)
 				&& ((! top && ! bottom) || (top && c->board_side == kBoardSideTop) || (bottom && c->board_side == kBoardSideBottom))
 				&& (all || dup.find(c) == dup.end())
 				&& not_set.find(c) == not_set.end()
 				&& matches(match, re, c->name, use_regex)
-				&& filter_match(tcli, filter_ns, filter_vars, filter_o, c, nullptr, ref ? *ref : nullptr)) {
+				&& native.match([&] { return filter_match(tcli, filter_ns, filter_vars, filter_o, c, nullptr, ref ? *ref : nullptr); })) {
 
-				if (sort) {
+				if (sort || first) {
 					ret.push_back(c);
 				} else {
 					r.append(tcli->makeobj(c));
@@ -783,10 +813,8 @@ namespace OBV_Tcl {
 						  }
 					  },
 					  [&](pdf_txt_bbox * p) {
-						  for (auto && c : boardview()->m_board->Components()) {
-							  if (c->name == p->word) {
-								  try_append(&*c);
-							  }
+						  for (uint32_t id : boardview()->m_registry.PartsNamed(p->word)) {
+							  try_append(&*boardview()->m_board->Components()[id]);
 						  }
 					  });
 		} else {
@@ -808,12 +836,24 @@ namespace OBV_Tcl {
 			}				
 		}
 
-		if (sort) {
-			auto vars = get_variables_from_expr(tcli, *sort);
-			auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
-			std::sort(ret.begin(), ret.end(), [&](Component * a, Component * b) -> bool {
-						  return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a, b, ref ? *ref : nullptr);
-					  });
+		native.replay([&](Component * c, void *) { try_append(c); });
+
+		if (sort || first) {
+			std::size_t n = first ? std::max(*first, 0) : ret.size();
+			if (sort && ! native_sort(*sort, ref ? *ref : nullptr, ret, [](Component * c) { return c; }, n)) {
+				auto vars = get_variables_from_expr(tcli, *sort);
+				auto vars_holder = make_variables_installer(tcli, sort_ns, vars ? &*vars : nullptr);
+
+				auto less = [&](Component * a, Component * b) -> bool {
+					return sort_less(*tcli, sort_ns, vars ? &*vars : nullptr, sort_o, a, b, ref ? *ref : nullptr);
+				};
+				if (n < ret.size()) {
+					std::partial_sort(ret.begin(), ret.begin() + n, ret.end(), less);
+				} else {
+					std::sort(ret.begin(), ret.end(), less);
+				}
+			}
+			if (ret.size() > n) ret.resize(n);
 			for (auto * p : ret) {
 				r.append(tcli->makeobj(p));
 			}
@@ -882,10 +922,12 @@ namespace OBV_Tcl {
 				ci->shade_color_ = 0;
 				ci->intensity_delta_ = 1;
 			}
+			boardview()->InvalidateStyles();
 		} else if (obj) {
 			for (auto le : *obj) {
 				if (le) {
 					le.visit([&](Component * c) {
+								 boardview()->InvalidateStyle(c);
 								 if (un || toggle && c->shade_color_) {
 									 c->shade_color_ = 0;
 								 } else {
@@ -902,14 +944,14 @@ namespace OBV_Tcl {
 								 }
 							 },
 							 [&](Pin * p) {
-								 for (auto && pi : brd()->Pins()) {
-									 if (pi.get() == p) {
-										 if (inten) {
-											 pi->intensity_delta_ = *inten;
-										 } else {
-											 boardview()->m_pinHighlighted.push_back(pi);
-										 }
-										 break;
+								 int id = boardview()->m_registry.PinId(p);
+								 if (id >= 0) {
+									 auto &pi = brd()->Pins()[id];
+									 if (inten) {
+										 pi->intensity_delta_ = *inten;
+										 boardview()->InvalidateStyle(pi.get());
+									 } else {
+										 boardview()->HighlightPin(pi);
 									 }
 								 }
 							 },
@@ -921,6 +963,7 @@ namespace OBV_Tcl {
 				}
 			}
 		}
+		boardview()->InvalidateLayers(kLayerMaskSelection);
 	}
 
 	void TCL::set_prop(std::string const & prop, std::string const & value, list<any<Component, Net, Pin, pdf_txt_bbox> > const & obj) {
@@ -965,6 +1008,7 @@ namespace OBV_Tcl {
 				pr->properties[prop] = value;
 			}
 		}
+		boardview()->InvalidateLayers(kLayerMaskSelection);
 	}
 
 	std::string TCL::varinfo(interpreter * tcli, std::string const & var) {
@@ -1030,6 +1074,7 @@ namespace OBV_Tcl {
 										  }
 										  if (!detach) {
 											  thr->finished = true;
+											  BoardView::wakeup();
 											  thr->exit_mutex.lock();
 										  }
 										  delete thr->interp;
@@ -1113,15 +1158,12 @@ namespace OBV_Tcl {
 			Component * c; Pin * p; Net * n;
 			if (p && n) { }
 			if ((c = le.as<Component>())) {
-				for (auto && ci : brd()->Components()) {
-					if (ci.get() == c) {
-						boardview()->m_partHighlighted.push_back(ci);
-						//found = true;
-						break;
-					}
-				}
+				int id = boardview()->m_registry.PartId(c);
+				if (id >= 0) boardview()->m_partHighlighted.push_back(brd()->Components()[id]);
 			}
 		}
+		boardview()->HighlightsChanged();
+		boardview()->InvalidateLayers(kLayerMaskSelection);
 	}
 
 	void TCL::prop_begin(getopt<bool> const & help, getopt<bool> const & mark, getopt<bool> const & highlight) {
@@ -1385,6 +1427,7 @@ namespace OBV_Tcl {
 			.def("dup",               &this_t::dup)
 			.def("history",           &this_t::history,           options(history_opt))
 			.def("generate_mark",     &this_t::generate_mark,     options(generate_mark_opt))
+			.def("bench_coords",      &this_t::bench_coords,      options(bench_coords_opt))
 			.def("get_prop",          &this_t::get_prop)
 			.def("set_prop",          &this_t::set_prop)
 			.def("get",               &this_t::get_prop)
@@ -1529,6 +1572,152 @@ proc preload_schem_pages { quality { threads 1 } } {
 		startup_script = script;
 	}
 
+	const PartStats * TCL::part_stats(Component * c) {
+		BoardView * bv = this_s_ ? this_s_->boardview() : nullptr;
+		return bv ? bv->m_stats.OfPart(bv->m_registry.PartId(c)) : nullptr;
+	}
+	int TCL::part_pins(Component * c) {
+		const PartStats * stats = part_stats(c);
+		return stats ? (int) stats->pins : (int) c->pins.size();
+	}
+	int TCL::part_gnd_pins(Component * c) {
+		if (const PartStats * stats = part_stats(c)) return stats->ground_pins;
+		int n = 0;
+		for (auto && pi : c->pins) n += pi->net && pi->net->is_ground;
+		return n;
+	}
+	int TCL::part_nets(Component * c) {
+		if (const PartStats * stats = part_stats(c)) return stats->nets;
+		std::set<Net *> nets;
+		for (auto && pi : c->pins) if (pi->net) nets.insert(pi->net);
+		return (int) nets.size();
+	}
+	const NetStats * TCL::net_stats(Net * n) {
+		BoardView * bv = this_s_ ? this_s_->boardview() : nullptr;
+		return bv ? bv->m_stats.OfNet(bv->m_registry.NetId(n)) : nullptr;
+	}
+	int TCL::net_pins(Net * n) {
+		const NetStats * stats = net_stats(n);
+		return stats ? (int) stats->pins : (int) n->pins.size();
+	}
+	int TCL::net_parts(Net * n) {
+		if (const NetStats * stats = net_stats(n)) return stats->parts;
+		std::set<Component *> parts;
+		for (auto && pi : n->pins) if (pi->component) parts.insert(pi->component.get());
+		return (int) parts.size();
+	}
+	int TCL::net_nodes(Net * n) {
+		BoardView * bv = this_s_ ? this_s_->boardview() : nullptr;
+		return bv ? (int) bv->m_stats.Nodes(bv->m_registry.NetId(n)) : 0;
+	}
+	uint8_t TCL::net_sides(Net * n) {
+		if (const NetStats * stats = net_stats(n)) return stats->sides;
+		uint8_t sides = 0;
+		for (auto && pi : n->pins) if (pi->component) sides |= 1 << pi->component->board_side;
+		return sides;
+	}
+	bool TCL::pin_is_pad(Pin * p) {
+		Component * c = p->component.get();
+		if (c) {
+			bool top = false, bottom = false, left = false, right = false;
+			for (auto && pi : c->pins) {
+				if (pi->position.x < p->position.x - p->diameter / 2) left = true;
+				if (pi->position.x > p->position.x + p->diameter / 2) right = true;
+				if (pi->position.y < p->position.y - p->diameter / 2) bottom = true;
+				if (pi->position.y > p->position.y + p->diameter / 2) top = true;
+				if (top && bottom && left && right) return true;
+			}
+		}
+		return false;
+	}
+
+	const FilterExpr::Schema & TCL::filter_schema(Component *) {
+		using FE = FilterExpr;
+		static const FE::Schema schema = [] {
+			FE::Schema s;
+			s.properties = {
+				{ "name", FE::kString, nullptr, [](const void * c) -> const std::string & { return ((Component *) c)->name; } },
+				{ "top", FE::kInt, [](const void * c) -> double { return ((Component *) c)->board_side == kBoardSideTop; }, nullptr },
+				{ "pins", FE::kInt, [](const void * c) -> double { return part_pins((Component *) c); }, nullptr },
+				{ "gnd_pins", FE::kInt, [](const void * c) -> double { return part_gnd_pins((Component *) c); }, nullptr },
+				{ "nets", FE::kInt, [](const void * c) -> double { return part_nets((Component *) c); }, nullptr },
+				{ "has_gnd", FE::kInt, [](const void * c) -> double { return part_gnd_pins((Component *) c) > 0; }, nullptr },
+			};
+#ifdef OBV_USE_POPPLER
+			// distance takes parts, and has nothing to say about them
+			s.distance = [](const void *, const void *) { return 0.0f; };
+#endif
+			return s;
+		}();
+		return schema;
+	}
+	const FilterExpr::Schema & TCL::filter_schema(Net *) {
+		using FE = FilterExpr;
+		static const FE::Schema schema = [] {
+			constexpr uint8_t top = 1 << kBoardSideTop | 1 << kBoardSideBoth, bottom = 1 << kBoardSideBottom | 1 << kBoardSideBoth;
+			FE::Schema s;
+			s.properties = {
+				{ "name", FE::kString, nullptr, [](const void * n) -> const std::string & { return ((Net *) n)->name; } },
+				{ "isgnd", FE::kInt, [](const void * n) -> double { return ((Net *) n)->is_ground; }, nullptr },
+				{ "pins", FE::kInt, [](const void * n) -> double { return net_pins((Net *) n); }, nullptr },
+				{ "parts", FE::kInt, [](const void * n) -> double { return net_parts((Net *) n); }, nullptr },
+				{ "nodes", FE::kInt, [](const void * n) -> double { return net_nodes((Net *) n); }, nullptr },
+				{ "top", FE::kInt, [](const void * n) -> double { return bool(net_sides((Net *) n) & top); }, nullptr },
+				{ "bottom", FE::kInt, [](const void * n) -> double { return bool(net_sides((Net *) n) & bottom); }, nullptr },
+			};
+			return s;
+		}();
+		return schema;
+	}
+	const FilterExpr::Schema & TCL::filter_schema(Pin *) {
+		using FE = FilterExpr;
+		static const FE::Schema schema = [] {
+			FE::Schema s;
+			s.properties = {
+				{ "name", FE::kString, nullptr, [](const void * p) -> const std::string & { return ((Pin *) p)->name; } },
+				{ "isgnd", FE::kInt, [](const void * p) -> double { return ((Pin *) p)->net && ((Pin *) p)->net->is_ground; }, nullptr },
+				{ "ispad", FE::kInt, [](const void * p) -> double { return pin_is_pad((Pin *) p); }, nullptr },
+			};
+#ifdef OBV_USE_POPPLER
+			s.distance = [](const void * a, const void * b) { return distance_between(((Pin *) a)->position, ((Pin *) b)->position); };
+			s.angle    = [](const void * a, const void * b, bool ortho) { return angle_between(((Pin *) a)->position, ((Pin *) b)->position, ortho); };
+#endif
+			return s;
+		}();
+		return schema;
+	}
+	const FilterExpr::Schema & TCL::filter_schema(pdf_txt_bbox *) {
+		using FE = FilterExpr;
+		using W = const pdf_txt_bbox;
+		static const FE::Schema schema = [] {
+			FE::Schema s;
+			s.properties = {
+				{ "xmin", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.min.x; }, nullptr },
+				{ "ymin", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.min.y; }, nullptr },
+				{ "xmax", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.max.x; }, nullptr },
+				{ "ymax", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.max.y; }, nullptr },
+				{ "width", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.max.x - ((W *) p)->box.min.x; }, nullptr },
+				{ "height", FE::kDouble, [](const void * p) -> double { return ((W *) p)->box.max.y - ((W *) p)->box.min.y; }, nullptr },
+				{ "clickable", FE::kInt, [](const void * p) -> double { return ((W *) p)->clickable; }, nullptr },
+				{ "hoverable", FE::kInt, [](const void * p) -> double { return ((W *) p)->hoverable; }, nullptr },
+				{ "page", FE::kInt, [](const void * p) -> double { return ((W *) p)->page; }, nullptr },
+				{ "mark", FE::kInt, [](const void * p) -> double { W * w = (W *) p; return (w->mark & 1 << sizeof(w->mark) * 8 - 1 ? 0 : w->mark); }, nullptr },
+				{ "genmark", FE::kInt, [](const void * p) -> double { W * w = (W *) p; return (w->mark & ~(1 << sizeof(w->mark) * 8 - 1)); }, nullptr },
+				{ "is_cell", FE::kInt, [](const void * p) -> double { return bool(((W *) p)->cell); }, nullptr },
+				{ "is_net", FE::kInt, [](const void * p) -> double { return bool(((W *) p)->net); }, nullptr },
+				{ "highlighted", FE::kInt, [](const void * p) -> double { return bool(((W *) p)->color); }, nullptr },
+				{ "marked", FE::kInt, [](const void * p) -> double { W * w = (W *) p; return bool(w->mark) && !bool(w->mark & 1ULL << sizeof(w->mark) * 8 - 1); }, nullptr },
+				{ "genmarked", FE::kInt, [](const void * p) -> double { W * w = (W *) p; return bool(w->mark & 1ULL << sizeof(w->mark) * 8 - 1) && bool(w->mark & ~(1ULL << sizeof(w->mark) * 8 - 1)); }, nullptr },
+			};
+#ifdef OBV_USE_POPPLER
+			s.distance = [](const void * a, const void * b) { return distance_between(center(((W *) a)->box), center(((W *) b)->box)); };
+			s.angle    = [](const void * a, const void * b, bool ortho) { return angle_between(center(((W *) a)->box), center(((W *) b)->box), ortho); };
+#endif
+			return s;
+		}();
+		return schema;
+	}
+
 	template <typename CMP>
 	bool TCL::schem_word_get_prop_impl(const char * prop, pdf_txt_bbox * p, object & ret, object * set, CMP icmp) {
 		const bool rw = true;
@@ -1580,9 +1769,18 @@ proc preload_schem_pages { quality { threads 1 } } {
 	template <typename CMP>
 	bool TCL::cell_get_prop_impl(const char * prop, Component * c, object & ret, object * set, CMP icmp) {
 		const bool rw = true;
+		BoardView * bv = this_s_ ? this_s_->boardview() : nullptr;
+
 		if (icmp(prop, "name", rw)) {
 			ret = c->name;
-			if (set) c->name = set->get<std::string>();
+			if (set) {
+				std::string old_name = c->name;
+				c->name = set->get<std::string>();
+				if (bv) {
+					bv->m_registry.RenamedPart(c, old_name);
+					bv->InvalidateNames();
+				}
+			}
 		} else if (icmp(prop, "type")) {
 			std::ostringstream oss;
 			oss << c->component_type;
@@ -1591,17 +1789,14 @@ proc preload_schem_pages { quality { threads 1 } } {
 			ret = c->board_side == kBoardSideTop;
 		} else if (icmp(prop, "pins")) {
 			//std::cerr << "P" << ret.get_object()->refCount << "\n";
-			ret = (int) c->pins.size();
+			ret = part_pins(c);
 			//std::cerr << "PP" << ret.get_object()->refCount << "\n";
+		} else if (icmp(prop, "gnd_pins")) {
+			ret = part_gnd_pins(c);
+		} else if (icmp(prop, "nets")) {
+			ret = part_nets(c);
 		} else if (icmp(prop, "has_gnd")) {
-			for (auto && pi : c->pins) {
-				Net * n = pi->net;
-				if (n && n->is_ground) {
-					ret = true;
-					return true;
-				}
-			}
-			ret = false;
+			ret = part_gnd_pins(c) > 0;
 		} else {
 			if constexpr (std::is_same<CMP, cmpeq_t>::value) {
 				return extra_properties_get_impl(prop, ret, (be_priv *) c->tcl_priv);
@@ -1626,21 +1821,7 @@ proc preload_schem_pages { quality { threads 1 } } {
 		} else if (icmp(prop, "isgnd")) {
 			ret = bool(p->net && p->net->is_ground);
 		} else if (icmp(prop, "ispad")) {
-			Component * c = p->component.get();
-			if (c) {
-				bool top = false, bottom = false, left = false, right = false;
-				for (auto && pi : c->pins) {
-					if (pi->position.x < p->position.x - p->diameter / 2) left = true;
-					if (pi->position.x > p->position.x + p->diameter / 2) right = true;
-					if (pi->position.y < p->position.y - p->diameter / 2) bottom = true;
-					if (pi->position.y > p->position.y + p->diameter / 2) top = true;
-					if (top && bottom && left && right) {
-						ret = true;
-						return true;
-					}
-				}
-			}
-			ret = false;
+			ret = pin_is_pad(p);
 		} else if (icmp(prop, "name")) {
 			ret = p->name;
 		} else {
@@ -1656,13 +1837,29 @@ proc preload_schem_pages { quality { threads 1 } } {
 	template <typename CMP>
 	bool TCL::net_get_prop_impl(const char * prop, Net * n, object & ret, object * set, CMP icmp) {
 		const bool rw = true;
+		BoardView * bv = this_s_ ? this_s_->boardview() : nullptr;
+		const uint8_t top = 1 << kBoardSideTop | 1 << kBoardSideBoth, bottom = 1 << kBoardSideBottom | 1 << kBoardSideBoth;
+
 		if (icmp(prop, "name", rw)) {
 			ret = n->name;
 			if (set) {
+				std::string old_name = n->name;
 				n->name = set->get<std::string>();
+				if (bv) {
+					bv->m_registry.RenamedNet(n, old_name);
+					bv->InvalidateNames();
+				}
 			}
 		} else if (icmp(prop, "isgnd")) {
 			ret = n->is_ground;
+		} else if (icmp(prop, "pins")) {
+			ret = net_pins(n);
+		} else if (icmp(prop, "parts")) {
+			ret = net_parts(n);
+		} else if (icmp(prop, "nodes")) {
+			ret = net_nodes(n);
+		} else if (icmp(prop, "top") || icmp(prop, "bottom")) {
+			ret = bool(net_sides(n) & (icmp(prop, "top") ? top : bottom));
 		} else {
 			if constexpr (std::is_same<CMP, cmpeq_t>::value) {
 				return extra_properties_get_impl(prop, ret, (be_priv *) n->tcl_priv);
@@ -1839,9 +2036,7 @@ proc preload_schem_pages { quality { threads 1 } } {
 				if (border) {
 					throw tcl_error("-border not implemented");
 				} else { // center
-					ImVec2 ca = center(ap->box), cb = center(bp->box);
-					ImVec2 d = ca - cb;
-					return sqrtf(d.x * d.x + d.y * d.y);
+					return distance_between(center(ap->box), center(bp->box));
 				}
 			}
 		}
@@ -1849,8 +2044,7 @@ proc preload_schem_pages { quality { threads 1 } } {
 		{
 			Pin * ap = a.as<Pin>(), * bp = b.as<Pin>();
 			if (ap && bp) {
-				ImVec2 v(abs(ap->position.x - bp->position.x), abs(ap->position.y - bp->position.y));
-				return sqrtf(v.x * v.x + v.y * v.y);
+				return distance_between(ap->position, bp->position);
 			}
 		}
 #if 0
@@ -1874,41 +2068,32 @@ proc preload_schem_pages { quality { threads 1 } } {
 		{
 			pdf_txt_bbox * ap = a.as<pdf_txt_bbox>(), * bp = b.as<pdf_txt_bbox>();
 			if (ap && bp) {
-				ImVec2 v = center(ap->box) - center(bp->box);
-				if (v.y == 0) {
-					return 0.0f;
-				} else {
-					float deg = atanf(v.x / v.y) * 180 / M_PI;
-					if (ortho) {
-						int m1 = int(abs(deg)) % 90;
-						int m2 = 90 - int(abs(deg)) % 90;
-						return float(m1 < m2 ? m1 : m2);
-					} else {
-						return deg;
-					}
-				}
+				return angle_between(center(ap->box), center(bp->box), bool(ortho));
 			}
 		}
 		{
 			Pin * ap = a.as<Pin>(), * bp = b.as<Pin>();
 			if (ap && bp) {
-				ImVec2 v = ap->position - bp->position;
-				if (v.y == 0) {
-					return 0.0f;
-				} else {
-					float deg = atanf(v.x / v.y) * 180 / M_PI;
-					if (ortho) {
-						int m1 = int(abs(deg)) % 90;
-						int m2 = 90 - int(abs(deg)) % 90;
-						return float(m1 < m2 ? m1 : m2);
-					} else {
-						return deg;
-					}
-				}
+				return angle_between(ap->position, bp->position, bool(ortho));
 			}
 		}
 		throw tcl_error("arguments do not match any supported object types");
 	}
+	float TCL::angle_between(ImVec2 a, ImVec2 b, bool ortho) {
+		ImVec2 v = a - b;
+		if (v.y == 0) {
+			return 0.0f;
+		} else {
+			float deg = atanf(v.x / v.y) * 180 / M_PI;
+			if (ortho) {
+				int m1 = int(abs(deg)) % 90;
+				int m2 = 90 - int(abs(deg)) % 90;
+				return float(m1 < m2 ? m1 : m2);
+			} else {
+				return deg;
+			}
+		}
+	}
 	object TCL::enclosed_box(list<pdf_txt_bbox> const & words) {
 		pdf_txt_bbox ret_o;
 		pdf_txt_bbox * ret = &ret_o; //new pdf_txt_bbox;
@@ -2131,14 +2316,17 @@ proc preload_schem_pages { quality { threads 1 } } {
 						mouse_click_handled = true;
 						if (! ctrl) {
 							boardview()->m_partHighlighted.clear();
+							boardview()->HighlightsChanged();
 						}
-						boardview()->m_partHighlighted.push_back(*c_shptr);
+						boardview()->HighlightPart(*c_shptr);
+						boardview()->InvalidateLayers(kLayerMaskSelection);
 					}
 				}
 			}
 			if (mouse_release && ! mouse_click_handled) {
 				if (! ctrl) {
 					boardview()->m_partHighlighted.clear();
+					boardview()->HighlightsChanged();
 				}
 			}
 			{
@@ -2787,6 +2975,7 @@ proc preload_schem_pages { quality { threads 1 } } {
 		if (bg) {
 			schem_thread_joinable_ = true;
 			boardview()->sleep_mutex_unlock();
+			BoardView::wakeup();
 		}
 		default_schematic_ = &schematics_.back();
 		rollback = false;
@@ -21,6 +21,7 @@
 #include <tcl.h>
 #include <cpptcl/cpptcl.h>
 
+#include <algorithm>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -40,6 +41,7 @@
 #include <SDL.h>
 
 #include "BoardView.h"
+#include "FilterExpr.h"
 #include "platform.h"
 #include <regex>
 #include <atomic>
@@ -319,7 +321,7 @@ namespace OBV_Tcl {
 		obv_shared_ptr<BRDFile> current_draw_file_;
 		obv_shared_ptr<BRDBoard> current_draw_board_;
 
-		ImVec2 center(bbox const & b) {
+		static ImVec2 center(bbox const & b) {
 			return b.min + (b.max - b.min) / 2.0f;
 		}
 		float distance(bbox const & a, bbox const & b) {
@@ -336,6 +338,12 @@ namespace OBV_Tcl {
 		float distance_fun(getopt<bool> const & norm, getopt<bool> border, any<Component, Pin, pdf_txt_bbox> const & a, any<Component, Pin, pdf_txt_bbox> const & b);
 		static constexpr char const * angle_opt = "ortho decay";
 		float angle(getopt<bool> const & ortho, getopt<float> const & decay, any<pdf_txt_bbox, Pin> const & a, any<pdf_txt_bbox, Pin> const & b);
+		// what distance and angle work out between two points, for filter_schema() too
+		static float distance_between(ImVec2 a, ImVec2 b) {
+			ImVec2 d = a - b;
+			return sqrtf(d.x * d.x + d.y * d.y);
+		}
+		static float angle_between(ImVec2 a, ImVec2 b, bool ortho);
 		object enclosed_box(list<pdf_txt_bbox> const & words);
 #endif
 		
@@ -346,19 +354,19 @@ namespace OBV_Tcl {
 			return false;
 		}
 		
-		static constexpr const char * get_schem_words_opt = "page filter re ref sort not of exact color bbox radius nearest";
-		object get_schem_words(interpreter *, getopt<int> const & page, getopt<std::string> const & filter_arg, getopt<bool> const & use_regex, getopt<pdf_txt_bbox *> const & ref, getopt<std::string> const & sort, getopt<list<pdf_txt_bbox> > const & not_, getopt<any<list<Component> , list<Pin>, list<Net>, list<pdf_txt_bbox> > > const & of, getopt<std::string> const & exact, getopt<std::string> const & color, getopt<list<pdf_txt_bbox> > const & bbox, getopt<float> const & radius, getopt<int> const & nearest, variadic<std::string> const & match);
+		static constexpr const char * get_schem_words_opt = "page filter re ref sort not of exact color bbox radius nearest first";
+		object get_schem_words(interpreter *, getopt<int> const & page, getopt<std::string> const & filter_arg, getopt<bool> const & use_regex, getopt<pdf_txt_bbox *> const & ref, getopt<std::string> const & sort, getopt<list<pdf_txt_bbox> > const & not_, getopt<any<list<Component> , list<Pin>, list<Net>, list<pdf_txt_bbox> > > const & of, getopt<std::string> const & exact, getopt<std::string> const & color, getopt<list<pdf_txt_bbox> > const & bbox, getopt<float> const & radius, getopt<int> const & nearest, getopt<int> const & first, variadic<std::string> const & match);
 		static constexpr const char * get_nets_opt = "re all not gnd of filter";
 		object get_nets(interpreter *, getopt<bool> const & use_regex, getopt<bool> const & all, getopt<list<Net> > const & not_, getopt<bool> const & gnd, getopt<any<list<Component>, list<Pin>, list<Net>, list<BRDBoard> > > const & of, getopt<std::string> const & filter_arg, variadic<std::string> const & match);
-		static constexpr const char * get_pins_opt = "re all parallel filter via of notof not ref sort brief";
-		object get_pins(interpreter *, getopt<bool> const & use_regex, getopt<bool> const & all, getopt<bool> const & parallel, getopt<std::string> const & filter_arg, getopt<bool> const & via, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & of, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & notof, getopt<list<Pin> > const & not_, getopt<Pin *> const & ref, getopt<std::string> const & sort, getopt<bool> const & brief, variadic<std::string> const & match);
+		static constexpr const char * get_pins_opt = "re all parallel filter via of notof not ref sort brief first";
+		object get_pins(interpreter *, getopt<bool> const & use_regex, getopt<bool> const & all, getopt<bool> const & parallel, getopt<std::string> const & filter_arg, getopt<bool> const & via, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & of, getopt<any<list<Component>, list<Net>, list<Pin>, list<BRDBoard> > > const & notof, getopt<list<Pin> > const & not_, getopt<Pin *> const & ref, getopt<std::string> const & sort, getopt<bool> const & brief, getopt<int> const & first, variadic<std::string> const & match);
 		static constexpr const char * highlight_opt = "save toggle un all color colorindex intensity";
 		void highlight(getopt<bool> const & save, getopt<bool> const & toggle, getopt<bool> const & un, getopt<bool> const & all, getopt<std::string> const & color, getopt<int> const & colorindex, getopt<float> const & inten, opt<list<any<Component, Pin, pdf_txt_bbox> > > const & obj);
-		const char * get_cells_opt = "filter sort re of all top bottom not ref";
+		const char * get_cells_opt = "filter sort re of all top bottom not ref first";
 		object get_cells(interpreter *, getopt<std::string> const & filter_arg, getopt<std::string> const & sort, getopt<bool> const & use_regex, getopt<any<list<Component>, list<Net>, list<Pin>, list<pdf_txt_bbox> > > const & of, getopt<bool> const & all,
 						 getopt<bool> const & top,
 						 getopt<bool> const & bottom,
-						 getopt<list<Component> > const & not_, getopt<Component *> const & ref, variadic<std::string> const & match);
+						 getopt<list<Component> > const & not_, getopt<Component *> const & ref, getopt<int> const & first, variadic<std::string> const & match);
 		object get_schem_windows();
 
 		
@@ -371,6 +379,20 @@ namespace OBV_Tcl {
 		}
 		int generate_mark_ = 1;
 
+		// bench_coords ?-count n?: points per second through the batched and single point board to screen transform
+		static constexpr const char * bench_coords_opt = "count";
+		object bench_coords(getopt<int> const & count) {
+			double batched, single;
+			boardview()->BenchCoordToScreen(count ? std::max(*count, 1) : 1 << 20, batched, single);
+
+			object r;
+			r.append(object("batched"));
+			r.append(object(batched));
+			r.append(object("single"));
+			r.append(object(single));
+			return r;
+		}
+
 		struct prop_stack_item {
 			pdf_txt_bbox * word;
 			int saved_mark;
@@ -502,6 +524,12 @@ namespace OBV_Tcl {
 			return schem_word_get_prop_impl(varname, c, obj, nullptr);
 		}
 
+		// The properties filter expressions read natively, the same as the get_prop_impl functions give Tcl
+		static const FilterExpr::Schema & filter_schema(Component *);
+		static const FilterExpr::Schema & filter_schema(Net *);
+		static const FilterExpr::Schema & filter_schema(Pin *);
+		static const FilterExpr::Schema & filter_schema(pdf_txt_bbox *);
+
 		struct cmpeq_t {
 			bool write_;
 			cmpeq_t(bool w) : write_(w) { }
@@ -569,6 +597,18 @@ namespace OBV_Tcl {
 		static bool net_get_prop_impl(const char * prop, Net * n, object & ret, object * set, CMP icmp = cmpeq_t());
 		template <typename CMP=cmpeq_t>
 		static bool schematic_get_prop_impl(const char * prop, schematic * s, object & ret, object * set, CMP icmp = cmpeq_t());
+
+		// Aggregates behind some of the properties, from BoardStats when the element is on the board shown
+		static const PartStats * part_stats(Component * c);
+		static int part_pins(Component * c);
+		static int part_gnd_pins(Component * c);
+		static int part_nets(Component * c);
+		static const NetStats * net_stats(Net * n);
+		static int net_pins(Net * n);
+		static int net_parts(Net * n);
+		static int net_nodes(Net * n);
+		static uint8_t net_sides(Net * n);
+		static bool pin_is_pad(Pin * p);
 		
 		static char const ** cell_props_, ** pin_props_, ** net_props_, ** pdf_word_props_, ** schematic_props_;
 
@@ -741,6 +781,100 @@ namespace OBV_Tcl {
 			tcli->result_reset();
 			return res;
 		}
+
+		/*
+		 * -filter through FilterExpr when the expression is one it handles.
+		 * try_append queues its candidates instead of filtering them one at
+		 * a time, the expression is run over all of them in one go, then
+		 * they're handed back to try_append in the order they came, so the
+		 * rest of its checks and the order of the result are as before.
+		 * What FilterExpr leaves undecided is still asked of Tcl.
+		 */
+		template <typename OT, typename X = void *>
+		struct native_filter {
+			FilterExpr expr_;
+			OT * ref_;
+			std::vector<std::pair<OT *, X> > queued_;
+			std::vector<uint8_t> pass_; // 0, 1, or 2 for undecided
+			std::size_t at_ = 0;
+			bool replaying_ = false;
+
+			native_filter(getopt<std::string> const & filter_arg, OT * ref = nullptr) : ref_(ref) {
+				if (filter_arg) {
+					expr_.Compile(*filter_arg, filter_schema((OT *) nullptr), { { "_", nullptr }, { ref ? "r" : nullptr, ref ? "r_" : nullptr } }, 0);
+				}
+			}
+
+			// True when p got queued, try_append is done with it until replay()
+			bool queue(OT * p, X x = X()) {
+				if (! expr_.Compiled() || replaying_) return false;
+				queued_.emplace_back(p, x);
+				return true;
+			}
+
+			// The filter's verdict for the candidate being handed back, tcl() when there's none
+			template <typename Fn>
+			bool match(Fn tcl) {
+				if (! replaying_ || pass_[at_] == 2) return tcl();
+				return pass_[at_];
+			}
+
+			template <typename Fn>
+			void replay(Fn append) {
+				if (! expr_.Compiled()) return;
+
+				std::vector<const void *> items(queued_.size());
+				for (std::size_t i = 0; i < queued_.size(); ++i) items[i] = queued_[i].first;
+				const void * fixed[2] = { nullptr, ref_ };
+				std::vector<double> value(items.size());
+				std::vector<uint8_t> decided(items.size());
+				expr_.Run(items.data(), items.size(), 0, fixed, value.data(), decided.data());
+
+				pass_.resize(items.size());
+				for (std::size_t i = 0; i < items.size(); ++i) pass_[i] = decided[i] ? value[i] != 0 : 2;
+
+				replaying_ = true;
+				for (at_ = 0; at_ < queued_.size(); ++at_) {
+					append(queued_[at_].first, queued_[at_].second);
+				}
+				replaying_ = false;
+				queued_.clear();
+			}
+		};
+
+		/*
+		 * -sort { K($a) < K($b) } with a key K FilterExpr handles, such as
+		 * [distance $a $r] or $a_pins: K is worked out once per element and
+		 * v put in key order, instead of a Tcl eval per comparison.  Only
+		 * the first `first` are kept, partial_sort'ed, when that's fewer.
+		 * False (v untouched) when sort isn't of that form or a key needs
+		 * Tcl, sort_less does it then.
+		 */
+		template <typename OT, typename E, typename Get>
+		static bool native_sort(std::string const & sort, OT * ref, std::vector<E> & v, Get get, std::size_t first) {
+			FilterExpr key;
+			bool descending;
+			if (! key.CompileKey(sort, filter_schema((OT *) nullptr), { { "a", "a_" }, { "b", "b_" }, { ref ? "r" : nullptr, ref ? "r_" : nullptr } }, 0, 1, descending)) {
+				return false;
+			}
+
+			std::vector<const void *> items(v.size());
+			for (std::size_t i = 0; i < v.size(); ++i) items[i] = get(v[i]);
+			const void * fixed[3] = { nullptr, nullptr, ref };
+			std::vector<double> keys(v.size());
+			std::vector<uint8_t> decided(v.size());
+			key.Run(items.data(), items.size(), 0, fixed, keys.data(), decided.data());
+			if (std::find(decided.begin(), decided.end(), 0) != decided.end()) return false;
+
+			std::vector<uint32_t> order;
+			FilterExpr::Order(keys.data(), keys.size(), descending, first, order);
+			std::vector<E> sorted;
+			sorted.reserve(order.size());
+			for (uint32_t i : order) sorted.push_back(v[i]);
+			v.swap(sorted);
+			return true;
+		}
+
 		static bool is_dummy(Component * c) {
 			return c->component_type == Component::kComponentTypeDummy;
 		}
@@ -792,7 +926,9 @@ namespace OBV_Tcl {
 			return t.tv_sec * 1000 + t.tv_usec / 1000;
 		}
 
-		void highlight_delay_poll() {
+		// Returns whether it changed a highlight
+		bool highlight_delay_poll() {
+			bool ret = false;
 			if (highlight_delay_enable_ && ! highlight_delay_.empty()) {
 				uint64_t now = time_ms();
 				if (highlight_delay_time_ + 30 < now) {
@@ -800,10 +936,19 @@ namespace OBV_Tcl {
 					if (d.c->shade_color_ != d.shade) {
 						d.c->shade_color_ = d.shade;
 						highlight_delay_time_ = now;
+						boardview()->InvalidateStyle(d.c);
+						boardview()->InvalidateLayers(kLayerMaskSelection);
+						ret = true;
 					}
 					highlight_delay_.pop_front();
 				}
 			}
+			return ret;
+		}
+
+		// Frames only come when something happens, these need them to go on until the queue is empty
+		bool highlight_delay_pending() const {
+			return highlight_delay_enable_ && ! highlight_delay_.empty();
 		}
 
 		object dup(object const & o) {
@@ -1030,11 +1175,8 @@ namespace OBV_Tcl {
 		//std::map<int, pdf_words_value_t> pdf_words_;
 
 		std::optional<obv_shared_ptr<Component> > lookup(Component * c) {
-			if (c) {
-				for (auto && ci : boardview()->m_board->Components()) {
-					if (ci.get() == c) return ci;
-				}
-			}
+			int id = c ? boardview()->m_registry.PartId(c) : -1;
+			if (id >= 0) return boardview()->m_board->Components()[id];
 			return { };
 		}
 
@@ -1280,6 +1422,7 @@ namespace OBV_Tcl {
 
 		static void rl_cb(char * line) {
 			if (! line) {
+				this_s_->stdin_eof_ = true;
 				this_s_->eval("exit");
 				free(line);
 				this_s_->farewell_newline_ = true;
@@ -1303,6 +1446,7 @@ namespace OBV_Tcl {
 				std::string sline(line);
 				object oline(sline);
 				auto res = this_s_->eval_impl(oline);
+				this_s_->stdin_evaluated_ = true;
 				if (res.ok) {
 					if (truncate && res.is_object_vector && res.str.size() > 256) {
 						std::cerr << res.str.substr(0, 255) << " ...\n";
@@ -1376,12 +1520,24 @@ namespace OBV_Tcl {
 			return { false, false, "" };
 		}
 
+		/*
+		 * The console reads as ready for good once it got to its end (say
+		 * /dev/null when started from a desktop), it's left alone then.
+		 */
+		bool stdin_eof_ = false;
+		bool stdin_evaluated_ = false;
+
+		bool stdin_eof() const {
+			return stdin_eof_;
+		}
+
+		// Runs what came in on the console and the wakeup pipe; returns whether any of it may have changed the picture
 		bool pollfd(int sleep) {
 			if (*done_) return false;
 			bool ret = false;
 			fd_set fd_r;
 			FD_ZERO(&fd_r);
-			FD_SET(0, &fd_r);
+			if (! stdin_eof_) FD_SET(0, &fd_r);
 			int maxfd = 1;
 			{
 				int fd = BoardView::m_wakeup_pipe[0];
@@ -1414,18 +1570,24 @@ namespace OBV_Tcl {
 #ifndef HAVE_READLINE
 					char buf[1024];
 					
-					fgets(buf, sizeof(buf), stdin);
-					//std::cerr << "cmd: " << buf;
-					auto res = eval(buf);
-					if (res.ok) {
-						if (res.is_object_vector && res.str.size() > 256) {
-							std::cerr << res.str.substr(0, 255) << " ...\n";
-						} else {
-							std::cerr << res.str << (res.str.size() ? "\n" : "");
+					if (fgets(buf, sizeof(buf), stdin)) {
+						//std::cerr << "cmd: " << buf;
+						auto res = eval(buf);
+						if (res.ok) {
+							if (res.is_object_vector && res.str.size() > 256) {
+								std::cerr << res.str.substr(0, 255) << " ...\n";
+							} else {
+								std::cerr << res.str << (res.str.size() ? "\n" : "");
+							}
 						}
+						ret = true;
+					} else {
+						stdin_eof_ = true;
 					}
 #else
 					rl_callback_read_char();
+					ret = stdin_evaluated_;
+					stdin_evaluated_ = false;
 #endif
 				} else if (FD_ISSET(BoardView::m_wakeup_pipe[0], &fd_r)) {
 					char buf[1024];
@@ -1433,7 +1595,7 @@ namespace OBV_Tcl {
 					ret = true;
 				}
 			}
-			highlight_delay_poll();
+			if (highlight_delay_poll()) ret = true;
 			return ret;
 		}
 	};
@@ -0,0 +1,63 @@
+#include "ViewTransform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VIEWTRANSFORM_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VIEWTRANSFORM_NEON
+#endif
+
+/*
+ * ImVec2 is two packed floats, so a 4 wide register holds two points
+ * (x0 y0 x1 y1).  Splatting the xs and the ys across their pair of lanes
+ * turns the whole transform into two multiplies and two adds per pair.
+ */
+void ViewTransform::Apply(const ImVec2 *in, ImVec2 *out, size_t n) const {
+	size_t i = 0;
+
+#if defined(VIEWTRANSFORM_SSE2)
+	__m128 mx = _mm_setr_ps(xx, yx, xx, yx);
+	__m128 my = _mm_setr_ps(xy, yy, xy, yy);
+	__m128 mt = _mm_setr_ps(tx, ty, tx, ty);
+
+	for (; i + 2 <= n; i += 2) {
+		__m128 v  = _mm_loadu_ps(&in[i].x);
+		__m128 vx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 vy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+		_mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, mx), _mm_mul_ps(vy, my)), mt));
+	}
+#elif defined(VIEWTRANSFORM_NEON)
+	const float cx[4] = {xx, yx, xx, yx};
+	const float cy[4] = {xy, yy, xy, yy};
+	const float ct[4] = {tx, ty, tx, ty};
+	float32x4_t mx    = vld1q_f32(cx);
+	float32x4_t my    = vld1q_f32(cy);
+	float32x4_t mt    = vld1q_f32(ct);
+
+	for (; i + 2 <= n; i += 2) {
+		float32x4_t v  = vld1q_f32(&in[i].x);
+		float32x4_t vx = vtrn1q_f32(v, v);
+		float32x4_t vy = vtrn2q_f32(v, v);
+		vst1q_f32(&out[i].x, vmlaq_f32(vmlaq_f32(mt, vx, mx), vy, my));
+	}
+#endif
+
+	for (; i < n; i++) out[i] = Apply(in[i]);
+}
+
+ViewTransform ViewTransform::Inverse() const {
+	ViewTransform r;
+	float det = xx * yy - xy * yx;
+
+	if (det == 0.0f) return r;
+
+	float inv = 1.0f / det;
+	r.xx      = yy * inv;
+	r.xy      = -xy * inv;
+	r.yx      = -yx * inv;
+	r.yy      = xx * inv;
+	r.tx      = -(r.xx * tx + r.xy * ty);
+	r.ty      = -(r.yx * tx + r.yy * ty);
+	return r;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <cstddef>
+
+/*
+ * Board to screen mapping as a single affine transform,
+ *
+ *   screen.x = xx * x + xy * y + tx
+ *   screen.y = yx * x + yy * y + ty
+ *
+ * with the side flip, the rotation, the scale and the pan of the view all
+ * folded into the six coefficients (see BoardView::CoordTransform()), so
+ * transforming a point is two multiply-adds per axis and no branches.
+ */
+struct ViewTransform {
+	float xx = 1.0f, xy = 0.0f;
+	float yx = 0.0f, yy = 1.0f;
+	float tx = 0.0f, ty = 0.0f;
+
+	ImVec2 Apply(ImVec2 p) const {
+		return ImVec2(xx * p.x + xy * p.y + tx, yx * p.x + yy * p.y + ty);
+	}
+
+	// Transforms n points, two at a time with SSE2/NEON where available; in and out may be the same array
+	void Apply(const ImVec2 *in, ImVec2 *out, size_t n) const;
+
+	ViewTransform Inverse() const;
+};
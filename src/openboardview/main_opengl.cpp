@@ -13,6 +13,7 @@
 #include "version.h"
 
 #include "BoardView.h"
+#include "FrameScheduler.h"
 #include "history.h"
 
 #include "TCL.h"
@@ -209,7 +210,6 @@ void cleanupAndExit(int c) {
 }
 
 int main(int argc, char **argv) {
-	uint8_t sleepout;
 	std::string configDir;
 	globals g; // because some things we have to store *before* we load the config file in BoardView app.obvconf
 	BoardView app{};
@@ -354,23 +354,6 @@ int main(int argc, char **argv) {
 		preload_required = true;
 	}
 
-	/*
-	 * The sleepout var keeps track of how many iterations of the main loop
-	 * are left, without an event having happened before OBV will start to sleep
-	 * and continue without redrawing the page.
-	 *
-	 * The reason we don't just sleep immediately after a non-event is because
-	 * sometimes there are internal things that still need to be done on the next
-	 * render (such as responding to a mouse click
-	 *
-	 * For now we've got this set to 3 frames which seems to work okay with OBV.
-	 * If you find some things aren't working properly without you having to move
-	 * the mouse or 'waking up' OBV then increase to 5 or more.
-	 */
-	const int snooze = 30;
-	sleepout = snooze;
-	bool wakeup = false;
-
 	bool tcl_available = false;
 	{
 		//std::cerr << 0;
@@ -398,12 +381,30 @@ int main(int argc, char **argv) {
 			app.set_tcl(tcl.get());
 		}
 		app.sdl_window(window);
-		
+
+		/*
+		 * Frames are only drawn when something changed, see FrameScheduler.
+		 * The console and the wakeup pipe are what the Tcl side waits on.
+		 */
+		FrameScheduler scheduler;
+		if (tcl) {
+			if (BoardView::m_wakeup_pipe[0] < 0) BoardView::wakeup();
+			scheduler.Watch({0, BoardView::m_wakeup_pipe[0]});
+		}
+		app.m_inputLatency  = &scheduler.Latency(FrameScheduler::kLatencyInput);
+		app.m_motionLatency = &scheduler.Latency(FrameScheduler::kLatencyMotion);
+		app.m_searchWorker.SetNotify([&scheduler] { scheduler.Wake(); });
+
 		while (!done) {
-			
+			// background threads get the board while we sleep
+			app.sleep_mutex_unlock();
+			scheduler.Wait();
+			app.sleep_mutex_lock();
+
 			SDL_Event event;
 			while (SDL_PollEvent(&event)) {
-				sleepout = snooze;
+				if (scheduler.IsWakeup(event)) continue;
+				scheduler.Event(event);
 				Renderers::current->processEvent(event);
 				
 #ifdef SDL_DROPFILE
@@ -421,28 +422,18 @@ int main(int argc, char **argv) {
 				app.obvconfig.Load(configDir + "obv.conf");
 				app.ConfigParse();
 				clear_color = ImColor(app.m_colors.backgroundColor);
+				scheduler.Damage();
 			}
 			
 			if (tcl) {
-				wakeup = tcl->pollfd(!sleepout ? 50000 : 0);
-				if (wakeup) {
-					sleepout = snooze;
-				}
-				if (!(sleepout--)) {
-					sleepout = 0;
-					continue;
-				}
-			} else {
-				if (!(sleepout--)) {
-#ifdef _WIN32
-					Sleep(50);
-#else
-					usleep(50000);
-#endif
-					sleepout = 0;
-					continue;
-				}
-			} // puts OBV to sleep if nothing is happening.
+				if (tcl->pollfd(0)) scheduler.Damage();
+				if (tcl->stdin_eof()) scheduler.Unwatch(0);
+				scheduler.Serviced();
+			}
+
+			if (preload_required) scheduler.Damage();
+			if (!scheduler.Due()) continue;
+
 			// Prepare frame
 			
 			Renderers::current->initFrame();
@@ -476,17 +467,10 @@ int main(int argc, char **argv) {
 			ImGui::Render();
 			Renderers::current->renderFrame(clear_color);
 			
-			// vsync disabled, manual FPS limiting
-			if (!SDL_GL_GetSwapInterval()) {
-				static const int FPS = 30;
-				//static const std::chrono::duration<std::intmax_t, std::ratio<1, FPS>> frameDuration{1};
-				static const std::chrono::duration<int, std::ratio<1, FPS>> frameDuration{1};
-				static auto nextFrame = std::chrono::steady_clock::now() + frameDuration;
-				
-				std::this_thread::sleep_until(nextFrame);
-				nextFrame += frameDuration;
-			}
+			scheduler.Presented();
+			if (app.WantsFrame() || (tcl && tcl->highlight_delay_pending())) scheduler.Continue();
 		}
+		app.m_searchWorker.SetNotify(nullptr);
 	}		
 	// Cleanup
 	Renderers::current->shutdown();
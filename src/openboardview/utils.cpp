@@ -65,6 +65,28 @@ bool compare_string_insensitive(const std::string &str1, const std::string &str2
 		   });
 }
 
+// Key for sorting names naturally (C2 before C10, case insensitive) with a plain string compare
+std::string natural_sort_key(const std::string &str) {
+	std::string key;
+	key.reserve(str.size() + 4);
+	for (size_t i = 0; i < str.size();) {
+		if (!std::isdigit((unsigned char)str[i])) {
+			key += std::tolower((unsigned char)str[i++]);
+			continue;
+		}
+
+		// a number sorts before letters like a digit would, then by length without leading zeros, then digit by digit
+		while (i + 1 < str.size() && str[i] == '0' && std::isdigit((unsigned char)str[i + 1])) i++;
+		size_t end = i;
+		while (end < str.size() && std::isdigit((unsigned char)str[end])) end++;
+		key += '0';
+		key += char(std::min<size_t>(end - i, 255));
+		key.append(str, i, end - i);
+		i = end;
+	}
+	return key;
+}
+
 // Case insensitive lookup of a filename at the given path
 filesystem::path lookup_file_insensitive(const filesystem::path &path, const std::string &filename) {
 	for(auto& p: filesystem::directory_iterator(path)) {
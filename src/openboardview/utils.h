@@ -22,6 +22,9 @@ bool find_str_in_buf(const std::string str, const std::vector<char> &buf);
 // Case insensitive comparison of std::string
 bool compare_string_insensitive(const std::string &str1, const std::string &str2);
 
+// Key for sorting names naturally (C2 before C10, case insensitive) with a plain string compare
+std::string natural_sort_key(const std::string &str);
+
 // Case insensitive lookup of a filename at the given path
 filesystem::path lookup_file_insensitive(const filesystem::path &path, const std::string &filename);
 